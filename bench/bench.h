@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+/*** benchmark harness ***/
+
+struct benchOptions {
+  double scale;
+  long long logmb;
+  int repeat;
+  const char *only;
+  const char *dir;
+};
+
+extern struct benchOptions benchOpt;
+
+/* Results of measured loops are stored here so they are not optimised
+ * away. */
+extern volatile unsigned long benchSink;
+
+/* A synthetic corpus, written to file under benchOpt.dir: mb MiB of
+ * whatever generate produces, times benchOpt.scale. Results are tagged
+ * with name. */
+struct benchCorpus {
+  const char *name;
+  const char *file;
+  double mb;
+  void (*generate)(FILE *fp, long long bytes, uint64_t *rng);
+};
+
+extern const struct benchCorpus benchCorpora[];
+extern const int benchNumCorpora;
+
+struct benchMetric {
+  const char *key;
+  double value;
+};
+
+/* xorshift64*: corpora and edit sequences must come out the same on every
+ * machine and C library, which std::rand does not promise. */
+inline uint64_t benchRand(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545f4914f6cdd1dULL;
+}
+
+inline double benchSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+/* Runs fn, which returns how many seconds its measured part took,
+ * benchOpt.repeat times. Returns the fastest run and stores the median in
+ * *median. */
+template <typename F>
+double benchBest(F fn, double *median) {
+  std::vector<double> times;
+  for (int i = 0; i < benchOpt.repeat; i++) times.push_back(fn());
+  std::sort(times.begin(), times.end());
+  *median = times[times.size() / 2];
+  return times[0];
+}
+
+int benchWanted(const char *name, const char *corpus);
+void benchReport(const char *name, const char *corpus,
+                 std::initializer_list<benchMetric> metrics);
+long benchResidentBytes();
+std::string benchCorpusPath(const struct benchCorpus *c);
+long long benchGenerate(const struct benchCorpus *c);
+
+/*** benchmarks ***/
+
+void benchRows();
+void benchEdit(const struct benchCorpus *c);
+void benchFile(const struct benchCorpus *c);
+void benchScan(const struct benchCorpus *c);
+void benchFrame(const struct benchCorpus *c);
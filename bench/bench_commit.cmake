@@ -0,0 +1,24 @@
+# Writes OUTPUT, a header defining BENCH_COMMIT as the commit SOURCE_DIR
+# is checked out at. Run on every build; the header is only rewritten
+# when the commit changed, so an unchanged tree rebuilds nothing.
+set(commit unknown)
+if(GIT_EXECUTABLE)
+    execute_process(
+        COMMAND ${GIT_EXECUTABLE} rev-parse --short HEAD
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE head
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        ERROR_QUIET)
+    if(head)
+        set(commit ${head})
+    endif()
+endif()
+
+set(content "#define BENCH_COMMIT \"${commit}\"\n")
+set(old "")
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} old)
+endif()
+if(NOT old STREQUAL content)
+    file(WRITE ${OUTPUT} "${content}")
+endif()
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "LineIndex.h"
+#include "bench.h"
+
+/* Opening the corpus by scanning it, opening it again through its
+ * sidecar index, and saving it. */
+void benchFile(const struct benchCorpus *c) {
+  std::string path = benchCorpusPath(c);
+  double mb = 0;
+  double median;
+
+  if (benchWanted("open", c->name)) {
+    setenv("BYTE_WRITER_NO_CACHE", "1", 1);
+    double best = benchBest([&] {
+      auto t0 = std::chrono::steady_clock::now();
+      editorOpen(path.c_str());
+      double secs = benchSince(t0);
+      mb = editorDocumentSize() / 1048576.0;
+      editorCloseFile();
+      return secs;
+    }, &median);
+    unsetenv("BYTE_WRITER_NO_CACHE");
+    benchReport("open", c->name, {{"mb_s", mb / best},
+                                  {"seconds", best},
+                                  {"median_s", median}});
+  }
+
+  /* The first open without the variable writes the index. */
+  editorOpen(path.c_str());
+  mb = editorDocumentSize() / 1048576.0;
+  int rows = E.numrows;
+  editorCloseFile();
+
+  if (benchWanted("open_indexed", c->name)) {
+    double best = benchBest([&] {
+      auto t0 = std::chrono::steady_clock::now();
+      editorOpen(path.c_str());
+      double secs = benchSince(t0);
+      editorCloseFile();
+      return secs;
+    }, &median);
+    benchReport("open_indexed", c->name, {{"mb_s", mb / best},
+                                          {"seconds", best},
+                                          {"median_s", median},
+                                          {"rows", (double)rows}});
+  }
+
+  if (benchWanted("save", c->name)) {
+    editorOpen(path.c_str());
+    double best = benchBest([] {
+      E.dirty = 1;
+      auto t0 = std::chrono::steady_clock::now();
+      editorSave();
+      return benchSince(t0);
+    }, &median);
+    benchReport("save", c->name, {{"mb_s", mb / best},
+                                  {"seconds", best},
+                                  {"median_s", median}});
+    editorCloseFile();
+  }
+}
@@ -0,0 +1,47 @@
+#include <chrono>
+#include <cstdlib>
+
+#include "Buffer.h"
+#include "Editor.h"
+#include "bench.h"
+
+/* Building screen updates (without writing them) with the cursor at
+ * evenly spaced rows, which scrolls every frame. */
+static double benchFrames(int frames) {
+  auto t0 = std::chrono::steady_clock::now();
+  unsigned long bytes = 0;
+  for (int i = 0; i < frames; i++) {
+    E.cy = (long long)E.numrows * i / frames;
+    E.cx = 0;
+    struct abuf ab = ABUF_INIT;
+    editorDrawFrame(&ab);
+    bytes += ab.len;
+    abFree(&ab);
+  }
+  benchSink = bytes;
+  return benchSince(t0);
+}
+
+void benchFrame(const struct benchCorpus *c) {
+  const int frames = 200;
+  double median;
+
+  if (benchWanted("frame", c->name)) {
+    double best = benchBest([&] { return benchFrames(frames); }, &median);
+    benchReport("frame", c->name, {{"ms_per_frame", best / frames * 1e3},
+                                   {"median_ms_per_frame", median / frames * 1e3}});
+  }
+
+  if (benchWanted("frame_wrap", c->name)) {
+    auto t0 = std::chrono::steady_clock::now();
+    editorToggleWrap();
+    double build = benchSince(t0);
+    double best = benchBest([&] { return benchFrames(frames); }, &median);
+    editorToggleWrap();
+    benchReport("frame_wrap", c->name,
+                {{"ms_per_frame", best / frames * 1e3},
+                 {"median_ms_per_frame", median / frames * 1e3},
+                 {"layout_s", build}});
+  }
+  E.cy = E.cx = 0;
+}
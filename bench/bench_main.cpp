@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "bench.h"
+#include "bench_commit.h"
+
+struct benchOptions benchOpt = {1.0, 0, 3, NULL, NULL};
+volatile unsigned long benchSink;
+
+static int reported = 0;
+
+/* Whether any comma-separated item of --only names the bench or the
+ * corpus (NULL for benches that make their own data). */
+int benchWanted(const char *name, const char *corpus) {
+  if (benchOpt.only == NULL) return 1;
+  std::string only = std::string(",") + benchOpt.only + ",";
+  if (only.find("," + std::string(name) + ",") != std::string::npos) return 1;
+  return corpus && only.find("," + std::string(corpus) + ",") != std::string::npos;
+}
+
+void benchReport(const char *name, const char *corpus,
+                 std::initializer_list<benchMetric> metrics) {
+  printf("%s\n    {\"bench\": \"%s\", \"corpus\": \"%s\"",
+         reported++ ? "," : "", name, corpus ? corpus : "");
+  for (const benchMetric &m : metrics) printf(", \"%s\": %.6g", m.key, m.value);
+  printf("}");
+  fflush(stdout);
+  fprintf(stderr, "  %-14s %-6s", name, corpus ? corpus : "");
+  for (const benchMetric &m : metrics) fprintf(stderr, " %s=%.4g", m.key, m.value);
+  fprintf(stderr, "\n");
+}
+
+/* Resident set size in bytes, from /proc/self/statm. */
+long benchResidentBytes() {
+  long pages = 0, resident = 0;
+  FILE *fp = fopen("/proc/self/statm", "r");
+  if (!fp) return 0;
+  if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) resident = 0;
+  fclose(fp);
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: byte-writer-bench [--scale F] [--log-mb N] [--repeat N]\n"
+    "                         [--only NAME,...] [--dir DIR] [--label TEXT]\n"
+    "Writes synthetic corpora to DIR (a fresh temporary directory by\n"
+    "default), runs the benchmarks on them and prints the results as JSON.\n"
+    "--only keeps the benchmarks or corpora named; --log-mb sets the size\n"
+    "of the log corpus, which --scale leaves alone when it is given.\n");
+  exit(2);
+}
+
+int main(int argc, char *argv[]) {
+  const char *label = "";
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    if (strcmp(argv[i], "--scale") == 0) benchOpt.scale = atof(argv[++i]);
+    else if (strcmp(argv[i], "--log-mb") == 0) benchOpt.logmb = atoll(argv[++i]);
+    else if (strcmp(argv[i], "--repeat") == 0) benchOpt.repeat = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--only") == 0) benchOpt.only = argv[++i];
+    else if (strcmp(argv[i], "--dir") == 0) benchOpt.dir = argv[++i];
+    else if (strcmp(argv[i], "--label") == 0) label = argv[++i];
+    else usage();
+  }
+  if (benchOpt.scale <= 0 || benchOpt.repeat < 1) usage();
+
+  char tmp[] = "/tmp/bw-bench-XXXXXX";
+  if (benchOpt.dir == NULL) {
+    if (mkdtemp(tmp) == NULL) {
+      perror("mkdtemp");
+      return 1;
+    }
+    benchOpt.dir = tmp;
+  }
+  /* Keep sidecar indexes with the corpora rather than in the user's cache. */
+  std::string cache = std::string(benchOpt.dir) + "/cache";
+  setenv("XDG_CACHE_HOME", cache.c_str(), 1);
+
+  initEditorState();
+  E.screenrows = 48;
+  E.screencols = 160;
+
+  printf("{\n  \"commit\": \"%s\",\n  \"label\": \"%s\",\n  \"scale\": %g,\n"
+         "  \"repeat\": %d,\n  \"results\": [",
+         BENCH_COMMIT, label, benchOpt.scale, benchOpt.repeat);
+
+  if (benchWanted("rows", NULL)) benchRows();
+
+  static const char *perCorpus[] = {"open", "open_indexed", "prepare", "syntax",
+                                    "search", "frame", "frame_wrap",
+                                    "row_edit", "row_split_join", "save"};
+  for (int i = 0; i < benchNumCorpora; i++) {
+    const struct benchCorpus *c = &benchCorpora[i];
+    int wanted = 0;
+    for (const char *name : perCorpus) wanted |= benchWanted(name, c->name);
+    if (!wanted) continue;
+
+    fprintf(stderr, "%s: generating\n", c->name);
+    long long size = benchGenerate(c);
+    fprintf(stderr, "%s: %.1f MiB\n", c->name, size / 1048576.0);
+
+    benchFile(c);
+    editorOpen(benchCorpusPath(c).c_str());
+    benchScan(c);
+    benchFrame(c);
+    benchEdit(c);
+    editorCloseFile();
+    unlink(benchCorpusPath(c).c_str());
+  }
+  printf("\n  ]\n}\n");
+
+  if (benchOpt.dir == tmp) {
+    std::string cmd = std::string("rm -rf ") + tmp;
+    if (system(cmd.c_str()) != 0) fprintf(stderr, "could not remove %s\n", tmp);
+  }
+  return 0;
+}
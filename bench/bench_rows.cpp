@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "Row.h"
+#include "bench.h"
+
+/* Memory per row and the cost of inserting and reading back a million
+ * rows of source-like lengths. */
+void benchRows() {
+  int lines = 1000000 * benchOpt.scale;
+
+  /* Source-like line lengths: a fair share of blank and short lines. */
+  const char *lengths = "\x00\x04\x0c\x18\x1c\x24\x2c\x30\x38\x48";
+  std::string text(128, 'x');
+
+  long rss0 = benchResidentBytes();
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < lines; i++)
+    editorInsertRow(E.numrows, text.data(), lengths[i % 10]);
+  double load = benchSince(t0);
+  long rss1 = benchResidentBytes();
+
+  double median;
+  double scan = benchBest([] {
+    auto t0 = std::chrono::steady_clock::now();
+    unsigned long sum = 0;
+    for (int i = 0; i < E.numrows; i++) {
+      const char *chars = editorRowChars(&E.row[i]);
+      for (int j = 0; j < E.row[i].size; j++) sum += chars[j];
+    }
+    benchSink = sum;
+    return benchSince(t0);
+  }, &median);
+
+  benchReport("rows", NULL, {{"lines", (double)lines},
+                             {"bytes_per_line", (double)(rss1 - rss0) / lines},
+                             {"load_s", load},
+                             {"scan_s", scan},
+                             {"scan_median_s", median}});
+  editorCloseFile();
+}
+
+/* Keystroke-sized edits and row splits at random places in the open
+ * corpus, through the row operations. */
+void benchEdit(const struct benchCorpus *c) {
+  if (E.numrows == 0) return;
+
+  if (benchWanted("row_edit", c->name)) {
+    const int ops = 100000;
+    uint64_t rng = 0x2545f4914f6cdd1dULL;
+    double median;
+    double best = benchBest([&] {
+      auto t0 = std::chrono::steady_clock::now();
+      for (int i = 0; i < ops; i++) {
+        erow *row = &E.row[benchRand(&rng) % E.numrows];
+        int at = benchRand(&rng) % (row->size + 1);
+        if (at < row->size && benchRand(&rng) % 2) editorRowDelChar(row, at);
+        else editorRowInsertChar(row, at, 'a' + benchRand(&rng) % 26);
+      }
+      return benchSince(t0);
+    }, &median);
+    benchReport("row_edit", c->name, {{"us_per_op", best / ops * 1e6},
+                                      {"median_us_per_op", median / ops * 1e6}});
+  }
+
+  if (benchWanted("row_split_join", c->name)) {
+    const int ops = 1000;
+    uint64_t rng = 0x853c49e6748fea9bULL;
+    double median;
+    double best = benchBest([&] {
+      auto t0 = std::chrono::steady_clock::now();
+      for (int i = 0; i < ops; i++) {
+        int at = benchRand(&rng) % E.numrows;
+        erow *row = &E.row[at];
+        int cut = row->size / 2;
+        editorInsertRow(at + 1, editorRowChars(row) + cut, row->size - cut);
+        editorRowTruncate(&E.row[at], cut);
+
+        row = &E.row[at];
+        erow *next = &E.row[at + 1];
+        editorRowAppendString(row, editorRowChars(next), next->size);
+        editorDelRow(at + 1);
+      }
+      return benchSince(t0);
+    }, &median);
+    benchReport("row_split_join", c->name,
+                {{"us_per_op", best / ops * 1e6},
+                 {"median_us_per_op", median / ops * 1e6}});
+  }
+}
@@ -0,0 +1,63 @@
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "LineIndex.h"
+#include "Row.h"
+#include "Search.h"
+#include "Syntax.h"
+#include "bench.h"
+
+/* Preparing every row of a freshly opened corpus (rendering and first
+ * highlighting), highlighting them again, and searching the text for a
+ * string that is not there. Leaves every row prepared. */
+void benchScan(const struct benchCorpus *c) {
+  std::string path = benchCorpusPath(c);
+  double mb = editorDocumentSize() / 1048576.0;
+  double median;
+
+  if (benchWanted("prepare", c->name)) {
+    double best = benchBest([&] {
+      editorCloseFile();
+      editorOpen(path.c_str());
+      auto t0 = std::chrono::steady_clock::now();
+      editorPrepareRows(E.numrows);
+      return benchSince(t0);
+    }, &median);
+    benchReport("prepare", c->name, {{"mb_s", mb / best},
+                                     {"seconds", best},
+                                     {"median_s", median}});
+  }
+  editorPrepareRows(E.numrows);
+
+  if (benchWanted("syntax", c->name) && E.syntax) {
+    double best = benchBest([] {
+      auto t0 = std::chrono::steady_clock::now();
+      for (int i = 0; i < E.numrows; i++) editorHighlightRow(&E.row[i]);
+      return benchSince(t0);
+    }, &median);
+    benchReport("syntax", c->name, {{"mb_s", mb / best},
+                                    {"seconds", best},
+                                    {"median_s", median}});
+  }
+
+  if (benchWanted("search", c->name)) {
+    const char *needle = "zq_absent_needle";
+    size_t len = strlen(needle);
+    double best = benchBest([&] {
+      auto t0 = std::chrono::steady_clock::now();
+      unsigned long hits = 0;
+      for (int i = 0; i < E.numrows; i++) {
+        erow *row = &E.row[i];
+        hits += searchFind(editorRowChars(row), row->size, needle, len) != NULL;
+      }
+      benchSink = hits;
+      return benchSince(t0);
+    }, &median);
+    benchReport("search", c->name, {{"mb_s", mb / best},
+                                    {"seconds", best},
+                                    {"median_s", median}});
+  }
+}
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+"""Compares two byte-writer-bench result files.
+
+usage: compare.py OLD.json NEW.json
+
+Prints every metric found in both, with the change from OLD to NEW and,
+if it is 1% or more, whether it is an improvement: throughputs (mb_s)
+should go up, times should go down. Counts that only describe the corpus
+are left out.
+"""
+
+import json
+import sys
+
+DESCRIPTIVE = {"lines", "rows"}
+
+
+def load(path):
+    with open(path) as f:
+        doc = json.load(f)
+    return doc, {(r["bench"], r["corpus"]): r for r in doc["results"]}
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__.strip())
+    old_doc, old = load(sys.argv[1])
+    new_doc, new = load(sys.argv[2])
+    print("%s -> %s" % (old_doc.get("label") or old_doc["commit"],
+                        new_doc.get("label") or new_doc["commit"]))
+
+    for key in sorted(old.keys() & new.keys()):
+        for metric, before in old[key].items():
+            after = new[key].get(metric)
+            if (metric in ("bench", "corpus") or metric in DESCRIPTIVE or
+                    not isinstance(after, (int, float)) or before == 0):
+                continue
+            change = (after - before) / before * 100
+            better = change > 0 if metric.endswith("mb_s") else change < 0
+            verdict = "" if abs(change) < 1 else "better" if better else "worse"
+            print("%-15s %-5s %-20s %12.4g %12.4g %+7.1f%% %s" % (
+                key[0], key[1], metric, before, after, change, verdict))
+
+
+if __name__ == "__main__":
+    main()
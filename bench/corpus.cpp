@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "bench.h"
+
+/*** synthetic corpora ***/
+
+static const char *words[] = {
+  "count", "total", "buffer", "index", "node", "value", "offset", "state",
+  "item", "next", "len", "cache", "entry", "flags", "result", "row",
+};
+
+static const char *pick(uint64_t *rng, const char **from, int n) {
+  return from[benchRand(rng) % n];
+}
+
+static std::string ident(uint64_t *rng) {
+  std::string s = pick(rng, words, 16);
+  if (benchRand(rng) % 2) {
+    s += '_';
+    s += pick(rng, words, 16);
+  }
+  return s;
+}
+
+/* Writes out what the generators build up, a chunk at a time, and tells
+ * them when the corpus is long enough. */
+struct corpusOut {
+  FILE *fp;
+  std::string buf;
+  long long written;
+  long long want;
+
+  bool full() const { return written + (long long)buf.size() >= want; }
+  void flush() {
+    fwrite(buf.data(), 1, buf.size(), fp);
+    written += buf.size();
+    buf.clear();
+  }
+  void line(const std::string &s) {
+    buf += s;
+    buf += '\n';
+    if (buf.size() >= (1 << 20)) flush();
+  }
+};
+
+/* C functions with block and line comments, strings, numbers and
+ * keywords, indented with spaces. */
+static void generateC(FILE *fp, long long bytes, uint64_t *rng) {
+  corpusOut out = {fp, "", 0, bytes};
+  for (int fn = 0; !out.full(); fn++) {
+    std::string name = ident(rng) + "_" + std::to_string(fn);
+    out.line("/* Computes the " + ident(rng) + " of block " +
+             std::to_string(fn) + ".");
+    out.line(" * Returns -1 if the " + ident(rng) + " is out of range. */");
+    out.line("static int " + name + "(const char *buf, int len) {");
+    out.line("    int " + ident(rng) + " = 0;");
+    int body = 2 + benchRand(rng) % 6;
+    for (int i = 0; i < body; i++) {
+      switch (benchRand(rng) % 4) {
+        case 0:
+          out.line("    for (int i = 0; i < len; i++) {");
+          out.line("        if (buf[i] == '\\n') total += " +
+                   std::to_string(benchRand(rng) % 1000) + ";  // " +
+                   ident(rng));
+          out.line("    }");
+          break;
+        case 1:
+          out.line("    printf(\"%d " + ident(rng) + "\\n\", " + ident(rng) +
+                   ");");
+          break;
+        case 2:
+          out.line("    while (" + ident(rng) + " > 0x" +
+                   std::to_string(benchRand(rng) % 9999) + ") " +
+                   ident(rng) + " >>= 1;");
+          break;
+        default:
+          out.line("    double " + ident(rng) + " = " +
+                   std::to_string(benchRand(rng) % 100) + ".5;");
+      }
+    }
+    out.line("    return " + ident(rng) + ";");
+    out.line("}");
+    out.line("");
+  }
+  out.flush();
+}
+
+/* Minified JSON arrays of records, about 1 MiB per line, the way
+ * machine-written JSON arrives. */
+static void generateJson(FILE *fp, long long bytes, uint64_t *rng) {
+  corpusOut out = {fp, "", 0, bytes};
+  std::string line;
+  for (long long id = 0; !out.full(); id++) {
+    line += line.empty() ? "[" : ",";
+    line += "{\"id\":" + std::to_string(id) + ",\"name\":\"" + ident(rng) +
+            "\",\"tags\":[\"" + ident(rng) + "\",\"" + ident(rng) +
+            "\"],\"value\":" + std::to_string(benchRand(rng) % 100000) +
+            ".25,\"active\":" + (benchRand(rng) % 2 ? "true" : "false") + "}";
+    if (line.size() >= (1 << 20)) {
+      out.line(line + "]");
+      line.clear();
+    }
+  }
+  if (!line.empty()) out.line(line + "]");
+  out.flush();
+}
+
+/* Tab-indented C with tab-aligned columns, so that most rows render
+ * wider than they are stored. */
+static void generateTabs(FILE *fp, long long bytes, uint64_t *rng) {
+  corpusOut out = {fp, "", 0, bytes};
+  for (int n = 0; !out.full(); n++) {
+    int depth = 1 + benchRand(rng) % 4;
+    std::string line(depth, '\t');
+    switch (benchRand(rng) % 3) {
+      case 0:
+        line += "case " + std::to_string(n % 64) + ":\t" + ident(rng) +
+                " = " + ident(rng) + ";\t\t/* " + ident(rng) + " */";
+        break;
+      case 1:
+        line += "{\t" + std::to_string(n) + ",\t\"" + ident(rng) + "\",\t" +
+                ident(rng) + "\t},";
+        break;
+      default:
+        line += "int\t" + ident(rng) + ";\t// " + ident(rng);
+    }
+    out.line(line);
+  }
+  out.flush();
+}
+
+/* Service log lines: timestamp, level, component and key=value pairs. */
+static void generateLog(FILE *fp, long long bytes, uint64_t *rng) {
+  static const char *levels[] = {"INFO ", "INFO ", "INFO ", "DEBUG", "WARN ",
+                                 "ERROR"};
+  corpusOut out = {fp, "", 0, bytes};
+  char stamp[64];
+  for (long long n = 0; !out.full(); n++) {
+    long long ms = n * 37;
+    snprintf(stamp, sizeof(stamp), "2026-10-18T%02lld:%02lld:%02lld.%03lldZ",
+             ms / 3600000 % 24, ms / 60000 % 60, ms / 1000 % 60, ms % 1000);
+    out.line(std::string(stamp) + " " + pick(rng, levels, 6) + " [worker-" +
+             std::to_string(benchRand(rng) % 16) + "] " + ident(rng) +
+             " id=" + std::to_string(benchRand(rng) % 1000000) +
+             " path=/api/v1/" + pick(rng, words, 16) + "/" +
+             std::to_string(n % 5000) + " status=" +
+             (benchRand(rng) % 20 ? "200" : "503") +
+             " latency_ms=" + std::to_string(benchRand(rng) % 900));
+  }
+  out.flush();
+}
+
+const struct benchCorpus benchCorpora[] = {
+  {"c", "corpus.c", 32, generateC},
+  {"json", "corpus.json", 16, generateJson},
+  {"tabs", "tabs.c", 16, generateTabs},
+  {"log", "service.log", 128, generateLog},
+};
+
+const int benchNumCorpora = sizeof(benchCorpora) / sizeof(benchCorpora[0]);
+
+std::string benchCorpusPath(const struct benchCorpus *c) {
+  return std::string(benchOpt.dir) + "/" + c->file;
+}
+
+/* Writes the corpus and returns its size in bytes. The log's size is set
+ * by --log-mb rather than scaled, so that it can be made multi-GB on its
+ * own. */
+long long benchGenerate(const struct benchCorpus *c) {
+  long long bytes = c->mb * benchOpt.scale * (1 << 20);
+  if (c->generate == generateLog && benchOpt.logmb > 0)
+    bytes = benchOpt.logmb << 20;
+
+  std::string path = benchCorpusPath(c);
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (fp == NULL) {
+    perror(path.c_str());
+    exit(1);
+  }
+  uint64_t rng = 0x9e3779b97f4a7c15ULL;
+  c->generate(fp, bytes, &rng);
+  long long size = ftell(fp);
+  fclose(fp);
+  return size;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "Replay.h"
+#include "Terminal.h"
+#include "bench_commit.h"
+
+static void usage() {
+  fprintf(stderr,
+    "usage: byte-writer-replay [--size ROWSxCOLS] [--json] [--p99-us N]\n"
+    "                          TRACE [FILE]\n"
+    "Replays the keys recorded in TRACE (see BYTE_WRITER_TRACE) against\n"
+    "FILE on a headless terminal of the given size (24x80 by default) and\n"
+    "reports how long each key took to process and draw and how many\n"
+    "bytes its frames wrote. With --p99-us, exits 1 if the 99th percentile\n"
+    "of per-key time is over N microseconds.\n");
+  exit(2);
+}
+
+/* The value at quantile q of sorted v. */
+static double quantile(const std::vector<double> &v, double q) {
+  if (v.empty()) return 0;
+  return v[std::min(v.size() - 1, (size_t)(q * v.size()))];
+}
+
+static std::string jsonString(const std::string &s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    out += c;
+  }
+  return out + "\"";
+}
+
+int main(int argc, char *argv[]) {
+  int rows = 24, cols = 80, json = 0;
+  double p99budget = 0;
+  const char *trace = NULL, *file = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0) {
+      json = 1;
+    } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &rows, &cols) != 2) usage();
+    } else if (strcmp(argv[i], "--p99-us") == 0 && i + 1 < argc) {
+      p99budget = atof(argv[++i]);
+    } else if (argv[i][0] == '-') {
+      usage();
+    } else if (!trace) {
+      trace = argv[i];
+    } else if (!file) {
+      file = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if (!trace || rows < 3 || cols < 1) usage();
+
+  std::vector<std::string> keys;
+  if (replayLoad(trace, &keys) == -1) {
+    perror(trace);
+    return 1;
+  }
+
+  termUseMemory(rows, cols);
+  enableRawMode();
+  initEditor();
+  if (file) editorOpen(file);
+
+  std::vector<replayStep> steps;
+  replayRun(keys, &steps);
+
+  std::vector<double> total, process, frame, bytes;
+  int frames = 0;
+  for (const replayStep &s : steps) {
+    total.push_back(s.process_us + s.frame_us);
+    process.push_back(s.process_us);
+    frame.push_back(s.frame_us);
+    bytes.push_back(s.bytes);
+    frames += s.frames;
+  }
+  long long written = 0;
+  for (double b : bytes) written += b;
+  for (auto *v : {&total, &process, &frame, &bytes}) std::sort(v->begin(), v->end());
+
+  if (json) {
+    printf("{\n  \"commit\": \"%s\",\n  \"trace\": %s,\n  \"size\": \"%dx%d\",\n"
+           "  \"steps\": [", BENCH_COMMIT, jsonString(trace).c_str(), rows, cols);
+    for (size_t i = 0; i < steps.size(); i++) {
+      const replayStep &s = steps[i];
+      printf("%s\n    {\"key\": %s, \"keys\": %d, \"process_us\": %.1f, "
+             "\"frame_us\": %.1f, \"frames\": %d, \"bytes\": %lld}",
+             i ? "," : "", jsonString(termEscapeKey(s.key)).c_str(), s.keys,
+             s.process_us, s.frame_us, s.frames, s.bytes);
+    }
+    printf("\n  ],\n  \"summary\": {\"steps\": %zu, \"frames\": %d, "
+           "\"bytes\": %lld, \"p50_us\": %.1f, \"p99_us\": %.1f, "
+           "\"max_us\": %.1f, \"max_bytes\": %.0f}\n}\n",
+           steps.size(), frames, written, quantile(total, 0.5),
+           quantile(total, 0.99), quantile(total, 1), quantile(bytes, 1));
+  } else {
+    printf("%zu keys, %d frames, %lld bytes written\n", steps.size(), frames,
+           written);
+    printf("%-8s %10s %10s %10s\n", "", "p50", "p99", "max");
+    printf("%-8s %10.1f %10.1f %10.1f\n", "key us", quantile(total, 0.5),
+           quantile(total, 0.99), quantile(total, 1));
+    printf("%-8s %10.1f %10.1f %10.1f\n", "process", quantile(process, 0.5),
+           quantile(process, 0.99), quantile(process, 1));
+    printf("%-8s %10.1f %10.1f %10.1f\n", "frame", quantile(frame, 0.5),
+           quantile(frame, 0.99), quantile(frame, 1));
+    printf("%-8s %10.0f %10.0f %10.0f\n", "bytes", quantile(bytes, 0.5),
+           quantile(bytes, 0.99), quantile(bytes, 1));
+  }
+
+  if (p99budget > 0 && quantile(total, 0.99) > p99budget) {
+    fprintf(stderr, "p99 of %.1f us per key is over the budget of %.1f us\n",
+            quantile(total, 0.99), p99budget);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+/* An example plugin: after the file is opened or saved, reports how many
+ * lines end in spaces or tabs. The rows are copied on the editor's
+ * thread, scanned on the plugin worker and the count is reported back on
+ * the editor's thread, with at most one scan in flight. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "PluginAbi.h"
+
+struct scan {
+  char *text;
+  int *lens;
+  int n;
+  int found;
+  int first;
+};
+
+static const bw_host *host;
+static int running;
+static int again;
+
+static void report(void *arg);
+
+/* Runs on the plugin worker. */
+static void scanRows(void *arg) {
+  struct scan *s = arg;
+  const char *p = s->text;
+  s->found = 0;
+  s->first = -1;
+  for (int i = 0; i < s->n; p += s->lens[i], i++) {
+    if (s->lens[i] == 0) continue;
+    char last = p[s->lens[i] - 1];
+    if (last == ' ' || last == '\t') {
+      if (s->found++ == 0) s->first = i;
+    }
+  }
+  host->main(report, s);
+}
+
+static void startScan(void);
+
+/* Runs on the editor's thread once the scan is done. */
+static void report(void *arg) {
+  struct scan *s = arg;
+  char msg[80];
+  if (s->found)
+    snprintf(msg, sizeof(msg),
+             "trailing-space: %d line%s in whitespace, first is %d",
+             s->found, s->found == 1 ? " ends" : "s end", s->first + 1);
+  else
+    snprintf(msg, sizeof(msg), "trailing-space: no trailing whitespace");
+  host->status(msg);
+  free(s->text);
+  free(s->lens);
+  free(s);
+  running = 0;
+  if (again) startScan();
+}
+
+static void startScan(void) {
+  if (running) {
+    again = 1;
+    return;
+  }
+  again = 0;
+
+  struct scan *s = calloc(1, sizeof(*s));
+  s->n = host->numrows();
+  s->lens = malloc(sizeof(int) * (s->n ? s->n : 1));
+  size_t total = 0;
+  for (int i = 0; i < s->n; i++) {
+    s->lens[i] = host->row(i).len;
+    total += s->lens[i];
+  }
+  s->text = malloc(total ? total : 1);
+  char *p = s->text;
+  for (int i = 0; i < s->n; i++) {
+    bw_row row = host->row(i);
+    memcpy(p, row.chars, row.len);
+    p += row.len;
+  }
+
+  running = 1;
+  host->post(scanRows, s);
+}
+
+static void onEvents(const bw_event *ev, int n, const bw_host *h) {
+  (void)h;
+  for (int i = 0; i < n; i++) {
+    if (ev[i].type == BW_EV_OPEN || ev[i].type == BW_EV_SAVE) {
+      startScan();
+      return;
+    }
+  }
+}
+
+static const bw_plugin plugin = {
+  BW_PLUGIN_ABI, "trailing-space", BW_EV_OPEN | BW_EV_SAVE, onEvents, NULL
+};
+
+const bw_plugin *bw_plugin_init(const bw_host *h) {
+  if (h->abi != BW_PLUGIN_ABI) return NULL;
+  host = h;
+  return &plugin;
+}
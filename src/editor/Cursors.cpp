@@ -0,0 +1,248 @@
+#include "Cursors.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Editor.h"
+#include "Row.h"
+#include "Search.h"
+#include "Terminal.h"
+#include "Undo.h"
+
+/*** multiple cursors ***/
+
+void editorCursorsClear() {
+  E.cursors.extra.clear();
+}
+
+/* Every cursor in order, the primary one at *primary. Cursors left past
+ * the text by a reload are pulled back onto it. */
+static std::vector<cursorPos> cursorsAll(int *primary) {
+  std::vector<cursorPos> all = E.cursors.extra;
+  cursorPos p = {E.cy, E.cx};
+  auto it = std::lower_bound(all.begin(), all.end(), p);
+  *primary = it - all.begin();
+  all.insert(it, p);
+  for (cursorPos &c : all) {
+    if (c.cy > E.numrows) c.cy = E.numrows;
+    int size = c.cy < E.numrows ? E.row[c.cy].size : 0;
+    if (c.cx > size) c.cx = size;
+  }
+  return all;
+}
+
+/* Makes all[primary] the primary cursor and the rest, less any that ran
+ * into each other, the extra ones. */
+static void cursorsStore(std::vector<cursorPos> &all, int primary) {
+  cursorPos p = all[primary];
+  std::sort(all.begin(), all.end());
+  all.erase(std::unique(all.begin(), all.end()), all.end());
+  all.erase(std::lower_bound(all.begin(), all.end(), p));
+  E.cy = p.cy;
+  E.cx = p.cx;
+  E.cursors.extra = std::move(all);
+}
+
+/* Replaces any extra cursors with one at every occurrence of query, the
+ * primary one moving to the first at or after it. */
+void editorCursorsAddMatches(const char *query) {
+  size_t qlen = strlen(query);
+  if (qlen == 0) return;
+
+  std::vector<cursorPos> all;
+  for (int y = 0; y < E.numrows && all.size() < CURSORS_MAX; y++) {
+    erow *row = &E.row[y];
+    const char *chars = editorRowChars(row);
+    const char *p = chars;
+    const char *end = chars + row->size;
+    const char *hit;
+    while (all.size() < CURSORS_MAX &&
+           (hit = (const char *)searchFind(p, end - p, query, qlen))) {
+      all.push_back({y, (int)(hit - chars)});
+      p = hit + qlen;
+    }
+  }
+  if (all.empty()) {
+    editorSetStatusMessage("No match for %s", query);
+    return;
+  }
+
+  cursorPos p = {E.cy, E.cx};
+  int primary = std::lower_bound(all.begin(), all.end(), p) - all.begin();
+  if (primary == (int)all.size()) primary = 0;
+  int n = all.size();
+  cursorsStore(all, primary);
+  editorSetStatusMessage("%d cursors%s", n,
+    n == CURSORS_MAX ? " (limit reached)" : "");
+}
+
+/* Ctrl-E */
+void editorCursorsFind() {
+  char *query = editorPrompt("Cursors at: %s (ESC to cancel)", NULL);
+  if (query == NULL) return;
+  editorCursorsAddMatches(query);
+  free(query);
+}
+
+/* Ctrl-B: extends a column of cursors down by one row. The new cursor
+ * becomes the primary one, so the screen follows it. */
+void editorCursorsAddBelow() {
+  int primary;
+  std::vector<cursorPos> all = cursorsAll(&primary);
+  int y = all.back().cy + 1;
+  if (y >= E.numrows) return;
+  int rx = E.cy < E.numrows ? editorRowCxToRx(&E.row[E.cy], E.cx) : 0;
+  all.push_back({y, editorRowRxToCx(&E.row[y], rx)});
+  cursorsStore(all, all.size() - 1);
+}
+
+enum cursorsOp {
+  CURSORS_INSERT,
+  CURSORS_BACKSPACE,
+  CURSORS_DELETE
+};
+
+/* Applies op at every cursor as one batch and one undo record: each row
+ * holding cursors has its new text built in a single pass over it, with
+ * the cursors moved along, and the rows are then stored together. */
+static void cursorsEdit(int op, int c) {
+  int primary;
+  std::vector<cursorPos> all = cursorsAll(&primary);
+  editorUndoBegin();
+  if (op == CURSORS_INSERT && all.back().cy == E.numrows)
+    editorInsertRow(E.numrows, "", 0);
+
+  std::vector<int> rows;
+  std::vector<std::string> texts;
+  size_t i = 0;
+  while (i < all.size() && all[i].cy < E.numrows) {
+    int cy = all[i].cy;
+    erow *row = &E.row[cy];
+    const char *chars = editorRowChars(row);
+    std::string out;
+    out.reserve(row->size + 16);
+    int from = 0;
+    int changed = 0;
+
+    /* Each cursor copies the text up to cut, then skips to resume. */
+    for (; i < all.size() && all[i].cy == cy; i++) {
+      int cx = std::max(all[i].cx, from);
+      int cut = cx;
+      int resume = cx;
+      if (op == CURSORS_BACKSPACE && cx > 0)
+        cut = std::max(editorRowPrevCx(row, cx), from);
+      else if (op == CURSORS_DELETE && cx < row->size)
+        resume = editorRowNextCx(row, cx);
+
+      out.append(chars + from, cut - from);
+      if (op == CURSORS_INSERT) out += (char)c;
+      all[i].cx = out.size();
+      changed |= op == CURSORS_INSERT || cut < resume;
+      from = resume;
+    }
+    out.append(chars + from, row->size - from);
+
+    if (changed) {
+      rows.push_back(cy);
+      texts.push_back(std::move(out));
+    }
+  }
+
+  int n = rows.size();
+  std::vector<const char *> ptrs(n);
+  std::vector<size_t> lens(n);
+  for (int k = 0; k < n; k++) {
+    ptrs[k] = texts[k].data();
+    lens[k] = texts[k].size();
+  }
+  editorRowsSetText(rows.data(), ptrs.data(), lens.data(), n);
+  editorUndoEnd();
+  cursorsStore(all, primary);
+}
+
+void editorCursorsInsert(int c) {
+  cursorsEdit(CURSORS_INSERT, c);
+}
+
+void editorCursorsDelChar(int forward) {
+  cursorsEdit(forward ? CURSORS_DELETE : CURSORS_BACKSPACE, 0);
+}
+
+/* Moves every cursor as the key would move the primary one alone. */
+void editorCursorsMove(int key) {
+  int primary;
+  std::vector<cursorPos> all = cursorsAll(&primary);
+  for (cursorPos &c : all) {
+    E.cy = c.cy;
+    E.cx = c.cx;
+    if (key == HOME_KEY) E.cx = 0;
+    else if (key == END_KEY) E.cx = E.cy < E.numrows ? E.row[E.cy].size : 0;
+    else editorMoveCursor(key);
+    c.cy = E.cy;
+    c.cx = E.cx;
+  }
+  cursorsStore(all, primary);
+}
+
+/* Offsets into render of the extra cursors on filerow, in order. */
+void editorCursorsMarks(int filerow, std::vector<int> *marks) {
+  marks->clear();
+  if (E.cursors.extra.empty()) return;
+  erow *row = &E.row[filerow];
+  cursorPos first = {filerow, 0};
+  auto it = std::lower_bound(E.cursors.extra.begin(), E.cursors.extra.end(),
+                             first);
+  for (; it != E.cursors.extra.end() && it->cy == filerow; ++it) {
+    int cx = std::min(it->cx, row->size);
+    int col;
+    marks->push_back(editorRowRxToRender(row, editorRowCxToRx(row, cx), &col));
+  }
+}
+
+/* Handles a key while there are extra cursors. Returns 0 for keys left to
+ * the usual handling, dropping the extra cursors first if the key acts on
+ * the primary cursor alone. */
+int editorCursorsProcessKey(int c) {
+  switch (c) {
+    case BACKSPACE:
+    case CTRL_KEY('h'):
+    case DEL_KEY:
+      editorCursorsDelChar(c == DEL_KEY);
+      return 1;
+
+    case ARROW_UP:
+    case ARROW_DOWN:
+    case ARROW_LEFT:
+    case ARROW_RIGHT:
+    case HOME_KEY:
+    case END_KEY:
+      editorCursorsMove(c);
+      return 1;
+
+    case '\x1b':
+      editorCursorsClear();
+      return 1;
+
+    case '\r':
+    case PAGE_UP:
+    case PAGE_DOWN:
+    case CTRL_KEY('f'):
+    case CTRL_KEY('g'):
+    case CTRL_KEY('n'):
+    case CTRL_KEY('p'):
+    case CTRL_KEY('r'):
+    case CTRL_KEY('t'):
+    case CTRL_KEY('x'):
+      editorCursorsClear();
+      return 0;
+  }
+
+  if (c == '\t' || (c < 256 && !iscntrl(c))) {
+    editorCursorsInsert(c);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+/*** multiple cursors ***/
+
+/* Ctrl-E stops adding cursors after this many matches. */
+#define CURSORS_MAX 100000
+
+struct cursorPos {
+  int cy;
+  int cx;
+};
+
+inline bool operator<(const cursorPos &a, const cursorPos &b) {
+  return a.cy != b.cy ? a.cy < b.cy : a.cx < b.cx;
+}
+
+inline bool operator==(const cursorPos &a, const cursorPos &b) {
+  return a.cy == b.cy && a.cx == b.cx;
+}
+
+/* Cursors besides the primary one at E.cx/E.cy, sorted and distinct from
+ * each other and from it. Ctrl-E adds one at every match of a string,
+ * Ctrl-B one on the row below the last at the primary's column, and Esc
+ * drops them.
+ *
+ * While there are any, a keystroke that types or deletes is applied at
+ * every cursor as one batch: the cursors are grouped by row, each row's
+ * new text is built in one pass and stored with editorRowsSetText, which
+ * re-highlights all of them in a single sweep, and the whole batch is one
+ * undo record. Backspace at the start of a row and Delete at its end do
+ * nothing rather than join rows. */
+struct cursorSet {
+  std::vector<cursorPos> extra;
+};
+
+void editorCursorsClear();
+void editorCursorsAddMatches(const char *query);
+void editorCursorsFind();
+void editorCursorsAddBelow();
+void editorCursorsInsert(int c);
+void editorCursorsDelChar(int forward);
+void editorCursorsMove(int key);
+void editorCursorsMarks(int filerow, std::vector<int> *marks);
+int editorCursorsProcessKey(int c);
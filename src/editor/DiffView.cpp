@@ -0,0 +1,169 @@
+#include "DiffView.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+#include "Diff.h"
+#include "Editor.h"
+#include "FileIO.h"
+#include "Hash.h"
+
+#define DIFF_CHUNK (1 << 20)
+
+/* hashBytes, less 0, which marks a row not hashed yet. */
+uint64_t editorDiffHash(const char *text, size_t len) {
+  uint64_t h = hashBytes(text, len);
+  return h ? h : 1;
+}
+
+static void editorDiffHashLines(const char *text, size_t len) {
+  editorSplitLines(text, len, [&](size_t at, size_t linelen) {
+    E.diff.disk.push_back(editorDiffHash(text + at, linelen));
+  });
+}
+
+/* Rehashes the lines of the file, read a chunk at a time rather than
+ * mapped, so that the file being truncated meanwhile only ends it early.
+ * A missing file has no lines. */
+static void editorDiffLoadDisk() {
+  E.diff.disk.clear();
+  E.diff.diskstale = 0;
+  int fd = E.filename ? open(E.filename, O_RDONLY) : -1;
+  if (fd == -1) return;
+
+  std::vector<char> buf(DIFF_CHUNK);
+  std::string carry;
+  off_t off = 0;
+  while (1) {
+    ssize_t n = pread(fd, buf.data(), buf.size(), off);
+    if (n == -1 && errno == EINTR) continue;
+    if (n <= 0) break;
+    off += n;
+
+    /* Only whole lines are hashed; the rest is carried to the next. */
+    const char *text = buf.data();
+    size_t len = n;
+    const char *last = (const char *)memrchr(text, '\n', len);
+    if (last == NULL) {
+      carry.append(text, len);
+      continue;
+    }
+    size_t whole = last - text + 1;
+    if (!carry.empty()) {
+      size_t first = (const char *)memchr(text, '\n', len) - text + 1;
+      carry.append(text, first);
+      editorDiffHashLines(carry.data(), carry.size());
+      text += first;
+      len -= first;
+      whole -= first;
+    }
+    editorDiffHashLines(text, whole);
+    carry.assign(text + whole, len - whole);
+  }
+  editorDiffHashLines(carry.data(), carry.size());
+  close(fd);
+}
+
+/* Hashes the rows that changed since they were last hashed, and returns
+ * the hashes of every row. */
+const std::vector<uint64_t> &editorDiffRowHashes() {
+  for (int j = 0; j < E.numrows; j++)
+    if (E.diff.rows[j] == 0)
+      E.diff.rows[j] = editorDiffHash(editorRowChars(&E.row[j]), E.row[j].size);
+  return E.diff.rows;
+}
+
+/* Diffs the row hashes against the file, rehashing the file first if it
+ * may have changed. Without a file watch that cannot be told, so the
+ * file is rehashed every time. */
+static void editorDiffRun() {
+  if (E.diff.diskstale || E.watch.fd == -1) editorDiffLoadDisk();
+  editorDiffRowHashes();
+
+  std::vector<diffHunk> hunks;
+  diffLines(E.diff.disk.data(), E.diff.disk.size(), E.diff.rows.data(),
+            E.numrows, &hunks);
+
+  E.diff.marks.assign(E.numrows + 1, 0);
+  E.diff.hunks = hunks.size();
+  E.diff.added = 0;
+  E.diff.removed = 0;
+  for (const diffHunk &h : hunks) {
+    unsigned char mark = h.alen ? DIFF_CHANGED : DIFF_ADDED;
+    for (int j = h.b; j < h.b + h.blen; j++) E.diff.marks[j] = mark;
+    if (h.alen > h.blen) E.diff.marks[h.b + h.blen] |= DIFF_REMOVED;
+    E.diff.added += h.blen;
+    E.diff.removed += h.alen;
+  }
+  E.diff.stale = 0;
+}
+
+/* Brings the marks up to date with the buffer and the file now. */
+void editorDiffUpdate() {
+  if (E.diff.on) editorDiffRun();
+}
+
+/* Called when no key has arrived for DIFF_IDLE_MS. */
+void editorDiffIdle() {
+  if (E.diff.on && (E.diff.stale || E.diff.diskstale)) editorDiffRun();
+}
+
+/* Forgets the buffer, as when a new file is opened into it. */
+void editorDiffReset() {
+  E.diff.disk.clear();
+  E.diff.rows.clear();
+  E.diff.marks.assign(1, 0);
+  E.diff.stale = 1;
+  E.diff.diskstale = 1;
+}
+
+void editorDiffDiskChanged() {
+  E.diff.diskstale = 1;
+}
+
+/*** row hooks ***/
+
+void editorDiffInsertRow(int at) {
+  E.diff.rows.insert(E.diff.rows.begin() + at, 0);
+  if (!E.diff.on) return;
+  E.diff.marks.insert(E.diff.marks.begin() + at, DIFF_ADDED);
+  E.diff.stale = 1;
+}
+
+/* Called after row at is gone. */
+void editorDiffDelRow(int at) {
+  E.diff.rows.erase(E.diff.rows.begin() + at);
+  if (!E.diff.on) return;
+  E.diff.marks.erase(E.diff.marks.begin() + at);
+  E.diff.marks[at] |= DIFF_REMOVED;
+  E.diff.stale = 1;
+}
+
+void editorDiffUpdateRow(int at) {
+  E.diff.rows[at] = 0;
+  if (!E.diff.on) return;
+  if (!(E.diff.marks[at] & DIFF_ADDED)) E.diff.marks[at] |= DIFF_CHANGED;
+  E.diff.stale = 1;
+}
+
+void editorToggleDiff() {
+  E.diff.on = !E.diff.on;
+  if (!E.diff.on) {
+    E.diff.disk.clear();
+    E.diff.marks.clear();
+    editorSetStatusMessage("Diff off");
+    return;
+  }
+  E.diff.diskstale = 1;
+  editorDiffRun();
+  editorSetStatusMessage("Diff against disk: %d hunks, +%d -%d (Ctrl-D to hide)",
+                         E.diff.hunks, E.diff.added, E.diff.removed);
+}
+
+/* Columns the gutter takes from the text. */
+int editorDiffGutter() {
+  return E.diff.on ? DIFF_GUTTER : 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*** diff view ***/
+
+#define DIFF_GUTTER 2
+/* The diff is rerun once no key has arrived for this many ms. */
+#define DIFF_IDLE_MS 150
+
+enum diffMark {
+  DIFF_ADDED = 1,
+  DIFF_CHANGED = 2,
+  DIFF_REMOVED = 4
+};
+
+/* Ctrl-D shows how the buffer differs from the file on disk in a gutter
+ * left of the text. marks has an entry per row and one for the end of
+ * the buffer: DIFF_ADDED or DIFF_CHANGED for rows that are not on disk,
+ * and DIFF_REMOVED where lines of the file were deleted just above.
+ *
+ * disk holds the hashes of the file's lines and rows those of the
+ * buffer's, which the row operations keep in step (editorDiffInsertRow
+ * and friends) even while the diff is hidden, as reload diffs them too.
+ * A row that is new or changed has hash 0 until editorDiffRowHashes
+ * next runs, so neither a keystroke nor opening a file hashes any text.
+ * An edit marks its own rows at once and sets stale; the diff itself is
+ * only rerun when the user pauses (editorDiffIdle), so a keystroke costs
+ * the same however long the file is. diskstale is set
+ * when the file watch (see FileIO.h) sees the file change, and the file
+ * is rehashed on the next run. */
+struct diffView {
+  int on;
+  int stale;
+  int diskstale;
+  std::vector<uint64_t> disk;
+  std::vector<uint64_t> rows;
+  std::vector<unsigned char> marks;
+  int hunks;
+  int added;
+  int removed;
+};
+
+void editorToggleDiff();
+void editorDiffUpdate();
+void editorDiffIdle();
+void editorDiffReset();
+void editorDiffDiskChanged();
+uint64_t editorDiffHash(const char *text, size_t len);
+const std::vector<uint64_t> &editorDiffRowHashes();
+void editorDiffInsertRow(int at);
+void editorDiffDelRow(int at);
+void editorDiffUpdateRow(int at);
+int editorDiffGutter();
@@ -1,3 +1,974 @@
+#include "Editor.h"
 
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <csignal>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
+#include "Buffer.h"
+#include "FileIO.h"
+#include "Helpers.h"
+#include "Probe.h"
+#include "Search.h"
+#include "Stats.h"
+#include "Terminal.h"
+#include "Utf8.h"
 
+struct editorConfig E;
+
+/*** editor operations ***/
+
+void editorInsertChar(int c) {
+  editorUndoBegin();
+  if (E.cy == E.numrows) {
+    editorInsertRow(E.numrows, "", 0);
+  }
+  editorRowInsertChar(&E.row[E.cy], E.cx, c);
+  E.cx++;
+  editorUndoEnd();
+}
+
+void editorInsertNewline() {
+  editorUndoBegin();
+  if (E.cx == 0) {
+    editorInsertRow(E.cy, "", 0);
+  } else {
+    erow *row = &E.row[E.cy];
+    editorInsertRow(E.cy + 1, &editorRowChars(row)[E.cx], row->size - E.cx);
+    row = &E.row[E.cy];
+    editorRowTruncate(row, E.cx);
+  }
+  E.cy++;
+  E.cx = 0;
+  editorUndoEnd();
+}
+
+void editorDelChar() {
+  if (E.cy == E.numrows) return;
+  if (E.cx == 0 && E.cy == 0) return;
+
+  editorUndoBegin();
+  erow *row = &E.row[E.cy];
+  if (E.cx > 0) {
+    int prev = editorRowPrevCx(row, E.cx);
+    while (E.cx > prev) {
+      editorRowDelChar(row, prev);
+      E.cx--;
+    }
+  } else {
+    E.cx = E.row[E.cy - 1].size;
+    editorRowAppendString(&E.row[E.cy - 1], editorRowChars(row), row->size);
+    editorDelRow(E.cy);
+    E.cy--;
+  }
+  editorUndoEnd();
+}
+
+/*** find ***/
+
+static void editorFindCallback(char *query, int key) {
+  PROBE(PROBE_SEARCH);
+  static int last_match = -1;
+  static int direction = 1;
+
+  static int saved_hl_line;
+  static unsigned char *saved_hl = NULL;
+
+  if (saved_hl) {
+    erow *row = &E.row[saved_hl_line];
+    memcpy(editorRowHl(row), saved_hl, row->rsize);
+    free(saved_hl);
+    saved_hl = NULL;
+  }
+
+  if (key == '\r' || key == '\x1b') {
+    last_match = -1;
+    direction = 1;
+    return;
+  } else if (key == ARROW_RIGHT || key == ARROW_DOWN) {
+    direction = 1;
+  } else if (key == ARROW_LEFT || key == ARROW_UP) {
+    direction = -1;
+  } else {
+    last_match = -1;
+    direction = 1;
+  }
+
+  if (last_match == -1) direction = 1;
+  int current = last_match;
+  int i;
+  for (i = 0; i < E.numrows; i++) {
+    current += direction;
+    if (current == -1) current = E.numrows - 1;
+    else if (current == E.numrows) current = 0;
+
+    editorPrepareRows(current + 1);
+    erow *row = &E.row[current];
+    char *render = editorRowRender(row);
+    char *match = (char *)searchFind(render, row->rsize, query, strlen(query));
+    if (match) {
+      last_match = current;
+      E.cy = current;
+      E.cx = editorRowRenderToCx(row, match - render);
+      E.rowoff = E.numrows;
+      E.vrowoff = LLONG_MAX;
+
+      saved_hl_line = current;
+      unsigned char *hl = editorRowHl(row);
+      saved_hl = (unsigned char *)malloc(row->rsize);
+      memcpy(saved_hl, hl, row->rsize);
+      memset(&hl[match - render], HL_MATCH, strlen(query));
+      break;
+    }
+  }
+}
+
+void editorFind() {
+  int saved_cx = E.cx;
+  int saved_cy = E.cy;
+  int saved_coloff = E.coloff;
+  int saved_rowoff = E.rowoff;
+  long long saved_vrowoff = E.vrowoff;
+
+  char *query = editorPrompt("Search: %s (Use ESC/Arrows/Enter)",
+                             editorFindCallback);
+
+  if (query) {
+    free(query);
+  } else {
+    E.cx = saved_cx;
+    E.cy = saved_cy;
+    E.coloff = saved_coloff;
+    E.rowoff = saved_rowoff;
+    E.vrowoff = saved_vrowoff;
+  }
+}
+
+/* Ctrl-G: jumps to a line number, or to a byte offset given as @offset
+ * (decimal or 0x hex, as in crash logs). */
+void editorGoto() {
+  char *query = editorPrompt("Go to line or @offset: %s (ESC to cancel)",
+                             NULL);
+  if (query == NULL) return;
+
+  char *end;
+  if (query[0] == '@') {
+    long long offset = strtoll(query + 1, &end, 0);
+    if (end != query + 1 && *end == '\0') {
+      E.cy = editorOffsetToRow(offset, &E.cx);
+      if (E.cy < E.numrows && E.cx > E.row[E.cy].size)
+        E.cx = E.row[E.cy].size;
+    } else {
+      editorSetStatusMessage("Bad offset: %s", query + 1);
+    }
+  } else {
+    long long line = strtoll(query, &end, 10);
+    if (end != query && *end == '\0') {
+      if (line < 1) line = 1;
+      E.cy = line > E.numrows ? E.numrows : line - 1;
+      E.cx = 0;
+    } else {
+      editorSetStatusMessage("Bad line number: %s", query);
+    }
+  }
+  free(query);
+}
+
+/*** output ***/
+
+/* Width of the text area: the screen less the diff gutter. */
+static int editorTextCols() {
+  return E.screencols - editorDiffGutter();
+}
+
+void editorToggleWrap() {
+  E.wrap = !E.wrap;
+  if (E.wrap) {
+    editorWrapBuild(editorTextCols());
+    E.vrowoff = editorWrapLineOf(E.rowoff);
+  } else {
+    editorWrapFree();
+  }
+  editorSetStatusMessage("Soft wrap %s", E.wrap ? "on" : "off");
+}
+
+/* Makes the rows covering the screen from visual line vrowoff exact. */
+static void editorRefineScreen() {
+  int sub;
+  int filerow = editorWrapRowOf(E.vrowoff, &sub);
+  int y = -sub;
+  while (filerow < E.numrows && y < E.screenrows)
+    y += editorWrapRefine(filerow++);
+}
+
+static void editorScrollWrapped() {
+  int width = std::max(editorTextCols(), 1);
+  if (E.layout.width != width) editorWrapBuild(width);
+
+  /* Refining the rows on screen can move the cursor's line, so settle
+   * the scroll position once more after the first pass. */
+  for (int pass = 0; pass < 2; pass++) {
+    int sub = 0;
+    E.vcx = 0;
+    if (E.cy < E.numrows) {
+      editorWrapRefine(E.cy);
+      editorWrapLocate(&E.row[E.cy], E.rx, E.layout.width, &sub, &E.vcx);
+    }
+    E.vcy = editorWrapLineOf(E.cy) + sub;
+
+    if (E.vcy < E.vrowoff) {
+      E.vrowoff = E.vcy;
+    }
+    if (E.vcy >= E.vrowoff + E.screenrows) {
+      E.vrowoff = E.vcy - E.screenrows + 1;
+    }
+    editorRefineScreen();
+  }
+
+  int sub;
+  E.rowoff = editorWrapRowOf(E.vrowoff, &sub);
+  E.coloff = 0;
+}
+
+void editorScroll() {
+  E.rx = 0;
+  if (E.cy < E.numrows) {
+    editorPrepareRows(E.cy + 1);
+    E.rx = editorRowCxToRx(&E.row[E.cy], E.cx);
+  }
+
+  if (E.wrap) {
+    editorScrollWrapped();
+    return;
+  }
+
+  if (E.cy < E.rowoff) {
+    E.rowoff = E.cy;
+  }
+  if (E.cy >= E.rowoff + E.screenrows) {
+    E.rowoff = E.cy - E.screenrows + 1;
+  }
+  if (E.rx < E.coloff) {
+    E.coloff = E.rx;
+  }
+  if (E.rx >= E.coloff + editorTextCols()) {
+    E.coloff = E.rx - editorTextCols() + 1;
+  }
+  editorPrepareRows(E.rowoff + E.screenrows);
+}
+
+/* Draws the row from render[j], which is shown at screen column x, until
+ * the screen is full; returns the offset of the first character that did
+ * not fit. Characters at the offsets in marks, the extra cursors, are
+ * shown in reverse video. */
+static int editorDrawRowSpan(struct abuf *ab, erow *row, int j, int x,
+                             const std::vector<int> &marks) {
+  int current_color = -1;
+  size_t mark = std::lower_bound(marks.begin(), marks.end(), j) - marks.begin();
+  while (j < row->rsize) {
+    char seq[4];
+    int cp;
+    int len = editorRowRenderDecode(row, j, seq, &cp);
+    int width = utf8CharWidth(cp);
+    if (x > 0 && x + width > editorTextCols()) break;
+
+    unsigned char hl = editorRowHlAt(row, j);
+    int marked = mark < marks.size() && marks[mark] == j;
+    if (marked) {
+      abAppend(ab, "\x1b[7m", 4);
+      mark++;
+    }
+    if (cp < 0x20 || (cp >= 0x7f && cp < 0xa0)) {
+      char sym = (cp >= 0 && cp <= 26) ? '@' + cp : '?';
+      abAppend(ab, "\x1b[7m", 4);
+      abAppend(ab, &sym, 1);
+      abAppend(ab, "\x1b[m", 3);
+      if (current_color != -1) {
+        char buf[16];
+        int clen = snprintf(buf, sizeof(buf), "\x1b[%dm", current_color);
+        abAppend(ab, buf, clen);
+      }
+    } else if (hl == HL_NORMAL) {
+      if (current_color != -1) {
+        abAppend(ab, "\x1b[39m", 5);
+        current_color = -1;
+      }
+      abAppend(ab, seq, len);
+    } else {
+      int color = editorSyntaxToColor(hl);
+      if (color != current_color) {
+        current_color = color;
+        char buf[16];
+        int clen = snprintf(buf, sizeof(buf), "\x1b[%dm", color);
+        abAppend(ab, buf, clen);
+      }
+      abAppend(ab, seq, len);
+    }
+    if (marked) abAppend(ab, "\x1b[27m", 5);
+    x += width;
+    j += len;
+  }
+  if (j == row->rsize && mark < marks.size() && x < editorTextCols())
+    abAppend(ab, "\x1b[7m \x1b[27m", 10);
+  abAppend(ab, "\x1b[39m", 5);
+  return j;
+}
+
+/* Draws the diff gutter for a screen line showing filerow; a row's
+ * continuation lines under soft wrap get a blank one. */
+static void editorDrawGutter(struct abuf *ab, int filerow, int first) {
+  if (!E.diff.on) return;
+  unsigned char mark = first ? E.diff.marks[filerow] : 0;
+  if (mark & DIFF_ADDED) abAppend(ab, "\x1b[32m+", 6);
+  else if (mark & DIFF_CHANGED) abAppend(ab, "\x1b[33m~", 6);
+  else if (mark & DIFF_REMOVED) abAppend(ab, "\x1b[31m-", 6);
+  else abAppend(ab, " ", 1);
+  abAppend(ab, mark ? "\x1b[39m " : " ", mark ? 6 : 1);
+}
+
+static void editorDrawRows(struct abuf *ab) {
+  /* With soft wrap, filerow/sub walk the visual lines from vrowoff and j
+   * carries the end of one line over as the start of the next. */
+  int sub = 0;
+  int j = 0;
+  int filerow = E.rowoff;
+  if (E.wrap) {
+    filerow = editorWrapRowOf(E.vrowoff, &sub);
+    if (filerow < E.numrows)
+      j = editorWrapSegment(&E.row[filerow], sub, E.layout.width);
+  }
+
+  int past = 0;
+  int marked = -1;
+  std::vector<int> marks;
+  int y;
+  for (y = 0; y < E.screenrows; y++) {
+    editorDrawGutter(ab, filerow, filerow < E.numrows ? sub == 0 : past++ == 0);
+    if (filerow >= E.numrows) {
+      if (E.numrows == 0 && y == E.screenrows / 3) {
+        char welcome[80];
+        int welcomelen = snprintf(welcome, sizeof(welcome),
+          "ByteWriter editor -- version %s", BYTE_WRITER_VERSION);
+        if (welcomelen > E.screencols) welcomelen = E.screencols;
+        int padding = (E.screencols - welcomelen) / 2;
+        if (padding) {
+          abAppend(ab, "~", 1);
+          padding--;
+        }
+        while (padding--) abAppend(ab, " ", 1);
+        abAppend(ab, welcome, welcomelen);
+      } else {
+        abAppend(ab, "~", 1);
+      }
+    } else if (E.wrap) {
+      erow *row = &E.row[filerow];
+      if (marked != filerow) editorCursorsMarks(marked = filerow, &marks);
+      j = editorDrawRowSpan(ab, row, j, 0, marks);
+      if (++sub >= editorWrapRefine(filerow)) {
+        filerow++;
+        sub = 0;
+        j = 0;
+      }
+    } else {
+      erow *row = &E.row[filerow];
+      int col;
+      int start = editorRowRxToRender(row, E.coloff, &col);
+      int x = col - E.coloff;
+      for (int pad = 0; pad < x && pad < editorTextCols(); pad++)
+        abAppend(ab, " ", 1);
+      editorCursorsMarks(filerow, &marks);
+      editorDrawRowSpan(ab, row, start, x, marks);
+      filerow++;
+    }
+
+    abAppend(ab, "\x1b[K", 3);
+    abAppend(ab, "\r\n", 2);
+  }
+}
+
+static void editorDrawStatusBar(struct abuf *ab) {
+  abAppend(ab, "\x1b[7m", 4);
+  char status[80], rstatus[80];
+  int len, rlen;
+  if (E.finder.on) {
+    int files, matches;
+    {
+      std::lock_guard<std::mutex> guard(E.finder.lock);
+      files = E.finder.paths.size();
+      matches = E.finder.cur.candidates.size();
+    }
+    len = snprintf(status, sizeof(status), "find file - %d/%d files%s",
+      matches, files, E.finder.running ? " ..." : "");
+    rlen = snprintf(rstatus, sizeof(rstatus), "%d/%d",
+      matches ? E.finder.selected + 1 : 0, matches);
+  } else if (E.grep.on) {
+    int hits;
+    {
+      std::lock_guard<std::mutex> guard(E.grep.lock);
+      hits = E.grep.hits.size();
+    }
+    len = snprintf(status, sizeof(status), "grep \"%.30s\" - %d hits in %d files%s",
+      E.grep.query.c_str(), hits, (int)E.grep.files,
+      E.grep.running ? " ..." : "");
+    rlen = snprintf(rstatus, sizeof(rstatus), "%d/%d",
+      hits ? E.grep.selected + 1 : 0, hits);
+  } else if (E.hex.on) {
+    len = snprintf(status, sizeof(status), "%.20s - %lld bytes %s",
+      E.filename, (long long)E.hex.size,
+      E.hex.dirty ? "(modified)" : E.hex.writable ? "" : "(read-only)");
+    rlen = snprintf(rstatus, sizeof(rstatus), "hex | 0x%llx/0x%llx",
+      (long long)E.hex.cursor, (long long)E.hex.size);
+  } else if (!E.cursors.extra.empty()) {
+    len = snprintf(status, sizeof(status), "%.20s - %d lines %s",
+      E.filename ? E.filename : "[No Name]", E.numrows,
+      E.dirty ? "(modified)" : "");
+    rlen = snprintf(rstatus, sizeof(rstatus), "%d cursors | %d/%d",
+      (int)E.cursors.extra.size() + 1, E.cy + 1, E.numrows);
+  } else {
+    len = snprintf(status, sizeof(status), "%.20s - %d lines %s",
+      E.filename ? E.filename : "[No Name]", E.numrows,
+      E.dirty ? "(modified)" : "");
+    rlen = snprintf(rstatus, sizeof(rstatus), "%s | %d/%d @%lld",
+      E.syntax ? E.syntax->filetype : "no ft", E.cy + 1, E.numrows,
+      editorRowOffset(E.cy) + E.cx);
+  }
+  if (len > E.screencols) len = E.screencols;
+  abAppend(ab, status, len);
+  while (len < E.screencols) {
+    if (E.screencols - len == rlen) {
+      abAppend(ab, rstatus, rlen);
+      break;
+    } else {
+      abAppend(ab, " ", 1);
+      len++;
+    }
+  }
+  abAppend(ab, "\x1b[m", 3);
+  abAppend(ab, "\r\n", 2);
+}
+
+static void editorDrawMessageBar(struct abuf *ab) {
+  abAppend(ab, "\x1b[K", 3);
+  int msglen = strlen(E.statusmsg);
+  if (msglen > E.screencols) msglen = E.screencols;
+  if (msglen && time(NULL) - E.statusmsg_time < 5)
+    abAppend(ab, E.statusmsg, msglen);
+}
+
+/* Set by SIGWINCH; the new size is picked up on the next refresh. */
+static volatile sig_atomic_t winch = 0;
+
+static void editorHandleWinch(int) {
+  winch = 1;
+}
+
+static void editorHandleUsr1(int) {
+  editorStatsRequestDump();
+}
+
+/* Appends the escape sequences that redraw the whole screen to ab. */
+void editorDrawFrame(struct abuf *ab) {
+  if (E.finder.on) {
+    editorFinderScroll();
+  } else if (E.grep.on) {
+    editorGrepScroll();
+  } else if (E.hex.on) {
+    editorHexScroll();
+  } else {
+    editorScroll();
+  }
+
+  abAppend(ab, "\x1b[?25l", 6);
+  abAppend(ab, "\x1b[H", 3);
+
+  if (E.finder.on) editorFinderDrawRows(ab);
+  else if (E.grep.on) editorGrepDrawRows(ab);
+  else if (E.hex.on) editorHexDrawRows(ab);
+  else editorDrawRows(ab);
+  editorDrawStatusBar(ab);
+  editorDrawMessageBar(ab);
+  if (E.stats) editorStatsDraw(ab);
+
+  char buf[32];
+  int gutter = editorDiffGutter();
+  if (E.finder.on) {
+    int y, x;
+    editorFinderCursor(&y, &x);
+    snprintf(buf, sizeof(buf), "\x1b[%d;%dH", y + 1, x + 1);
+  } else if (E.grep.on) {
+    snprintf(buf, sizeof(buf), "\x1b[%d;1H", E.grep.selected - E.grep.top + 1);
+  } else if (E.hex.on) {
+    int y, x;
+    editorHexCursor(&y, &x);
+    snprintf(buf, sizeof(buf), "\x1b[%d;%dH", y + 1, x + 1);
+  } else if (E.wrap) {
+    snprintf(buf, sizeof(buf), "\x1b[%d;%dH", (int)(E.vcy - E.vrowoff) + 1,
+                                              E.vcx + gutter + 1);
+  } else {
+    snprintf(buf, sizeof(buf), "\x1b[%d;%dH", (E.cy - E.rowoff) + 1,
+                                              (E.rx - E.coloff) + gutter + 1);
+  }
+  abAppend(ab, buf, strlen(buf));
+
+  abAppend(ab, "\x1b[?25h", 6);
+}
+
+void editorRefreshScreen() {
+  if (winch) {
+    winch = 0;
+    int rows, cols;
+    if (getWindowSize(&rows, &cols) == 0) {
+      E.screenrows = rows - 2;
+      E.screencols = cols;
+    }
+  }
+
+  if (!E.plugins.loaded.empty()) editorPluginsFlush();
+
+  struct abuf ab = ABUF_INIT;
+  {
+    PROBE(PROBE_FRAME);
+    editorDrawFrame(&ab);
+  }
+  {
+    PROBE(PROBE_WRITE);
+    termWrite(ab.b, ab.len);
+  }
+  abFree(&ab);
+}
+
+void editorSetStatusMessage(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(E.statusmsg, sizeof(E.statusmsg), fmt, ap);
+  va_end(ap);
+  E.statusmsg_time = time(NULL);
+}
+
+/* Wakes the main loop from a worker thread; see E.wakefd. */
+void editorWake() {
+  if (E.wakefd == -1) return;
+  uint64_t one = 1;
+  if (write(E.wakefd, &one, sizeof(one)) == -1) return;
+}
+
+/* How long editorReadKey waits for a key before it reports IDLE_EVENT,
+ * or -1 while there is no work put off until the user pauses. */
+int editorIdleTimeout() {
+  if (E.diff.on && (E.diff.stale || E.diff.diskstale)) return DIFF_IDLE_MS;
+  return -1;
+}
+
+/*** input ***/
+
+char *editorPrompt(const char *prompt, void (*callback)(char *, int)) {
+  size_t bufsize = 128;
+  char *buf = (char *)malloc(bufsize);
+
+  size_t buflen = 0;
+  buf[0] = '\0';
+  E.prompts++;
+
+  while (1) {
+    editorSetStatusMessage(prompt, buf);
+    editorRefreshScreen();
+
+    int c = editorReadKey();
+    if (c == WATCH_EVENT) {
+      editorFileEvent(0);
+      continue;
+    }
+    if (c == WAKE_EVENT) {
+      editorStatsPoll();
+      continue;
+    }
+    if (c == IDLE_EVENT) {
+      editorDiffIdle();
+      continue;
+    }
+    if (c == DEL_KEY || c == CTRL_KEY('h') || c == BACKSPACE) {
+      if (buflen != 0) buf[--buflen] = '\0';
+    } else if (c == '\x1b') {
+      editorSetStatusMessage("");
+      if (callback) callback(buf, c);
+      free(buf);
+      return NULL;
+    } else if (c == '\r') {
+      if (buflen != 0) {
+        editorSetStatusMessage("");
+        if (callback) callback(buf, c);
+        return buf;
+      }
+    } else if (c < 256 && !iscntrl(c)) {
+      if (buflen == bufsize - 1) {
+        bufsize *= 2;
+        buf = (char *)realloc(buf, bufsize);
+      }
+      buf[buflen++] = c;
+      buf[buflen] = '\0';
+    }
+
+    if (callback) callback(buf, c);
+  }
+}
+
+/* Puts the cursor on visual line line, as close to column col as the
+ * line allows. */
+static void editorMoveToVisual(long long line, int col) {
+  if (line < 0) line = 0;
+  if (line > editorWrapTotal()) line = editorWrapTotal();
+
+  int sub;
+  E.cy = editorWrapRowOf(line, &sub);
+  if (E.cy >= E.numrows) {
+    E.cx = 0;
+    return;
+  }
+  erow *row = &E.row[E.cy];
+  int lines = editorWrapRefine(E.cy);
+  if (sub >= lines) sub = lines - 1;
+  int rx = editorWrapToRx(row, sub, col, E.layout.width);
+  E.cx = editorRowRxToCx(row, rx);
+}
+
+static void editorMoveVisual(int delta) {
+  int sub = 0;
+  int col = 0;
+  if (E.cy < E.numrows) {
+    erow *row = &E.row[E.cy];
+    editorWrapRefine(E.cy);
+    editorWrapLocate(row, editorRowCxToRx(row, E.cx), E.layout.width,
+                     &sub, &col);
+  }
+  editorMoveToVisual(editorWrapLineOf(E.cy) + sub + delta, col);
+}
+
+static void editorClampCursor() {
+  erow *row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
+  int rowlen = row ? row->size : 0;
+  if (E.cx > rowlen) {
+    E.cx = rowlen;
+  }
+}
+
+/* Moves the cursor to row cy, keeping its display column rather than its
+ * byte offset, which on another row could fall inside a character. */
+static void editorMoveToRow(int cy) {
+  int rx = E.cy < E.numrows ? editorRowCxToRx(&E.row[E.cy], E.cx) : 0;
+  E.cy = cy;
+  E.cx = cy < E.numrows ? editorRowRxToCx(&E.row[cy], rx) : 0;
+}
+
+void editorMoveCursor(int key) {
+  erow *row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
+
+  switch (key) {
+    case ARROW_LEFT:
+      if (E.cx != 0) {
+        E.cx = editorRowPrevCx(row, E.cx);
+      } else if (E.cy > 0) {
+        E.cy--;
+        E.cx = E.row[E.cy].size;
+      }
+      break;
+    case ARROW_RIGHT:
+      if (row && E.cx < row->size) {
+        E.cx = editorRowNextCx(row, E.cx);
+      } else if (row && E.cx == row->size) {
+        E.cy++;
+        E.cx = 0;
+      }
+      break;
+    case ARROW_UP:
+      if (E.wrap) {
+        editorMoveVisual(-1);
+      } else if (E.cy != 0) {
+        editorMoveToRow(E.cy - 1);
+      }
+      break;
+    case ARROW_DOWN:
+      if (E.wrap) {
+        editorMoveVisual(1);
+      } else if (E.cy < E.numrows) {
+        editorMoveToRow(E.cy + 1);
+      }
+      break;
+  }
+
+  editorClampCursor();
+}
+
+static void editorProcessKey(int c) {
+  static int quit_times = BYTE_WRITER_QUIT_TIMES;
+
+  if (E.finder.on && c != CTRL_KEY('q')) {
+    if (c == WATCH_EVENT) {
+      editorFileEvent(0);
+      return;
+    }
+    editorFinderProcessKey(c);
+    quit_times = BYTE_WRITER_QUIT_TIMES;
+    return;
+  }
+  if (E.grep.on && c != CTRL_KEY('q')) {
+    if (c == WATCH_EVENT) {
+      editorFileEvent(0);
+      return;
+    }
+    editorGrepProcessKey(c);
+    quit_times = BYTE_WRITER_QUIT_TIMES;
+    return;
+  }
+  if (E.hex.on && c != CTRL_KEY('q')) {
+    if (c == WATCH_EVENT) {
+      editorFileEvent(0);
+      return;
+    }
+    editorHexProcessKey(c);
+    quit_times = BYTE_WRITER_QUIT_TIMES;
+    return;
+  }
+  if (E.watch.pending && c != WATCH_EVENT) editorReload();
+  if (c != CTRL_KEY('n')) E.words.active = 0;
+  if (!E.cursors.extra.empty() && editorCursorsProcessKey(c)) {
+    quit_times = BYTE_WRITER_QUIT_TIMES;
+    return;
+  }
+
+  switch (c) {
+    case '\r':
+      editorInsertNewline();
+      break;
+
+    case CTRL_KEY('q'):
+      if ((E.dirty || E.hex.dirty) && quit_times > 0) {
+        editorSetStatusMessage("WARNING!!! File has unsaved changes. "
+          "Press Ctrl-Q %d more times to quit.", quit_times);
+        quit_times--;
+        return;
+      }
+      termWrite("\x1b[2J", 4);
+      termWrite("\x1b[H", 3);
+      exit(0);
+      break;
+
+    case CTRL_KEY('s'):
+      editorSave();
+      break;
+
+    case HOME_KEY:
+      E.cx = 0;
+      break;
+
+    case END_KEY:
+      if (E.cy < E.numrows)
+        E.cx = E.row[E.cy].size;
+      break;
+
+    case CTRL_KEY('f'):
+      editorFind();
+      break;
+
+    case CTRL_KEY('g'):
+      editorGoto();
+      break;
+
+    case CTRL_KEY('r'):
+      editorGrep();
+      break;
+
+    case CTRL_KEY('p'):
+      editorFinder();
+      break;
+
+    case CTRL_KEY('n'):
+      editorComplete();
+      break;
+
+    case CTRL_KEY('e'):
+      editorCursorsFind();
+      break;
+
+    case CTRL_KEY('b'):
+      editorCursorsAddBelow();
+      break;
+
+    case CTRL_KEY('z'):
+      editorUndo();
+      break;
+
+    case CTRL_KEY('y'):
+      editorStatsToggle();
+      break;
+
+    case CTRL_KEY('w'):
+      editorToggleWrap();
+      break;
+
+    case CTRL_KEY('d'):
+      editorToggleDiff();
+      break;
+
+    case CTRL_KEY('x'):
+      editorToggleHex();
+      break;
+
+    case CTRL_KEY('t'):
+      editorToggleFollow();
+      break;
+
+    case WATCH_EVENT:
+      editorFileEvent(1);
+      return;
+
+    case BACKSPACE:
+    case CTRL_KEY('h'):
+    case DEL_KEY:
+      if (c == DEL_KEY) editorMoveCursor(ARROW_RIGHT);
+      editorDelChar();
+      break;
+
+    case PAGE_UP:
+    case PAGE_DOWN:
+      /* Go to the edge of the screen, then a screenful further. */
+      if (E.wrap) {
+        long long line = c == PAGE_UP ? E.vrowoff - E.screenrows
+                                      : E.vrowoff + 2 * E.screenrows - 1;
+        editorMoveToVisual(line, E.vcx);
+      } else {
+        int cy;
+        if (c == PAGE_UP) {
+          cy = E.rowoff - E.screenrows;
+          if (cy < 0) cy = 0;
+        } else {
+          cy = E.rowoff + 2 * E.screenrows - 1;
+          if (cy > E.numrows) cy = E.numrows;
+        }
+        editorMoveToRow(cy);
+      }
+      break;
+
+    case ARROW_UP:
+    case ARROW_DOWN:
+    case ARROW_LEFT:
+    case ARROW_RIGHT:
+      editorMoveCursor(c);
+      break;
+
+    case CTRL_KEY('l'):
+    case '\x1b':
+      break;
+
+    default:
+      editorInsertChar(c);
+      break;
+  }
+
+  quit_times = BYTE_WRITER_QUIT_TIMES;
+}
+
+void editorProcessKeypress() {
+  int c = editorReadKey();
+  if (c == WAKE_EVENT) {
+    editorStatsPoll();
+    return;
+  }
+  if (c == IDLE_EVENT) {
+    editorDiffIdle();
+    return;
+  }
+  PROBE_NAMED(probe, PROBE_KEY);
+  int prompts = E.prompts;
+  editorProcessKey(c);
+  if (E.prompts != prompts) PROBE_DROP(probe);
+}
+
+/*** init ***/
+
+/* Sets up E for an empty buffer, without touching the terminal. */
+void initEditorState() {
+  E.cx = 0;
+  E.cy = 0;
+  E.rx = 0;
+  E.rowoff = 0;
+  E.coloff = 0;
+  E.wrap = 0;
+  E.vrowoff = 0;
+  E.vcy = 0;
+  E.vcx = 0;
+  E.numrows = 0;
+  E.rowcap = 0;
+  E.row = NULL;
+  E.stats = 0;
+  E.plugins.events = 0;
+  E.plugins.overflow = 0;
+  E.plugins.stopping = 0;
+  E.hlrows = 0;
+  E.map = NULL;
+  E.maplen = 0;
+  E.mapfd = -1;
+  E.watch.fd = -1;
+  E.watch.dirwd = -1;
+  E.watch.filewd = -1;
+  E.watch.pending = 0;
+  E.follow.fd = -1;
+  E.diff.on = 0;
+  E.diff.stale = 0;
+  E.diff.diskstale = 1;
+  E.hex.on = 0;
+  E.hex.fd = -1;
+  E.hex.window = NULL;
+  E.hex.dirty = 0;
+  E.grep.on = 0;
+  E.grep.running = 0;
+  E.grep.cancel = 0;
+  E.grep.files = 0;
+  E.grep.selected = 0;
+  E.grep.top = 0;
+  E.finder.on = 0;
+  E.finder.running = 0;
+  E.finder.cancel = 0;
+  E.finder.loaded = 0;
+  E.finder.cur.scanned = 0;
+  E.finder.selected = 0;
+  E.finder.scroll = 0;
+  E.words.built = 0;
+  E.words.active = 0;
+  E.undo.bytes = 0;
+  E.undo.depth = 0;
+  E.undo.replaying = 0;
+  E.wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  /* Registered after E is constructed, so these run before E's
+   * destructor, which must not meet a running search or scan. */
+  atexit(editorGrepStop);
+  atexit(editorFinderStop);
+  fwInit(&E.lines, NULL, 0);
+  E.dirty = 0;
+  E.filename = NULL;
+  E.statusmsg[0] = '\0';
+  E.statusmsg_time = 0;
+  E.prompts = 0;
+  E.syntax = NULL;
+}
+
+void initEditor() {
+  initEditorState();
+  if (getWindowSize(&E.screenrows, &E.screencols) == -1) die("getWindowSize");
+  E.screenrows -= 2;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = editorHandleWinch;
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGWINCH, &sa, NULL);
+  sa.sa_handler = editorHandleUsr1;
+  sigaction(SIGUSR1, &sa, NULL);
+}
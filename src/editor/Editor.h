@@ -1,2 +1,122 @@
+#pragma once
 
+#include <termios.h>
+#include <ctime>
+#include <vector>
 
+#include "Arena.h"
+#include "Cursors.h"
+#include "DiffView.h"
+#include "Fenwick.h"
+#include "FileIO.h"
+#include "Finder.h"
+#include "Follow.h"
+#include "Grep.h"
+#include "Hex.h"
+#include "LineIndex.h"
+#include "Plugin.h"
+#include "Row.h"
+#include "Syntax.h"
+#include "Undo.h"
+#include "Words.h"
+#include "Wrap.h"
+
+struct abuf;
+
+#define BYTE_WRITER_VERSION "0.0.1"
+#define BYTE_WRITER_QUIT_TIMES 3
+
+/*** data ***/
+
+struct editorConfig {
+  int cx, cy;
+  int rx;
+  int rowoff;
+  int coloff;
+  /* While soft wrap is on, scrolling counts visual lines: vrowoff is the
+   * first one on screen and vcy/vcx the cursor's line and column. */
+  int wrap;
+  long long vrowoff;
+  long long vcy;
+  int vcx;
+  struct wrapLayout layout;
+  struct diffView diff;
+  struct hexView hex;
+  struct grepState grep;
+  struct finderState finder;
+  struct wordIndex words;
+  struct cursorSet cursors;
+  struct undoLog undo;
+  struct pluginHost plugins;
+  /* Whether the stats overlay (Ctrl-Y, see Stats.h) is shown. */
+  int stats;
+  int screenrows;
+  int screencols;
+  int numrows;
+  int rowcap;
+  erow *row;
+  /* Rows [0, hlrows) have render and hl up to date; see editorPrepareRows.
+   * map is the private copy of the file that borrowed rows point into,
+   * read from mapfd a chunk at a time as mapready marks (see
+   * editorMapLoad). */
+  int hlrows;
+  char *map;
+  size_t maplen;
+  int mapfd;
+  std::vector<unsigned char> mapready;
+  struct fileWatch watch;
+  struct followState follow;
+  /* An eventfd that worker threads write to wake the main loop. */
+  int wakefd;
+  struct fenwick lines;
+  struct arena arena;
+  int dirty;
+  char *filename;
+  char statusmsg[80];
+  time_t statusmsg_time;
+  /* Counts editorPrompt calls, which tells a key that opened a prompt
+   * apart from the others (see PROBE_KEY). */
+  int prompts;
+  struct editorSyntax *syntax;
+  struct termios orig_termios;
+};
+
+extern struct editorConfig E;
+
+/* Queues an event for plugins (see Plugin.h): with none subscribed to
+ * type, a single test. */
+inline void editorPluginEvent(int type, int kind, int row, int count) {
+  if (E.plugins.events & type) editorPluginQueue(type, kind, row, count);
+}
+
+/*** editor operations ***/
+
+void editorInsertChar(int c);
+void editorInsertNewline();
+void editorDelChar();
+
+/*** find ***/
+
+void editorFind();
+void editorGoto();
+
+/*** output ***/
+
+void editorToggleWrap();
+void editorScroll();
+void editorDrawFrame(struct abuf *ab);
+void editorRefreshScreen();
+void editorWake();
+int editorIdleTimeout();
+void editorSetStatusMessage(const char *fmt, ...);
+
+/*** input ***/
+
+char *editorPrompt(const char *prompt, void (*callback)(char *, int));
+void editorMoveCursor(int key);
+void editorProcessKeypress();
+
+/*** init ***/
+
+void initEditorState();
+void initEditor();
@@ -1,2 +1,651 @@
+#include "FileIO.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
 
+#include "Arena.h"
+#include "Editor.h"
+#include "Hash.h"
+#include "Helpers.h"
+#include "Probe.h"
+#include "Sidecar.h"
+#include "Utf8.h"
+
+/* Rows are gathered into writes of about this many bytes when saving. */
+#define SAVE_CHUNK (1 << 20)
+
+/* Borrowed text is read from the file this many bytes at a time. */
+#define BORROW_CHUNK (1 << 20)
+
+/* Returns the document as one string of *buflen bytes, or NULL if it does
+ * not fit in memory. */
+char *editorRowsToString(size_t *buflen) {
+  size_t totlen = editorDocumentSize();
+  *buflen = totlen;
+
+  char *buf = (char *)malloc(totlen ? totlen : 1);
+  if (buf == NULL) return NULL;
+  char *p = buf;
+  for (int j = 0; j < E.numrows; j++) {
+    memcpy(p, editorRowChars(&E.row[j]), E.row[j].size);
+    p += E.row[j].size;
+    *p = '\n';
+    p++;
+  }
+
+  return buf;
+}
+
+static int editorWriteAll(int fd, const char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, buf, len);
+    if (n == -1) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    buf += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* Writes the document to fd a chunk of rows at a time, so that saving
+ * never holds a second copy of the whole file. */
+static int editorWriteRows(int fd) {
+  std::vector<char> buf;
+  buf.reserve(SAVE_CHUNK);
+  for (int j = 0; j < E.numrows; j++) {
+    erow *row = &E.row[j];
+    const char *chars = editorRowChars(row);
+    if (buf.size() + row->size + 1 > SAVE_CHUNK && !buf.empty()) {
+      if (editorWriteAll(fd, buf.data(), buf.size()) == -1) return -1;
+      buf.clear();
+    }
+    if ((size_t)row->size >= SAVE_CHUNK) {
+      if (editorWriteAll(fd, chars, row->size) == -1) return -1;
+    } else {
+      buf.insert(buf.end(), chars, chars + row->size);
+    }
+    buf.push_back('\n');
+  }
+  return editorWriteAll(fd, buf.data(), buf.size());
+}
+
+/* Whether a sidecar line index may be used for a file of this size. Small
+ * files scan faster than the index can be checked. */
+static int editorSidecarWanted(off_t size) {
+  return size >= BYTE_WRITER_SIDECAR_MIN && getenv("BYTE_WRITER_NO_CACHE") == NULL;
+}
+
+static void editorFingerprint(const struct stat *st) {
+  E.watch.dev = st->st_dev;
+  E.watch.ino = st->st_ino;
+  E.watch.size = st->st_size;
+  E.watch.mtime = st->st_mtim;
+}
+
+static int editorFingerprintMatches(const struct stat *st) {
+  return E.watch.dev == st->st_dev && E.watch.ino == st->st_ino &&
+         E.watch.size == st->st_size &&
+         E.watch.mtime.tv_sec == st->st_mtim.tv_sec &&
+         E.watch.mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/* Reads size bytes of fd into anonymous memory. A mapping of the file
+ * itself would change while it is read whenever another program writes
+ * to it, and fault (SIGBUS) once it is truncated. */
+static char *editorSnapshot(int fd, size_t size) {
+  void *map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) return NULL;
+  char *buf = (char *)map;
+  size_t got = 0;
+  while (got < size) {
+    ssize_t n = pread(fd, buf + got, size - got, got);
+    if (n == -1 && errno == EINTR) continue;
+    if (n <= 0) {
+      if (n == 0) errno = EIO;
+      munmap(map, size);
+      return NULL;
+    }
+    got += n;
+  }
+  mprotect(map, size, PROT_READ);
+  return buf;
+}
+
+/* Reads chunk c of E.map from the file. Past the end of a file cut short
+ * since it was opened the text is gone, and reads as '?' instead of
+ * faulting (SIGBUS) as a mapping of the file itself would. */
+static void editorMapRead(size_t c) {
+  size_t off = c * BORROW_CHUNK;
+  size_t len = std::min((size_t)BORROW_CHUNK, E.maplen - off);
+  size_t avail = 0;
+  struct stat st;
+  if (fstat(E.mapfd, &st) == 0 && (size_t)st.st_size > off)
+    avail = std::min(len, (size_t)st.st_size - off);
+  size_t got = 0;
+  while (got < avail) {
+    ssize_t n = pread(E.mapfd, E.map + off + got, avail - got, off + got);
+    if (n == -1 && errno == EINTR) continue;
+    if (n <= 0) break;
+    got += n;
+  }
+  memset(E.map + off + got, '?', len - got);
+  E.mapready[c] = 1;
+}
+
+/* Reads the chunks under a borrowed row that have not been read yet, so
+ * that opening a file costs the same however large it is and only the
+ * text that is shown, searched or saved is ever copied. */
+void editorMapLoad(const erow *row) {
+  size_t at = row->chars - E.map;
+  size_t end = (at + row->size + BORROW_CHUNK - 1) / BORROW_CHUNK;
+  for (size_t c = at / BORROW_CHUNK; c < end; c++)
+    if (!E.mapready[c]) editorMapRead(c);
+  const_cast<erow *>(row)->borrowed = 2;
+}
+
+/* Whether text the rows have not read yet is gone because the file they
+ * borrow from was rewritten in place as st. */
+static int editorMapLost(const struct stat *st) {
+  struct stat map;
+  if (E.map == NULL) return 0;
+  if (fstat(E.mapfd, &map) == -1) return 1;
+  if (map.st_dev != st->st_dev || map.st_ino != st->st_ino) return 0;
+  return std::find(E.mapready.begin(), E.mapready.end(), 0) !=
+         E.mapready.end();
+}
+
+void editorMapClose() {
+  if (E.map == NULL) return;
+  munmap(E.map, E.maplen);
+  close(E.mapfd);
+  E.map = NULL;
+  E.maplen = 0;
+  E.mapfd = -1;
+  E.mapready.clear();
+}
+
+/* Loads the rows from a valid sidecar index, borrowing their text from a
+ * copy of the file that is read as the rows are, instead of scanning it
+ * for newlines. Keeps fd open for that on success. */
+static int editorOpenIndexed(const char *filename, int fd,
+                             const struct stat *st) {
+  struct sidecarIndex idx;
+  if (sidecarOpen(filename, fd, st, &idx) == -1) return -1;
+
+  void *map = mmap(NULL, st->st_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (map == MAP_FAILED) {
+    sidecarClose(&idx);
+    return -1;
+  }
+  E.map = (char *)map;
+  E.maplen = st->st_size;
+  E.mapfd = fd;
+  E.mapready.assign((E.maplen + BORROW_CHUNK - 1) / BORROW_CHUNK, 0);
+  editorAppendBorrowedRows(E.map, idx.offsets, idx.lens, idx.nlines);
+  if (idx.invalid)
+    editorSetStatusMessage("%d lines are not valid UTF-8 (shown as ?)",
+                           idx.invalid);
+  sidecarClose(&idx);
+  return 0;
+}
+
+void editorOpen(const char *filename) {
+  free(E.filename);
+  E.filename = strdup(filename);
+
+  editorSelectSyntaxHighlight();
+
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1) die("open");
+  struct stat st;
+  if (fstat(fd, &st) == -1) die("fstat");
+  editorFingerprint(&st);
+  editorWatchFile();
+
+  int sidecar = editorSidecarWanted(st.st_size);
+  if (sidecar && editorOpenIndexed(filename, fd, &st) == 0) {
+    E.dirty = 0;
+    editorPluginEvent(BW_EV_OPEN, 0, 0, E.numrows);
+    return;
+  }
+
+  FILE *fp = fdopen(fd, "r");
+  if (!fp) die("fdopen");
+
+  std::vector<unsigned long long> offsets;
+  std::vector<unsigned> lens;
+  unsigned long long offset = 0;
+  char *line = NULL;
+  size_t linecap = 0;
+  ssize_t linelen;
+  int invalid = 0;
+  while ((linelen = getline(&line, &linecap, fp)) != -1) {
+    ssize_t rawlen = linelen;
+    while (linelen > 0 && (line[linelen - 1] == '\n' ||
+                           line[linelen - 1] == '\r'))
+      linelen--;
+    if (utf8Validate(line, linelen) != (size_t)linelen) invalid++;
+    editorInsertRow(E.numrows, line, linelen);
+    if (sidecar) {
+      offsets.push_back(offset);
+      lens.push_back(linelen);
+    }
+    offset += rawlen;
+  }
+  free(line);
+  if (sidecar)
+    sidecarWrite(filename, fd, &st, offsets.data(), lens.data(),
+                 offsets.size(), invalid);
+  fclose(fp);
+  E.dirty = 0;
+  editorPluginEvent(BW_EV_OPEN, 0, 0, E.numrows);
+
+  if (invalid)
+    editorSetStatusMessage("%d lines are not valid UTF-8 (shown as ?)",
+                           invalid);
+}
+
+/* Drops the buffer and everything tied to its file, leaving an empty
+ * unnamed document for editorOpen. */
+void editorCloseFile() {
+  editorFollowStop(NULL);
+  editorWordsFree();
+  editorCursorsClear();
+  editorUndoClear();
+  if (E.plugins.events) editorPluginsReset();
+  for (int i = 0; i < E.numrows; i++) editorFreeRow(&E.row[i]);
+  E.numrows = 0;
+  E.hlrows = 0;
+  /* Every block was a row's, so the chunks can go back all at once. */
+  if (E.arena.inuse == 0) arenaFreeAll(&E.arena);
+  fwInit(&E.lines, NULL, 0);
+  if (E.wrap) editorWrapBuild(E.layout.width);
+  editorMapClose();
+  E.cx = E.cy = 0;
+  E.rowoff = E.coloff = 0;
+  E.vrowoff = 0;
+  free(E.filename);
+  E.filename = NULL;
+  E.syntax = NULL;
+  editorDiffReset();
+  E.watch.pending = 0;
+  E.dirty = 0;
+}
+
+/* Replaces the buffer with filename unless that is already the open
+ * file. Returns -1, with a message, if it cannot be opened or the buffer
+ * has unsaved changes. */
+int editorSwitchFile(const char *filename) {
+  if (E.filename && strcmp(E.filename, filename) == 0) return 0;
+  if (E.dirty) {
+    editorSetStatusMessage("Save the buffer before opening another file");
+    return -1;
+  }
+  if (access(filename, R_OK) == -1) {
+    editorSetStatusMessage("Can't open %s: %s", filename, strerror(errno));
+    return -1;
+  }
+  editorCloseFile();
+  editorOpen(filename);
+  return 0;
+}
+
+/* Refreshes the sidecar of a file just written from the rows, which
+ * already know where every line starts. */
+static void editorSaveSidecar(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) == -1 || !editorSidecarWanted(st.st_size)) return;
+
+  std::vector<unsigned long long> offsets(E.numrows);
+  std::vector<unsigned> lens(E.numrows);
+  unsigned long long offset = 0;
+  for (int j = 0; j < E.numrows; j++) {
+    offsets[j] = offset;
+    lens[j] = E.row[j].size;
+    offset += E.row[j].size + 1;
+  }
+  sidecarWrite(E.filename, fd, &st, offsets.data(), lens.data(), E.numrows,
+               0);
+}
+
+void editorSave() {
+  if (E.filename == NULL) {
+    E.filename = editorPrompt("Save as: %s (ESC to cancel)", NULL);
+    if (E.filename == NULL) {
+      editorSetStatusMessage("Save aborted");
+      return;
+    }
+    editorSelectSyntaxHighlight();
+  }
+
+  PROBE(PROBE_SAVE);
+  long long len = editorDocumentSize();
+
+  /* Files opened from a sidecar index are large, so they are written to a
+   * new file that replaces the old one, and a save that fails part way
+   * leaves the file as it was. */
+  char *tmp = NULL;
+  int flags = O_RDWR | O_CREAT;
+  mode_t mode = 0644;
+  if (E.map) {
+    struct stat st;
+    if (stat(E.filename, &st) == 0) mode = st.st_mode & 07777;
+    tmp = (char *)malloc(strlen(E.filename) + 8);
+    sprintf(tmp, "%s.bw-new", E.filename);
+    flags |= O_TRUNC;
+  }
+
+  int fd = open(tmp ? tmp : E.filename, flags, mode);
+  if (fd != -1) {
+    if (ftruncate(fd, len) != -1) {
+      if (editorWriteRows(fd) == 0 &&
+          (tmp == NULL || rename(tmp, E.filename) == 0)) {
+        struct stat st;
+        if (fstat(fd, &st) == 0) editorFingerprint(&st);
+        editorWatchFile();
+        editorSaveSidecar(fd);
+        editorDiffDiskChanged();
+        close(fd);
+        free(tmp);
+        E.dirty = 0;
+        editorSetStatusMessage("%lld bytes written to disk", len);
+        editorPluginEvent(BW_EV_SAVE, 0, 0, E.numrows);
+        return;
+      }
+    }
+    close(fd);
+  }
+
+  int err = errno;
+  if (tmp) unlink(tmp);
+  free(tmp);
+  editorSetStatusMessage("Can't save! I/O error: %s", strerror(err));
+}
+
+/*** change detection ***/
+
+static int editorWatchPath(int wd, const char *path, uint32_t mask) {
+  int nwd = inotify_add_watch(E.watch.fd, path, mask);
+  if (wd != -1 && wd != nwd) inotify_rm_watch(E.watch.fd, wd);
+  return nwd;
+}
+
+/* Points the watches at E.filename, which may have been renamed or
+ * replaced since they were set up. */
+void editorWatchFile() {
+  if (E.filename == NULL) return;
+  if (E.watch.fd == -1) {
+    E.watch.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (E.watch.fd == -1) return;
+  }
+
+  std::string dir(E.filename);
+  size_t slash = dir.rfind('/');
+  dir = slash == std::string::npos ? "." : slash == 0 ? "/" : dir.substr(0, slash);
+  E.watch.dirwd = editorWatchPath(E.watch.dirwd, dir.c_str(),
+                                  IN_CLOSE_WRITE | IN_MOVED_TO);
+
+  if (E.follow.fd != -1) {
+    E.watch.filewd = editorWatchPath(E.watch.filewd, E.filename,
+                                     IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
+  } else if (E.watch.filewd != -1) {
+    inotify_rm_watch(E.watch.fd, E.watch.filewd);
+    E.watch.filewd = -1;
+  }
+}
+
+/* Drains the inotify queue. Writes to a followed file are appended (see
+ * Follow.h); otherwise a file that was rewritten or replaced is reloaded,
+ * or, unless reload is set, marked pending. */
+void editorFileEvent(int reload) {
+  if (E.watch.fd == -1 || E.filename == NULL) return;
+  const char *base = strrchr(E.filename, '/');
+  base = base ? base + 1 : E.filename;
+
+  alignas(struct inotify_event) char events[4096];
+  ssize_t n;
+  int written = 0, gone = 0, replaced = 0;
+  while ((n = read(E.watch.fd, events, sizeof(events))) > 0) {
+    for (char *p = events; p < events + n;) {
+      struct inotify_event *ev = (struct inotify_event *)p;
+      if (ev->wd == E.watch.filewd) {
+        if (ev->mask & IN_MODIFY) written = 1;
+        if (ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF)) gone = 1;
+      } else if (ev->wd == E.watch.dirwd && ev->len &&
+                 strcmp(ev->name, base) == 0) {
+        replaced = 1;
+      }
+      p += sizeof(*ev) + ev->len;
+    }
+  }
+
+  if (written || replaced) editorDiffDiskChanged();
+  if (E.follow.fd != -1) {
+    if (written) editorFollowRead();
+    if (gone) editorFollowStop("file was moved or deleted");
+    return;
+  }
+  if (replaced) E.watch.pending = 1;
+  if (reload && E.watch.pending) editorReload();
+}
+
+/*** reload ***/
+
+/* A chunk of lines ends after a line whose hash has these bits clear, so
+ * chunks average 64 lines and where they end depends only on the lines
+ * themselves: an edit changes the chunks around it and the rest of the
+ * file still cuts into the same chunks. */
+#define RELOAD_CHUNK_MASK 63
+#define RELOAD_CHUNK_MAX 4096
+
+struct reloadChunk {
+  uint64_t hash;
+  int start;
+  int count;
+};
+
+/* Rows [at, at + count) become new lines [from, from + n). */
+struct reloadEdit {
+  int at;
+  int count;
+  int from;
+  int n;
+};
+
+/* The new contents of the file, split into lines as editorOpen does, and
+ * the hashes of both versions line by line: the buffer's are the ones the
+ * diff view keeps (see DiffView.h). */
+struct reloadState {
+  const char *text;
+  std::vector<size_t> starts;
+  std::vector<size_t> lens;
+  const std::vector<uint64_t> *oldhash;
+  std::vector<uint64_t> newhash;
+  std::vector<reloadEdit> edits;
+};
+
+static void reloadChunks(const std::vector<uint64_t> &hashes,
+                         std::vector<reloadChunk> *chunks) {
+  reloadChunk c = {0, 0, 0};
+  for (size_t i = 0; i < hashes.size(); i++) {
+    c.hash = hashCombine(c.hash, hashes[i]);
+    c.count++;
+    if ((hashes[i] & RELOAD_CHUNK_MASK) == 0 || c.count == RELOAD_CHUNK_MAX ||
+        i + 1 == hashes.size()) {
+      chunks->push_back(c);
+      c.hash = 0;
+      c.start = i + 1;
+      c.count = 0;
+    }
+  }
+}
+
+static int reloadSameLine(reloadState *r, int at, int line) {
+  if ((*r->oldhash)[at] != r->newhash[line]) return 0;
+  erow *row = &E.row[at];
+  return (size_t)row->size == r->lens[line] &&
+         memcmp(editorRowChars(row), r->text + r->starts[line], row->size) == 0;
+}
+
+/* Records that rows [at, end) became lines [from, to), less the lines the
+ * two ranges start or end with in common. */
+static void reloadAddEdit(reloadState *r, int at, int end, int from, int to) {
+  while (at < end && from < to && reloadSameLine(r, at, from)) {
+    at++;
+    from++;
+  }
+  while (at < end && from < to && reloadSameLine(r, end - 1, to - 1)) {
+    end--;
+    to--;
+  }
+  if (at < end || from < to) r->edits.push_back({at, end - at, from, to - from});
+}
+
+/* Finds the changed line ranges. Chunks of the buffer are matched in
+ * order against the same chunks of the file; the lines between two
+ * matches are an edit. */
+static void reloadDiff(reloadState *r) {
+  int nold = r->oldhash->size();
+  int nnew = r->newhash.size();
+  std::vector<reloadChunk> a, b;
+  reloadChunks(*r->oldhash, &a);
+  reloadChunks(r->newhash, &b);
+
+  std::vector<std::pair<uint64_t, int>> lookup(b.size());
+  for (size_t j = 0; j < b.size(); j++) lookup[j] = {b[j].hash, (int)j};
+  std::sort(lookup.begin(), lookup.end());
+
+  int next = 0;
+  int at = 0, from = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    auto it = std::lower_bound(lookup.begin(), lookup.end(),
+                               std::make_pair(a[i].hash, next));
+    if (it == lookup.end() || it->first != a[i].hash) continue;
+    const reloadChunk &match = b[it->second];
+    if (match.count != a[i].count) continue;
+
+    reloadAddEdit(r, at, a[i].start, from, match.start);
+    at = a[i].start + a[i].count;
+    from = match.start + match.count;
+    next = it->second + 1;
+  }
+  reloadAddEdit(r, at, nold, from, nnew);
+}
+
+/* Brings the buffer up to date with the file on disk by replacing only
+ * the lines that changed, so rows elsewhere keep their highlighting and
+ * the cursor stays on its line. A buffer with unsaved changes is left
+ * alone. Returns 1 if the buffer changed, 0 if the file had not, and -1
+ * if it could not be reloaded. */
+int editorReload() {
+  E.watch.pending = 0;
+  if (E.filename == NULL) return 0;
+
+  int fd = open(E.filename, O_RDONLY);
+  struct stat st;
+  if (fd == -1 || fstat(fd, &st) == -1) {
+    if (fd != -1) close(fd);
+    return -1;
+  }
+  if (editorFingerprintMatches(&st)) {
+    close(fd);
+    return 0;
+  }
+  if (E.dirty) {
+    close(fd);
+    editorFingerprint(&st);
+    editorSetStatusMessage("File changed on disk; keeping unsaved changes");
+    return -1;
+  }
+
+  reloadState r;
+  r.text = NULL;
+  if (st.st_size > 0) {
+    r.text = editorSnapshot(fd, st.st_size);
+    if (r.text == NULL) {
+      close(fd);
+      editorSetStatusMessage("Can't reload: %s", strerror(errno));
+      return -1;
+    }
+  }
+  close(fd);
+
+  size_t len = st.st_size;
+  r.starts.reserve(E.numrows + 1);
+  r.lens.reserve(E.numrows + 1);
+  r.newhash.reserve(E.numrows + 1);
+  editorSplitLines(r.text, len, [&](size_t at, size_t linelen) {
+    r.starts.push_back(at);
+    r.lens.push_back(linelen);
+    r.newhash.push_back(editorDiffHash(r.text + at, linelen));
+  });
+  int nnew = r.starts.size();
+
+  /* Rows whose text was never read cannot be compared with the file that
+   * overwrote it, so they are all replaced. */
+  int full = editorMapLost(&st);
+  if (!full) {
+    r.oldhash = &editorDiffRowHashes();
+    reloadDiff(&r);
+
+    /* Past a point replacing every row is cheaper than editing most. */
+    long long changed = 0;
+    for (const reloadEdit &e : r.edits) changed += e.count + e.n;
+    full = changed > (E.numrows + nnew) / 2;
+  }
+  if (full) {
+    r.edits.clear();
+    r.edits.push_back({0, E.numrows, 0, nnew});
+  }
+
+  /* The cursor follows its line, or stays at the top of an edit that
+   * replaced it. */
+  int cy = E.cy;
+  int shift = 0;
+  for (const reloadEdit &e : r.edits) {
+    if (E.cy < e.at) break;
+    if (E.cy < e.at + e.count) {
+      int keep = E.cy - e.at;
+      cy = e.at + shift + std::min(keep, std::max(e.n - 1, 0));
+      shift = 0;
+      break;
+    }
+    shift += e.n - e.count;
+  }
+  cy += shift;
+
+  int lines = 0;
+  for (size_t i = r.edits.size(); i-- > 0;) {
+    const reloadEdit &e = r.edits[i];
+    editorReplaceRows(e.at, e.count, r.text, r.starts.data() + e.from,
+                      r.lens.data() + e.from, e.n);
+    std::copy(r.newhash.begin() + e.from, r.newhash.begin() + e.from + e.n,
+              E.diff.rows.begin() + e.at);
+    lines += std::max(e.count, e.n);
+  }
+  if (full) editorMapClose();
+  if (r.text) munmap((void *)r.text, st.st_size);
+
+  editorFingerprint(&st);
+  E.dirty = 0;
+  E.cy = std::min(cy, E.numrows);
+  int rowlen = E.cy < E.numrows ? E.row[E.cy].size : 0;
+  if (E.cx > rowlen) E.cx = rowlen;
+  editorSetStatusMessage("Reloaded from disk: %d lines changed", lines);
+  return 1;
+}
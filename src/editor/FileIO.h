@@ -1,2 +1,55 @@
+#pragma once
 
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <sys/types.h>
 
+/*** file i/o ***/
+
+/* Files at least this large get a sidecar line index (see Sidecar.h)
+ * unless BYTE_WRITER_NO_CACHE is set. */
+#define BYTE_WRITER_SIDECAR_MIN (1 << 20)
+
+/* The open file's directory is watched with inotify (fd, dirwd) so that
+ * the buffer notices when another program rewrites or replaces the file;
+ * filewd watches the file itself while it is followed (see Follow.h).
+ * editorReadKey polls fd and reports WATCH_EVENT. dev through mtime
+ * fingerprint the file as it was last read or written, which tells our
+ * own saves apart from changes made elsewhere. pending is set when a
+ * change arrived while a reload was not safe (in a prompt). */
+struct fileWatch {
+  int fd;
+  int dirwd;
+  int filewd;
+  int pending;
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  struct timespec mtime;
+};
+
+/* Calls fn(start, len) for each line of text[0, size) as editorOpen
+ * splits them: at newlines, less trailing CRs, and with no empty line
+ * after a final newline. */
+template <typename F>
+void editorSplitLines(const char *text, size_t size, F fn) {
+  for (size_t at = 0; at < size;) {
+    const char *nl = (const char *)memchr(text + at, '\n', size - at);
+    size_t end = nl ? nl - text : size;
+    size_t len = end - at;
+    while (len > 0 && text[at + len - 1] == '\r') len--;
+    fn(at, len);
+    at = end + 1;
+  }
+}
+
+char *editorRowsToString(size_t *buflen);
+void editorOpen(const char *filename);
+void editorCloseFile();
+void editorMapClose();
+int editorSwitchFile(const char *filename);
+void editorSave();
+void editorWatchFile();
+void editorFileEvent(int reload);
+int editorReload();
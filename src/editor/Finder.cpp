@@ -0,0 +1,372 @@
+#include "Finder.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#include "Buffer.h"
+#include "Editor.h"
+#include "FileIO.h"
+#include "Terminal.h"
+#include "Walker.h"
+
+/* Discovery wakes the screen once per this many paths, and when done. */
+#define FINDER_WAKE_EVERY 4096
+
+/* Scoring is spread over threads from this many paths up. */
+#define FINDER_PARALLEL_MIN 65536
+
+static inline int finderCharBit(unsigned char c) {
+  if (c >= 'a' && c <= 'z') return c - 'a';
+  if (c >= '0' && c <= '9') return 26 + c - '0';
+  return 36 + c % 28;
+}
+
+static inline unsigned char finderLower(unsigned char c) {
+  return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+static uint64_t finderMask(const std::string &s) {
+  uint64_t mask = 0;
+  for (unsigned char c : s) mask |= 1ULL << finderCharBit(c);
+  return mask;
+}
+
+/*** discovery ***/
+
+void editorFinderAdd(const char *path) {
+  size_t len = strlen(path);
+  if (len > UINT16_MAX) return;
+  const char *slash = strrchr(path, '/');
+
+  std::lock_guard<std::mutex> guard(E.finder.lock);
+  std::vector<char> &text = E.finder.text;
+  finderPath p;
+  p.off = text.size();
+  p.len = len;
+  p.base = slash ? slash - path + 1 : 0;
+  p.mask = 0;
+  text.insert(text.end(), path, path + len);
+  for (size_t i = 0; i < len; i++)
+    p.mask |= 1ULL << finderCharBit(finderLower(path[i]));
+  E.finder.paths.push_back(p);
+  if (E.finder.paths.size() % FINDER_WAKE_EVERY == 0) editorWake();
+}
+
+static void finderVisit(const char *path, void *) {
+  editorFinderAdd(path);
+}
+
+static void finderRun(std::string root) {
+  walkTree(root.c_str(), walkThreads(), finderVisit, NULL, &E.finder.cancel);
+  E.finder.running = 0;
+  editorWake();
+}
+
+/* (Re)builds the file list from the tree under root in the background. */
+void editorFinderLoad(const char *root) {
+  editorFinderStop();
+  {
+    std::lock_guard<std::mutex> guard(E.finder.lock);
+    E.finder.paths.clear();
+    E.finder.text.clear();
+  }
+  E.finder.cur = finderLevel();
+  E.finder.cur.scanned = 0;
+  E.finder.history.clear();
+  E.finder.loaded = 1;
+  E.finder.running = 1;
+  E.finder.runner = std::thread(finderRun, std::string(root));
+}
+
+void editorFinderWait() {
+  if (E.finder.runner.joinable()) E.finder.runner.join();
+}
+
+void editorFinderStop() {
+  E.finder.cancel = 1;
+  editorFinderWait();
+  E.finder.cancel = 0;
+}
+
+/*** scoring ***/
+
+/* Character classes for word-start bonuses: bonus[before][at] is what a
+ * match earns for following a character of class before. */
+enum finderClass { FC_OTHER, FC_LOWER, FC_UPPER, FC_SEP, FC_SLASH };
+
+struct finderTables {
+  unsigned char lower[256];
+  unsigned char cls[256];
+  signed char bonus[5][5];
+};
+
+static constexpr finderTables finderMakeTables() {
+  finderTables t = {};
+  for (int c = 0; c < 256; c++) {
+    t.lower[c] = c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+    t.cls[c] = c >= 'a' && c <= 'z' ? FC_LOWER :
+               c >= 'A' && c <= 'Z' ? FC_UPPER :
+               c == '/' ? FC_SLASH :
+               c == '_' || c == '-' || c == '.' || c == ' ' ? FC_SEP : FC_OTHER;
+  }
+  for (int before = 0; before < 5; before++) {
+    for (int at = 0; at < 5; at++) {
+      t.bonus[before][at] = before == FC_SLASH ? 10 :
+                            before == FC_SEP ? 8 :
+                            before == FC_LOWER && at == FC_UPPER ? 8 : 0;
+    }
+  }
+  return t;
+}
+
+static constexpr finderTables finderTable = finderMakeTables();
+
+/* Scores p against query, which is in lower case and has the character
+ * classes qmask. The match chosen is the leftmost one, tightened from its
+ * end backwards (so "fo" in "f/x/foo" matches the second f); the scoring
+ * is done on the way back. Matched characters score, more so in a row, at
+ * the start of a word or in the last path component; gaps and long paths
+ * cost a little. positions, if not NULL, receives the indexes of the
+ * matched characters. */
+static int finderMatch(const finderPath &p, const std::string &query,
+                       uint64_t qmask, int *positions) {
+  if ((p.mask & qmask) != qmask) return INT_MIN;
+  int len = p.len;
+  int m = query.size();
+  const unsigned char *path = (const unsigned char *)E.finder.text.data() + p.off;
+  const unsigned char *lower = finderTable.lower;
+  const unsigned char *q = (const unsigned char *)query.data();
+  if (m == 0) return -len;
+
+  int at = 0;
+  for (int j = 0; j < m; j++, at++) {
+    while (at < len && lower[path[at]] != q[j]) at++;
+    if (at == len) return INT_MIN;
+  }
+
+  int score = m * 16 - len / 8;
+  int next = -1;
+  at--;
+  for (int j = m - 1; j >= 0; j--, at--) {
+    while (lower[path[at]] != q[j]) at--;
+    if (positions) positions[j] = at;
+    if (next != -1) {
+      int gap = next - at - 1;
+      score += gap == 0 ? 12 : -std::min(gap, 16);
+    }
+    int before = at > 0 ? finderTable.cls[path[at - 1]] : (int)FC_SLASH;
+    score += finderTable.bonus[before][finderTable.cls[path[at]]];
+    if (at >= p.base) score += 4;
+    next = at;
+  }
+  return score;
+}
+
+std::string editorFinderPath(int i) {
+  const finderPath &p = E.finder.paths[i];
+  return std::string(E.finder.text.data() + p.off, p.len);
+}
+
+int editorFinderScore(int i, const std::string &query, int *positions) {
+  return finderMatch(E.finder.paths[i], query, finderMask(query), positions);
+}
+
+/* Brings cur up to date with the query and any paths discovered since
+ * the last call. */
+void editorFinderUpdate() {
+  std::string query(E.finder.query);
+  for (char &c : query) c = finderLower(c);
+
+  std::lock_guard<std::mutex> guard(E.finder.lock);
+  const std::vector<finderPath> &paths = E.finder.paths;
+  int n = paths.size();
+  finderLevel &cur = E.finder.cur;
+  if (query == cur.query && cur.scanned == n) return;
+
+  /* Start from the longest level whose query this one extends; the
+   * empty query of the first level extends to anything. */
+  std::vector<finderLevel> &history = E.finder.history;
+  history.push_back(std::move(cur));
+  while (query.compare(0, history.back().query.size(), history.back().query))
+    history.pop_back();
+  std::vector<int> ids;
+  if (history.back().query == query) {
+    cur = std::move(history.back());
+    history.pop_back();
+    if (cur.scanned == n) return;
+    ids.swap(cur.candidates);
+  } else {
+    ids = history.back().candidates;
+    cur.scanned = history.back().scanned;
+  }
+  for (int i = cur.scanned; i < n; i++) ids.push_back(i);
+
+  /* Large sets are split between threads in order, so that the
+   * candidates stay sorted. */
+  uint64_t qmask = finderMask(query);
+  int nthreads = ids.size() >= FINDER_PARALLEL_MIN ? walkThreads() : 1;
+  std::vector<std::vector<int>> found(nthreads);
+  std::vector<std::vector<int>> points(nthreads);
+  auto work = [&](int t) {
+    size_t lo = ids.size() * t / nthreads;
+    size_t hi = ids.size() * (t + 1) / nthreads;
+    for (size_t k = lo; k < hi; k++) {
+      int score = finderMatch(paths[ids[k]], query, qmask, NULL);
+      if (score == INT_MIN) continue;
+      found[t].push_back(ids[k]);
+      points[t].push_back(score);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < nthreads; t++) threads.emplace_back(work, t);
+  work(0);
+  for (std::thread &t : threads) t.join();
+
+  std::vector<int> &cand = cur.candidates;
+  std::vector<int> scores;
+  cand.clear();
+  for (int t = 0; t < nthreads; t++) {
+    cand.insert(cand.end(), found[t].begin(), found[t].end());
+    scores.insert(scores.end(), points[t].begin(), points[t].end());
+  }
+  cur.query = query;
+  cur.scanned = n;
+
+  /* Order only as many as can be shown. */
+  std::vector<int> order(scores.size());
+  for (size_t k = 0; k < order.size(); k++) order[k] = k;
+  int keep = std::min<int>(order.size(), FINDER_TOP);
+  std::partial_sort(order.begin(), order.begin() + keep, order.end(),
+                    [&](int a, int b) {
+    if (scores[a] != scores[b]) return scores[a] > scores[b];
+    return cand[a] < cand[b];
+  });
+  cur.top.resize(keep);
+  for (int k = 0; k < keep; k++) cur.top[k] = cand[order[k]];
+}
+
+/*** finder screen ***/
+
+/* Ctrl-P: opens the finder, starting the file scan the first time. */
+void editorFinder() {
+  if (!E.finder.loaded) editorFinderLoad(".");
+  E.finder.on = 1;
+  E.finder.query.clear();
+  E.finder.selected = 0;
+  E.finder.scroll = 0;
+}
+
+void editorFinderScroll() {
+  editorFinderUpdate();
+  int n = E.finder.cur.top.size();
+  int rows = E.screenrows - 1;
+  if (E.finder.selected >= n) E.finder.selected = n ? n - 1 : 0;
+  if (E.finder.selected < 0) E.finder.selected = 0;
+  if (E.finder.selected < E.finder.scroll) E.finder.scroll = E.finder.selected;
+  if (E.finder.selected >= E.finder.scroll + rows)
+    E.finder.scroll = E.finder.selected - rows + 1;
+}
+
+void editorFinderDrawRows(struct abuf *ab) {
+  std::string query(E.finder.query);
+  for (char &c : query) c = finderLower(c);
+  uint64_t qmask = finderMask(query);
+  std::vector<int> positions(query.size());
+
+  abAppend(ab, "> ", 2);
+  int qlen = std::min<int>(E.finder.query.size(), E.screencols - 2);
+  abAppend(ab, E.finder.query.data(), std::max(qlen, 0));
+  abAppend(ab, "\x1b[K\r\n", 5);
+
+  std::lock_guard<std::mutex> guard(E.finder.lock);
+  for (int y = 1; y < E.screenrows; y++) {
+    int at = E.finder.scroll + y - 1;
+    if (at < (int)E.finder.cur.top.size()) {
+      const finderPath &p = E.finder.paths[E.finder.cur.top[at]];
+      const char *path = E.finder.text.data() + p.off;
+      finderMatch(p, query, qmask, positions.data());
+      if (at == E.finder.selected) abAppend(ab, "\x1b[7m", 4);
+      int len = std::min<int>(p.len, E.screencols);
+      size_t k = 0;
+      for (int j = 0; j < len; j++) {
+        int hit = k < positions.size() && positions[k] == j;
+        if (hit) {
+          abAppend(ab, "\x1b[1;33m", 7);
+          k++;
+        }
+        unsigned char c = path[j];
+        abAppend(ab, c < 0x20 || c == 0x7f ? "?" : &path[j], 1);
+        if (hit) abAppend(ab, "\x1b[22;39m", 8);
+      }
+      abAppend(ab, "\x1b[m", 3);
+    } else {
+      abAppend(ab, "~", 1);
+    }
+    abAppend(ab, "\x1b[K\r\n", 5);
+  }
+}
+
+void editorFinderCursor(int *y, int *x) {
+  *y = 0;
+  *x = std::min<int>(2 + E.finder.query.size(), E.screencols - 1);
+}
+
+static void editorFinderOpen() {
+  if (E.finder.selected >= (int)E.finder.cur.top.size()) return;
+  std::string path;
+  {
+    std::lock_guard<std::mutex> guard(E.finder.lock);
+    path = editorFinderPath(E.finder.cur.top[E.finder.selected]);
+  }
+  if (editorSwitchFile(path.c_str()) == -1) return;
+  E.finder.on = 0;
+}
+
+void editorFinderProcessKey(int c) {
+  switch (c) {
+    case '\r':
+      editorFinderOpen();
+      break;
+
+    case '\x1b':
+      E.finder.on = 0;
+      break;
+
+    case CTRL_KEY('p'):
+      editorFinderLoad(".");
+      editorSetStatusMessage("Rescanning files");
+      break;
+
+    case BACKSPACE:
+    case CTRL_KEY('h'):
+    case DEL_KEY:
+      if (!E.finder.query.empty()) E.finder.query.pop_back();
+      E.finder.selected = 0;
+      break;
+
+    case ARROW_UP:
+      E.finder.selected--;
+      break;
+
+    case ARROW_DOWN:
+      E.finder.selected++;
+      break;
+
+    case PAGE_UP:
+      E.finder.selected -= E.screenrows - 1;
+      break;
+
+    case PAGE_DOWN:
+      E.finder.selected += E.screenrows - 1;
+      break;
+
+    default:
+      if (c >= 0x20 && c < 0x7f) {
+        E.finder.query += (char)c;
+        E.finder.selected = 0;
+      }
+      break;
+  }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*** fuzzy file finder ***/
+
+/* Paths kept ranked for display; the rest of the matches only count. */
+#define FINDER_TOP 256
+
+struct abuf;
+
+/* One discovered path, stored in finderState::text as len bytes at off;
+ * queries match it ignoring ASCII case. base is where its last component
+ * starts. mask has a bit for each class of character present (case
+ * folded), so a path lacking any of the query's characters is rejected
+ * with one AND. Keeping the text in one pool rather than in a string per
+ * path keeps a scan of every path in order through memory. */
+struct finderPath {
+  uint64_t mask;
+  uint32_t off;
+  uint16_t len;
+  uint16_t base;
+};
+
+/* The paths among the first scanned that match query, and the best
+ * FINDER_TOP of them in order. */
+struct finderLevel {
+  std::string query;
+  int scanned;
+  std::vector<int> candidates;
+  std::vector<int> top;
+};
+
+/* Ctrl-P lists the files under the working directory and narrows them to
+ * those containing the query as a subsequence, ignoring case, best match
+ * first.
+ *
+ * The file list is found once per session by walkTree on runner, which
+ * appends to paths and text under lock while the finder is already
+ * usable, and is kept for later Ctrl-Ps; Ctrl-P in the finder walks the
+ * tree again.
+ *
+ * Matching is incremental. cur is the match of the query as last shown,
+ * and history that of each shorter query typed on the way to it. A query
+ * that extends cur's only filters cur's candidates further, and deleting
+ * back to a query in history restores its level as it was; either way
+ * only paths discovered since are scanned in full. Every candidate is
+ * scored, but only the best are ordered, into top, which selected and
+ * scroll index. */
+struct finderState {
+  int on;
+  std::string query;
+  std::vector<finderPath> paths;
+  std::vector<char> text;
+  std::mutex lock;
+  std::thread runner;
+  std::atomic<int> running;
+  std::atomic<int> cancel;
+  int loaded;
+  struct finderLevel cur;
+  std::vector<finderLevel> history;
+  int selected;
+  int scroll;
+};
+
+void editorFinder();
+void editorFinderLoad(const char *root);
+void editorFinderWait();
+void editorFinderStop();
+void editorFinderAdd(const char *path);
+void editorFinderUpdate();
+std::string editorFinderPath(int i);
+int editorFinderScore(int i, const std::string &query, int *positions);
+void editorFinderScroll();
+void editorFinderDrawRows(struct abuf *ab);
+void editorFinderCursor(int *y, int *x);
+void editorFinderProcessKey(int c);
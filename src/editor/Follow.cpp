@@ -0,0 +1,137 @@
+#include "Follow.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "Row.h"
+
+#define FOLLOW_CHUNK (1 << 20)
+
+void editorFollowStop(const char *why) {
+  if (E.follow.fd == -1) return;
+  close(E.follow.fd);
+  E.follow.fd = -1;
+  editorWatchFile();
+  editorSetStatusMessage("Follow off%s%s", why ? ": " : "", why ? why : "");
+}
+
+void editorToggleFollow() {
+  if (E.follow.fd != -1) {
+    editorFollowStop(NULL);
+    return;
+  }
+  if (E.filename == NULL) {
+    editorSetStatusMessage("Nothing to follow");
+    return;
+  }
+
+  int fd = open(E.filename, O_RDONLY);
+  struct stat st;
+  if (fd == -1 || fstat(fd, &st) == -1) {
+    if (fd != -1) close(fd);
+    editorSetStatusMessage("Can't follow: %s", strerror(errno));
+    return;
+  }
+  E.follow.fd = fd;
+  editorWatchFile();
+  if (E.watch.filewd == -1) {
+    close(fd);
+    E.follow.fd = -1;
+    editorSetStatusMessage("Can't follow: %s", strerror(errno));
+    return;
+  }
+
+  /* The buffer is taken to hold the file as it is now; everything after
+   * the current end is new. */
+  char last = '\n';
+  if (st.st_size > 0 && pread(fd, &last, 1, st.st_size - 1) != 1) last = '\n';
+  E.follow.offset = st.st_size;
+  E.follow.partial = last != '\n';
+  editorSetStatusMessage("Following %s (Ctrl-T to stop)", E.filename);
+  editorFollowRead();
+}
+
+/* Adds text[0, len) of the file to the end of the buffer. The complete
+ * lines of a chunk are appended as one batch. */
+static void editorFollowIngest(const char *text, size_t len) {
+  size_t at = 0;
+  if (E.follow.partial && E.numrows > 0) {
+    /* Replace the unfinished last row with itself and its continuation
+     * rather than editing it, which would prepare every row above it. */
+    erow *row = &E.row[E.numrows - 1];
+    const char *nl = (const char *)memchr(text, '\n', len);
+    size_t end = nl ? nl - text : len;
+    std::string line(editorRowChars(row), row->size);
+    line.append(text, end);
+    while (nl && !line.empty() && line.back() == '\r') line.pop_back();
+    size_t start = 0;
+    size_t linelen = line.size();
+    editorReplaceRows(E.numrows - 1, 1, line.data(), &start, &linelen, 1);
+    E.follow.partial = nl == NULL;
+    at = nl ? end + 1 : len;
+  }
+
+  std::vector<size_t> starts, lens;
+  while (at < len) {
+    const char *nl = (const char *)memchr(text + at, '\n', len - at);
+    size_t end = nl ? nl - text : len;
+    size_t linelen = end - at;
+    while (nl && linelen > 0 && text[at + linelen - 1] == '\r') linelen--;
+    starts.push_back(at);
+    lens.push_back(linelen);
+    if (!nl) E.follow.partial = 1;
+    at = end + 1;
+  }
+  if (!starts.empty())
+    editorAppendRows(text, starts.data(), lens.data(), starts.size());
+}
+
+/* Reads everything appended since the last call. The cursor stays on the
+ * last row if it was already there. */
+void editorFollowRead() {
+  if (E.follow.fd == -1) return;
+
+  struct stat st;
+  if (fstat(E.follow.fd, &st) == -1) {
+    editorFollowStop(strerror(errno));
+    return;
+  }
+  if (st.st_size < E.follow.offset) {
+    /* What was read before is gone from the file; show what is left. */
+    editorReload();
+    editorFollowStop("file was truncated");
+    return;
+  }
+
+  int pinned = E.cy >= E.numrows - 1;
+  int dirty = E.dirty;
+  std::vector<char> buf(FOLLOW_CHUNK);
+  while (E.follow.offset < st.st_size) {
+    ssize_t got = pread(E.follow.fd, buf.data(), buf.size(), E.follow.offset);
+    if (got <= 0) break;
+
+    /* Keep a line that straddles the chunk boundary for the next read,
+     * unless the chunk holds no newline at all. */
+    size_t len = got;
+    if (E.follow.offset + got < st.st_size) {
+      const char *nl = (const char *)memrchr(buf.data(), '\n', got);
+      if (nl) len = nl - buf.data() + 1;
+    }
+    editorFollowIngest(buf.data(), len);
+    E.follow.offset += len;
+  }
+  E.dirty = dirty;
+
+  if (pinned && E.numrows > 0) {
+    E.cy = E.numrows - 1;
+    E.cx = 0;
+  }
+}
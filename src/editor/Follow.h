@@ -0,0 +1,19 @@
+#pragma once
+
+#include <sys/types.h>
+
+/*** follow mode ***/
+
+/* Follow mode (Ctrl-T) appends whatever is written to the open file past
+ * offset, like tail -f; editorFileEvent calls editorFollowRead when the
+ * file watch (see FileIO.h) reports a write. partial is set while the
+ * last row is a line whose newline has not been written yet. */
+struct followState {
+  int fd;
+  off_t offset;
+  int partial;
+};
+
+void editorToggleFollow();
+void editorFollowRead();
+void editorFollowStop(const char *why);
@@ -0,0 +1,232 @@
+#include "Grep.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "Editor.h"
+#include "FileIO.h"
+#include "Probe.h"
+#include "Search.h"
+#include "Terminal.h"
+#include "Utf8.h"
+#include "Walker.h"
+
+/* Scans one file; runs on a walker thread. */
+static void grepVisit(const char *path, void *arg) {
+  PROBE(PROBE_GREP);
+  const std::string &query = *(const std::string *)arg;
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) return;
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size == 0) {
+    close(fd);
+    return;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return;
+
+  const char *text = (const char *)map;
+  size_t size = st.st_size;
+  size_t probe = size < GREP_BINARY_PROBE ? size : GREP_BINARY_PROBE;
+  std::vector<grepHit> found;
+  if (memchr(text, '\0', probe) == NULL) {
+    /* Lines are counted only up to each hit, and a line with several
+     * hits is reported once. */
+    int line = 1;
+    size_t counted = 0;
+    size_t at = 0;
+    const char *hit;
+    while ((hit = searchFind(text + at, size - at, query.data(),
+                             query.size())) != NULL) {
+      size_t off = hit - text;
+      for (const char *nl; (nl = (const char *)memchr(text + counted, '\n',
+                                                      off - counted)) != NULL;) {
+        line++;
+        counted = nl - text + 1;
+      }
+      const char *end = (const char *)memchr(hit, '\n', size - off);
+      size_t eol = end ? end - text : size;
+      size_t len = eol - counted;
+      while (len > 0 && text[counted + len - 1] == '\r') len--;
+      if (len > GREP_PREVIEW) len = GREP_PREVIEW;
+      found.push_back({path, line, (int)(off - counted),
+                       std::string(text + counted, len)});
+      at = eol + 1;
+      if (at >= size) break;
+    }
+  }
+  munmap(map, size);
+
+  E.grep.files++;
+  if (found.empty()) return;
+  std::lock_guard<std::mutex> guard(E.grep.lock);
+  for (grepHit &h : found) E.grep.hits.push_back(std::move(h));
+  if (E.grep.hits.size() >= GREP_MAX_HITS) E.grep.cancel = 1;
+  editorWake();
+}
+
+static void grepRun(std::string root, std::string query) {
+  walkTree(root.c_str(), walkThreads(), grepVisit, &query, &E.grep.cancel);
+  E.grep.running = 0;
+  editorWake();
+}
+
+/* Starts searching the tree under root, replacing any earlier results. */
+void editorGrepStart(const char *root, const char *query) {
+  editorGrepStop();
+  E.grep.query = query;
+  E.grep.hits.clear();
+  E.grep.files = 0;
+  E.grep.selected = 0;
+  E.grep.top = 0;
+  E.grep.running = 1;
+  E.grep.runner = std::thread(grepRun, std::string(root), E.grep.query);
+}
+
+/* Waits for the search to finish. */
+void editorGrepWait() {
+  if (E.grep.runner.joinable()) E.grep.runner.join();
+}
+
+/* Cancels the search, if one is running, and waits for it. */
+void editorGrepStop() {
+  E.grep.cancel = 1;
+  editorGrepWait();
+  E.grep.cancel = 0;
+}
+
+/* Ctrl-R: shows the last results if there are any; Ctrl-R in the
+ * results asks for a new search. */
+void editorGrep() {
+  if (!E.grep.on && !E.grep.query.empty()) {
+    E.grep.on = 1;
+    return;
+  }
+  char *query = editorPrompt("Search project: %s (ESC to cancel)", NULL);
+  if (query == NULL) return;
+  editorGrepStart(".", query);
+  E.grep.on = 1;
+  free(query);
+}
+
+/*** results list ***/
+
+void editorGrepScroll() {
+  int n;
+  {
+    std::lock_guard<std::mutex> guard(E.grep.lock);
+    n = E.grep.hits.size();
+  }
+  if (E.grep.selected >= n) E.grep.selected = n ? n - 1 : 0;
+  if (E.grep.selected < E.grep.top) E.grep.top = E.grep.selected;
+  if (E.grep.selected >= E.grep.top + E.screenrows)
+    E.grep.top = E.grep.selected - E.screenrows + 1;
+}
+
+/* Appends s[0, len), escaping control characters and stopping before
+ * column limit; returns the columns used. */
+static int grepAppend(struct abuf *ab, const char *s, int len, int col,
+                      int limit) {
+  int j = 0;
+  while (j < len) {
+    int cp;
+    int n = utf8Decode(&s[j], len - j, &cp);
+    int width = cp < 0x20 || cp == 0x7f ? 1 : utf8CharWidth(cp);
+    if (col + width > limit) break;
+    if (cp < 0x20 || cp == 0x7f || cp < 0) abAppend(ab, cp == '\t' ? " " : "?", 1);
+    else abAppend(ab, &s[j], n);
+    col += width;
+    j += n;
+  }
+  return col;
+}
+
+void editorGrepDrawRows(struct abuf *ab) {
+  std::lock_guard<std::mutex> guard(E.grep.lock);
+  for (int y = 0; y < E.screenrows; y++) {
+    int at = E.grep.top + y;
+    if (at >= (int)E.grep.hits.size()) {
+      abAppend(ab, "~", 1);
+    } else {
+      const grepHit &h = E.grep.hits[at];
+      if (at == E.grep.selected) abAppend(ab, "\x1b[7m", 4);
+      char num[16];
+      int numlen = snprintf(num, sizeof(num), ":%d: ", h.line);
+      abAppend(ab, "\x1b[35m", 5);
+      int col = grepAppend(ab, h.path.data(), h.path.size(), 0, E.screencols);
+      abAppend(ab, "\x1b[32m", 5);
+      col = grepAppend(ab, num, numlen, col, E.screencols);
+      abAppend(ab, "\x1b[39m", 5);
+      grepAppend(ab, h.text.data(), h.text.size(), col, E.screencols);
+      abAppend(ab, "\x1b[m", 3);
+    }
+    abAppend(ab, "\x1b[K", 3);
+    abAppend(ab, "\r\n", 2);
+  }
+}
+
+/* Opens the selected hit in place of the current file. */
+static void editorGrepOpen() {
+  grepHit hit;
+  {
+    std::lock_guard<std::mutex> guard(E.grep.lock);
+    if (E.grep.selected >= (int)E.grep.hits.size()) return;
+    hit = E.grep.hits[E.grep.selected];
+  }
+  if (editorSwitchFile(hit.path.c_str()) == -1) return;
+  E.grep.on = 0;
+  E.cy = hit.line - 1 < E.numrows ? hit.line - 1 : E.numrows;
+  E.cx = 0;
+  if (E.cy < E.numrows) {
+    E.cx = hit.col < E.row[E.cy].size ? hit.col : E.row[E.cy].size;
+  }
+}
+
+void editorGrepProcessKey(int c) {
+  switch (c) {
+    case '\r':
+      editorGrepOpen();
+      break;
+
+    case '\x1b':
+      E.grep.on = 0;
+      break;
+
+    case CTRL_KEY('r'):
+      editorGrep();
+      break;
+
+    case ARROW_UP:
+      if (E.grep.selected > 0) E.grep.selected--;
+      break;
+
+    case ARROW_DOWN:
+      E.grep.selected++;
+      break;
+
+    case PAGE_UP:
+      E.grep.selected -= E.screenrows;
+      if (E.grep.selected < 0) E.grep.selected = 0;
+      break;
+
+    case PAGE_DOWN:
+      E.grep.selected += E.screenrows;
+      break;
+
+    case HOME_KEY:
+      E.grep.selected = 0;
+      break;
+
+    case END_KEY:
+      E.grep.selected = INT32_MAX;
+      break;
+  }
+}
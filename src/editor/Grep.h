@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*** project search ***/
+
+#define GREP_MAX_HITS 100000
+#define GREP_BINARY_PROBE 8192
+#define GREP_PREVIEW 256
+
+struct abuf;
+
+struct grepHit {
+  std::string path;
+  int line;
+  int col;
+  std::string text;
+};
+
+/* Ctrl-R searches every file under the working directory for a literal
+ * string. The search runs on runner in the background: walkTree (see
+ * Walker.h) spreads the directories over a thread per core, each file is
+ * mapped and scanned with the kernel Ctrl-F uses (searchFind), and the
+ * hits of each file are appended to hits under lock, waking the main
+ * loop through E.wakefd. Files with a NUL byte among their first
+ * GREP_BINARY_PROBE bytes are taken to be binary and skipped.
+ *
+ * While on is set the hits replace the text: selected is the highlighted
+ * one and top the first on screen. Enter opens a hit, Esc goes back to
+ * the file and Ctrl-R there brings the list up again. */
+struct grepState {
+  int on;
+  std::string query;
+  std::vector<grepHit> hits;
+  std::mutex lock;
+  std::thread runner;
+  std::atomic<int> running;
+  std::atomic<int> cancel;
+  std::atomic<int> files;
+  int selected;
+  int top;
+};
+
+void editorGrep();
+void editorGrepStart(const char *root, const char *query);
+void editorGrepWait();
+void editorGrepStop();
+void editorGrepScroll();
+void editorGrepDrawRows(struct abuf *ab);
+void editorGrepProcessKey(int c);
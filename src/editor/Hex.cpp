@@ -0,0 +1,394 @@
+#include "Hex.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "Editor.h"
+#include "FileIO.h"
+#include "Terminal.h"
+
+/* Set after Ctrl-X was refused over unsaved edits; a second one in a
+ * row discards them. */
+static int hexDiscardWarned = 0;
+
+int editorHexOpen(const char *filename) {
+  int writable = 1;
+  int fd = open(filename, O_RDWR);
+  if (fd == -1) {
+    writable = 0;
+    fd = open(filename, O_RDONLY);
+  }
+  struct stat st;
+  if (fd == -1 || fstat(fd, &st) == -1) {
+    if (fd != -1) close(fd);
+    editorSetStatusMessage("Can't open %s: %s", filename, strerror(errno));
+    return -1;
+  }
+
+  E.hex.on = 1;
+  E.hex.fd = fd;
+  E.hex.writable = writable;
+  E.hex.standalone = 0;
+  E.hex.size = st.st_size;
+  E.hex.cursor = 0;
+  E.hex.top = 0;
+  E.hex.nibble = 0;
+  E.hex.ascii = 0;
+  E.hex.window = NULL;
+  E.hex.winoff = 0;
+  E.hex.winlen = 0;
+  E.hex.pages.clear();
+  E.hex.dirty = 0;
+  if (E.filename == NULL) E.filename = strdup(filename);
+  return 0;
+}
+
+void editorHexClose() {
+  if (E.hex.window) munmap(E.hex.window, E.hex.winlen);
+  if (E.hex.fd != -1) close(E.hex.fd);
+  E.hex.window = NULL;
+  E.hex.fd = -1;
+  E.hex.pages.clear();
+  E.hex.dirty = 0;
+  E.hex.on = 0;
+}
+
+void editorToggleHex() {
+  if (E.hex.on) {
+    if (E.hex.dirty && !hexDiscardWarned) {
+      hexDiscardWarned = 1;
+      editorSetStatusMessage("Hex edits not saved: Ctrl-S saves, Ctrl-X "
+                             "again discards them");
+      return;
+    }
+    hexDiscardWarned = 0;
+
+    /* Rows pick up saved hex edits like any other change on disk. */
+    off_t cursor = E.hex.cursor;
+    int standalone = E.hex.standalone;
+    editorHexClose();
+    if (standalone) {
+      char *filename = strdup(E.filename);
+      editorOpen(filename);
+      free(filename);
+    } else {
+      editorReload();
+    }
+    E.cy = editorOffsetToRow(cursor, &E.cx);
+    if (E.cy < E.numrows && E.cx > E.row[E.cy].size) E.cx = E.row[E.cy].size;
+    editorSetStatusMessage("Hex view off");
+    return;
+  }
+
+  if (E.filename == NULL) {
+    editorSetStatusMessage("No file to show in hex");
+    return;
+  }
+  if (E.dirty) {
+    editorSetStatusMessage("Save the buffer before switching to hex");
+    return;
+  }
+  long long offset = editorRowOffset(E.cy) + E.cx;
+  if (editorHexOpen(E.filename) == -1) return;
+  E.hex.cursor = offset < E.hex.size ? offset : 0;
+  editorSetStatusMessage("Hex view%s: Tab switches columns, Ctrl-X leaves",
+                         E.hex.writable ? "" : " (read-only)");
+}
+
+/* Returns a pointer to the file's byte at offset, sliding the window
+ * over it if needed. The window is aligned to HEX_WINDOW, and so to
+ * pages: a page never straddles two windows. */
+static const unsigned char *hexMapped(off_t offset) {
+  if (E.hex.window == NULL || offset < E.hex.winoff ||
+      offset >= E.hex.winoff + (off_t)E.hex.winlen) {
+    if (E.hex.window) munmap(E.hex.window, E.hex.winlen);
+    E.hex.window = NULL;
+    off_t start = offset - offset % HEX_WINDOW;
+    size_t len = E.hex.size - start < HEX_WINDOW ? E.hex.size - start
+                                                 : HEX_WINDOW;
+    void *map = mmap(NULL, len, PROT_READ, MAP_SHARED, E.hex.fd, start);
+    if (map == MAP_FAILED) return NULL;
+    E.hex.window = (unsigned char *)map;
+    E.hex.winoff = start;
+    E.hex.winlen = len;
+  }
+  return E.hex.window + (offset - E.hex.winoff);
+}
+
+static std::vector<unsigned char> *hexPage(off_t offset) {
+  auto it = E.hex.pages.find(offset - offset % HEX_PAGE);
+  return it == E.hex.pages.end() ? NULL : &it->second;
+}
+
+/* Returns the byte at offset as edited, or -1 past the end. */
+int editorHexByte(off_t offset) {
+  if (offset < 0 || offset >= E.hex.size) return -1;
+  std::vector<unsigned char> *page = hexPage(offset);
+  if (page) return (*page)[offset % HEX_PAGE];
+  const unsigned char *p = hexMapped(offset);
+  return p ? *p : -1;
+}
+
+/* Whether the byte at offset differs from the file. */
+static int hexModified(off_t offset) {
+  std::vector<unsigned char> *page = hexPage(offset);
+  if (page == NULL) return 0;
+  const unsigned char *p = hexMapped(offset);
+  return p && *p != (*page)[offset % HEX_PAGE];
+}
+
+void editorHexSetByte(off_t offset, unsigned char value) {
+  if (offset < 0 || offset >= E.hex.size) return;
+  std::vector<unsigned char> *page = hexPage(offset);
+  if (page == NULL) {
+    off_t start = offset - offset % HEX_PAGE;
+    size_t len = E.hex.size - start < HEX_PAGE ? E.hex.size - start
+                                               : HEX_PAGE;
+    const unsigned char *p = hexMapped(start);
+    if (p == NULL) return;
+    page = &E.hex.pages[start];
+    page->assign(p, p + len);
+  }
+  (*page)[offset % HEX_PAGE] = value;
+  E.hex.dirty++;
+}
+
+/* Writes the edited pages back in place; the rest of the file is not
+ * touched. */
+int editorHexSave() {
+  if (!E.hex.writable) {
+    editorSetStatusMessage("Can't save: %s is read-only", E.filename);
+    return -1;
+  }
+  long long bytes = 0;
+  for (auto &page : E.hex.pages) {
+    ssize_t len = page.second.size();
+    if (pwrite(E.hex.fd, page.second.data(), len, page.first) != len) {
+      editorSetStatusMessage("Can't save! I/O error: %s", strerror(errno));
+      return -1;
+    }
+    bytes += len;
+  }
+  editorSetStatusMessage("%d pages (%lld bytes) written to disk",
+                         (int)E.hex.pages.size(), bytes);
+  E.hex.pages.clear();
+  E.hex.dirty = 0;
+  return 0;
+}
+
+/*** hex output ***/
+
+/* Hex digits in the offset column: enough for the largest offset. */
+static int hexDigits() {
+  int digits = 8;
+  while (digits < 15 && (E.hex.size - 1) >> (4 * digits) > 0) digits++;
+  return digits;
+}
+
+/* Bytes per line: 16 if they fit on screen, else 8. */
+static int hexWidth() {
+  int need = hexDigits() + 2 + 16 * 3 + 1 + 1 + 16;
+  return E.screencols >= need ? 16 : 8;
+}
+
+static int hexColumn(int i) {
+  return hexDigits() + 2 + i * 3 + (i >= 8);
+}
+
+static int asciiColumn(int i) {
+  int width = hexWidth();
+  return hexDigits() + 2 + width * 3 + (width > 8) + 1 + i;
+}
+
+void editorHexScroll() {
+  int width = hexWidth();
+  if (E.hex.cursor >= E.hex.size) E.hex.cursor = E.hex.size ? E.hex.size - 1 : 0;
+  off_t line = E.hex.cursor - E.hex.cursor % width;
+  E.hex.top -= E.hex.top % width;
+  if (line < E.hex.top) E.hex.top = line;
+  if (line >= E.hex.top + (off_t)E.screenrows * width)
+    E.hex.top = line - (off_t)(E.screenrows - 1) * width;
+}
+
+void editorHexDrawRows(struct abuf *ab) {
+  int width = hexWidth();
+  int digits = hexDigits();
+  char buf[32];
+  for (int y = 0; y < E.screenrows; y++) {
+    off_t line = E.hex.top + (off_t)y * width;
+    if (line >= E.hex.size && (line > 0 || E.hex.size > 0)) {
+      abAppend(ab, "~", 1);
+    } else {
+      int len = snprintf(buf, sizeof(buf), "%0*llx: ", digits,
+                         (long long)line);
+      abAppend(ab, buf, len);
+
+      /* The byte under the cursor is shown in reverse in the column that
+       * is not being edited; edited bytes are red. */
+      for (int col = 0; col < 2; col++) {
+        for (int i = 0; i < width; i++) {
+          off_t offset = line + i;
+          int byte = editorHexByte(offset);
+          if (col == 0 && i == 8) abAppend(ab, " ", 1);
+          if (byte < 0) {
+            if (col == 0) abAppend(ab, "   ", 3);
+            continue;
+          }
+          int mark = offset == E.hex.cursor && col != E.hex.ascii;
+          int edited = hexModified(offset);
+          if (mark) abAppend(ab, "\x1b[7m", 4);
+          if (edited) abAppend(ab, "\x1b[31m", 5);
+          if (col == 0) {
+            len = snprintf(buf, sizeof(buf), "%02x", byte);
+            abAppend(ab, buf, len);
+          } else {
+            char c = byte >= 0x20 && byte < 0x7f ? byte : '.';
+            abAppend(ab, &c, 1);
+          }
+          if (mark || edited) abAppend(ab, "\x1b[m", 3);
+          if (col == 0) abAppend(ab, " ", 1);
+        }
+        if (col == 0) abAppend(ab, " ", 1);
+      }
+    }
+    abAppend(ab, "\x1b[K", 3);
+    abAppend(ab, "\r\n", 2);
+  }
+}
+
+/* Screen position of the cursor, 0-based. */
+void editorHexCursor(int *y, int *x) {
+  int width = hexWidth();
+  off_t rel = E.hex.cursor - E.hex.top;
+  *y = rel / width;
+  int i = rel % width;
+  *x = E.hex.ascii ? asciiColumn(i) : hexColumn(i) + E.hex.nibble;
+}
+
+/*** hex input ***/
+
+static void editorHexGoto() {
+  char *query = editorPrompt("Go to offset: %s (0x for hex, ESC to cancel)",
+                             NULL);
+  if (query == NULL) return;
+  char *end;
+  long long offset = strtoll(query, &end, 0);
+  if (end != query && *end == '\0') {
+    if (offset < 0) offset = 0;
+    E.hex.cursor = offset;
+    E.hex.nibble = 0;
+  } else {
+    editorSetStatusMessage("Bad offset: %s", query);
+  }
+  free(query);
+}
+
+static void editorHexType(int c) {
+  if (E.hex.size == 0) return;
+  if (!E.hex.writable) {
+    editorSetStatusMessage("%s is read-only", E.filename);
+    return;
+  }
+
+  int byte = editorHexByte(E.hex.cursor);
+  if (E.hex.ascii) {
+    if (c < 0x20 || c >= 0x7f) return;
+    editorHexSetByte(E.hex.cursor, c);
+  } else {
+    if (c >= 0x80 || !isxdigit(c)) return;
+    int v = isdigit(c) ? c - '0' : tolower(c) - 'a' + 10;
+    if (E.hex.nibble == 0) {
+      editorHexSetByte(E.hex.cursor, (v << 4) | (byte & 0x0f));
+      E.hex.nibble = 1;
+      return;
+    }
+    editorHexSetByte(E.hex.cursor, (byte & 0xf0) | v);
+    E.hex.nibble = 0;
+  }
+  if (E.hex.cursor + 1 < E.hex.size) E.hex.cursor++;
+}
+
+void editorHexProcessKey(int c) {
+  if (c != CTRL_KEY('x')) hexDiscardWarned = 0;
+  int width = hexWidth();
+  off_t page = (off_t)E.screenrows * width;
+  off_t last = E.hex.size ? E.hex.size - 1 : 0;
+
+  switch (c) {
+    case CTRL_KEY('s'):
+      editorHexSave();
+      break;
+
+    case CTRL_KEY('x'):
+      editorToggleHex();
+      break;
+
+    case CTRL_KEY('g'):
+      editorHexGoto();
+      break;
+
+    case '\t':
+      E.hex.ascii = !E.hex.ascii;
+      E.hex.nibble = 0;
+      break;
+
+    case ARROW_LEFT:
+    case BACKSPACE:
+    case CTRL_KEY('h'):
+      if (E.hex.nibble) E.hex.nibble = 0;
+      else if (E.hex.cursor > 0) E.hex.cursor--;
+      break;
+
+    case ARROW_RIGHT:
+      if (E.hex.cursor < last) E.hex.cursor++;
+      E.hex.nibble = 0;
+      break;
+
+    case ARROW_UP:
+      if (E.hex.cursor >= width) E.hex.cursor -= width;
+      break;
+
+    case ARROW_DOWN:
+      if (E.hex.cursor + width <= last) E.hex.cursor += width;
+      break;
+
+    case PAGE_UP:
+      E.hex.cursor = E.hex.cursor >= page ? E.hex.cursor - page
+                                          : E.hex.cursor % width;
+      E.hex.top = E.hex.top >= page ? E.hex.top - page : 0;
+      break;
+
+    case PAGE_DOWN:
+      E.hex.cursor = E.hex.cursor + page <= last ? E.hex.cursor + page : last;
+      E.hex.top += page;
+      if (E.hex.top > E.hex.cursor) E.hex.top = E.hex.cursor;
+      break;
+
+    case HOME_KEY:
+      E.hex.cursor -= E.hex.cursor % width;
+      E.hex.nibble = 0;
+      break;
+
+    case END_KEY:
+      E.hex.cursor += width - 1 - E.hex.cursor % width;
+      if (E.hex.cursor > last) E.hex.cursor = last;
+      E.hex.nibble = 0;
+      break;
+
+    case CTRL_KEY('l'):
+    case '\x1b':
+      break;
+
+    default:
+      editorHexType(c);
+      break;
+  }
+}
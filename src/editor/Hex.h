@@ -0,0 +1,52 @@
+#pragma once
+
+#include <map>
+#include <sys/types.h>
+#include <vector>
+
+/*** hex view ***/
+
+#define HEX_PAGE 4096
+#define HEX_WINDOW (1 << 20)
+
+struct abuf;
+
+/* Hex mode (Ctrl-X, or --hex on the command line) shows and edits the
+ * bytes of the file itself, with offset, hex and ASCII columns, instead
+ * of the rows. The file is never read as a whole: window is a read-only
+ * mapping of at most HEX_WINDOW bytes around the bytes being looked at,
+ * moved as the view moves, so browsing any file costs a few pages of
+ * memory. Overwriting a byte copies its page into pages, keyed by page
+ * offset, and a save writes back only those pages, in place.
+ *
+ * cursor is a byte offset and top the offset of the first byte on
+ * screen; nibble selects the half of the byte typed next and ascii the
+ * column being edited. standalone is set when no rows were loaded for
+ * the file (--hex), so leaving hex mode has to open it. */
+struct hexView {
+  int on;
+  int fd;
+  int writable;
+  int standalone;
+  off_t size;
+  off_t cursor;
+  off_t top;
+  int nibble;
+  int ascii;
+  unsigned char *window;
+  off_t winoff;
+  size_t winlen;
+  std::map<off_t, std::vector<unsigned char>> pages;
+  int dirty;
+};
+
+int editorHexOpen(const char *filename);
+void editorHexClose();
+void editorToggleHex();
+int editorHexByte(off_t offset);
+void editorHexSetByte(off_t offset, unsigned char value);
+int editorHexSave();
+void editorHexScroll();
+void editorHexDrawRows(struct abuf *ab);
+void editorHexCursor(int *y, int *x);
+void editorHexProcessKey(int c);
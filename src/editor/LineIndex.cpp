@@ -0,0 +1,40 @@
+#include "LineIndex.h"
+
+#include "Editor.h"
+#include "Fenwick.h"
+
+void editorIndexInsertRow(int at) {
+  fwInsert(&E.lines, at, E.row[at].size + 1);
+}
+
+void editorIndexDelRow(int at) {
+  fwErase(&E.lines, at);
+}
+
+void editorIndexUpdateRow(int at) {
+  fwSet(&E.lines, at, E.row[at].size + 1);
+}
+
+/* Byte offset of the start of row at; E.numrows gives the file size. */
+long long editorRowOffset(int at) {
+  if (at >= E.numrows) return editorDocumentSize();
+  return fwPrefix(&E.lines, at);
+}
+
+/* Returns the row containing byte offset, and stores the offset within it
+ * in *cx; a newline maps to the end of its row. Offsets past the end of
+ * the file map to E.numrows. */
+int editorOffsetToRow(long long offset, int *cx) {
+  if (offset < 0) offset = 0;
+  int at = fwFind(&E.lines, offset);
+  if (at >= E.numrows) {
+    *cx = 0;
+    return E.numrows;
+  }
+  *cx = offset - fwPrefix(&E.lines, at);
+  return at;
+}
+
+long long editorDocumentSize() {
+  return E.lines.total;
+}
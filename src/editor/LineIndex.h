@@ -0,0 +1,15 @@
+#pragma once
+
+/*** line index ***/
+
+/* The length of every row plus its newline, kept as prefix sums alongside
+ * E.row so that line numbers and byte offsets in the saved file convert in
+ * O(log n). The row operations keep it current. */
+
+void editorIndexInsertRow(int at);
+void editorIndexDelRow(int at);
+void editorIndexUpdateRow(int at);
+
+long long editorRowOffset(int at);
+int editorOffsetToRow(long long offset, int *cx);
+long long editorDocumentSize();
@@ -0,0 +1,214 @@
+#include "Plugin.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <string>
+
+#include "Editor.h"
+#include "Row.h"
+
+/*** host functions ***/
+
+static int hostNumrows() {
+  return E.numrows;
+}
+
+static bw_row hostRow(int at) {
+  if (at < 0 || at >= E.numrows) return {NULL, 0};
+  erow *row = &E.row[at];
+  return {editorRowChars(row), row->size};
+}
+
+static const char *hostFilename() {
+  return E.filename;
+}
+
+static void hostStatus(const char *msg) {
+  editorSetStatusMessage("%s", msg);
+}
+
+static void pluginWork() {
+  std::unique_lock<std::mutex> guard(E.plugins.lock);
+  while (1) {
+    E.plugins.cond.wait(guard, [] {
+      return E.plugins.stopping || !E.plugins.work.empty();
+    });
+    /* Tasks already posted still run before the worker stops. */
+    if (E.plugins.work.empty()) return;
+    pluginTask task = E.plugins.work.front();
+    E.plugins.work.pop_front();
+    guard.unlock();
+    task.fn(task.arg);
+    guard.lock();
+  }
+}
+
+static void hostPost(bw_task fn, void *arg) {
+  std::lock_guard<std::mutex> guard(E.plugins.lock);
+  if (!E.plugins.worker.joinable())
+    E.plugins.worker = std::thread(pluginWork);
+  E.plugins.work.push_back({fn, arg});
+  E.plugins.cond.notify_one();
+}
+
+static void hostMain(bw_task fn, void *arg) {
+  {
+    std::lock_guard<std::mutex> guard(E.plugins.lock);
+    E.plugins.done.push_back({fn, arg});
+  }
+  editorWake();
+}
+
+static const bw_host host = {
+  BW_PLUGIN_ABI, hostNumrows, hostRow, hostFilename, hostStatus, hostPost,
+  hostMain
+};
+
+/*** loading ***/
+
+/* Loads the plugin at path; returns -1, with a message, if it cannot. */
+int editorPluginLoad(const char *path) {
+  void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (handle == NULL) {
+    editorSetStatusMessage("Can't load plugin: %s", dlerror());
+    return -1;
+  }
+  bw_plugin_init_fn init =
+      reinterpret_cast<bw_plugin_init_fn>(dlsym(handle, BW_PLUGIN_INIT));
+  const bw_plugin *plugin = init ? init(&host) : NULL;
+  if (plugin == NULL || plugin->abi != BW_PLUGIN_ABI) {
+    editorSetStatusMessage("Plugin %s declined to load or has ABI %d, not %d",
+                           path, plugin ? plugin->abi : 0, BW_PLUGIN_ABI);
+    dlclose(handle);
+    return -1;
+  }
+  return editorPluginRegister(plugin, handle);
+}
+
+/* Adds a plugin that is already in memory; handle, if not NULL, is
+ * closed when it is unloaded. */
+int editorPluginRegister(const bw_plugin *plugin, void *handle) {
+  static int registered = 0;
+  if (!registered) {
+    atexit(editorPluginsUnload);
+    registered = 1;
+  }
+  E.plugins.loaded.push_back({handle, plugin});
+  E.plugins.events |= plugin->events;
+  return 0;
+}
+
+void editorPluginsLoadEnv() {
+  const char *env = getenv("BYTE_WRITER_PLUGINS");
+  if (env == NULL) return;
+  std::string paths = env;
+  size_t start = 0;
+  while (start <= paths.size()) {
+    size_t end = paths.find(':', start);
+    if (end == std::string::npos) end = paths.size();
+    if (end > start) editorPluginLoad(paths.substr(start, end - start).c_str());
+    start = end + 1;
+  }
+}
+
+/*** events ***/
+
+/* Whether an edit can be folded into last: rows changed next to rows
+ * just changed, rows inserted inside or at the end of a block just
+ * inserted, or rows deleted where the last deletion was or just above. */
+static int pluginMerge(bw_event *last, int kind, int row, int count) {
+  if (last->type != BW_EV_EDIT || last->kind != kind) return 0;
+  switch (kind) {
+    case BW_EDIT_TEXT:
+      if (row < last->row || row > last->row + last->count) return 0;
+      if (row + count > last->row + last->count)
+        last->count = row + count - last->row;
+      return 1;
+    case BW_EDIT_INSERT:
+      if (row < last->row || row > last->row + last->count) return 0;
+      last->count += count;
+      return 1;
+    case BW_EDIT_DELETE:
+      if (row != last->row && row + count != last->row) return 0;
+      last->row = row < last->row ? row : last->row;
+      last->count += count;
+      return 1;
+  }
+  return 0;
+}
+
+/* Queues an event for the next frame; see editorPluginEvent. */
+void editorPluginQueue(int type, int kind, int row, int count) {
+  std::vector<bw_event> &queue = E.plugins.queue;
+  if (type == BW_EV_EDIT) {
+    if (E.plugins.overflow) return;
+    if (!queue.empty() && pluginMerge(&queue.back(), kind, row, count)) return;
+    if (queue.size() >= PLUGIN_MAX_EVENTS) {
+      std::vector<bw_event> kept;
+      for (const bw_event &ev : queue)
+        if (ev.type != BW_EV_EDIT) kept.push_back(ev);
+      queue.swap(kept);
+      queue.push_back({BW_EV_EDIT, BW_EDIT_ALL, 0, E.numrows});
+      E.plugins.overflow = 1;
+      return;
+    }
+  }
+  queue.push_back({type, kind, row, count});
+}
+
+/* Drops queued edits, which name rows of a buffer that is being closed. */
+void editorPluginsReset() {
+  std::vector<bw_event> kept;
+  for (const bw_event &ev : E.plugins.queue)
+    if (ev.type != BW_EV_EDIT) kept.push_back(ev);
+  E.plugins.queue.swap(kept);
+  E.plugins.overflow = 0;
+}
+
+/* Runs the tasks the worker handed back, then gives every plugin the
+ * queued events it subscribed to. */
+void editorPluginsFlush() {
+  std::vector<pluginTask> done;
+  {
+    std::lock_guard<std::mutex> guard(E.plugins.lock);
+    done.swap(E.plugins.done);
+  }
+  for (const pluginTask &task : done) task.fn(task.arg);
+
+  if (E.plugins.events & BW_EV_FRAME)
+    editorPluginQueue(BW_EV_FRAME, 0, E.rowoff, E.screenrows);
+  if (E.plugins.queue.empty()) return;
+
+  std::vector<bw_event> batch, mine;
+  batch.swap(E.plugins.queue);
+  E.plugins.overflow = 0;
+  for (const pluginEntry &entry : E.plugins.loaded) {
+    mine.clear();
+    for (const bw_event &ev : batch)
+      if (entry.plugin->events & ev.type) mine.push_back(ev);
+    if (!mine.empty())
+      entry.plugin->on_events(mine.data(), mine.size(), &host);
+  }
+}
+
+/* Finishes the worker's tasks, then unloads every plugin. */
+void editorPluginsUnload() {
+  {
+    std::lock_guard<std::mutex> guard(E.plugins.lock);
+    E.plugins.stopping = 1;
+  }
+  E.plugins.cond.notify_all();
+  if (E.plugins.worker.joinable()) E.plugins.worker.join();
+  E.plugins.stopping = 0;
+
+  for (const pluginEntry &entry : E.plugins.loaded) {
+    if (entry.plugin->unload) entry.plugin->unload();
+    if (entry.handle) dlclose(entry.handle);
+  }
+  E.plugins.loaded.clear();
+  E.plugins.events = 0;
+  E.plugins.queue.clear();
+  E.plugins.done.clear();
+  E.plugins.overflow = 0;
+}
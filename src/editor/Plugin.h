@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PluginAbi.h"
+
+/*** plugin host ***/
+
+/* Plugins named in BYTE_WRITER_PLUGINS (paths separated by ':') are
+ * loaded at startup; see PluginAbi.h for what they see. Edits, opens and
+ * saves are queued through editorPluginEvent, which tests events, the
+ * union of every plugin's subscriptions, and does nothing else when none
+ * want the type. Queued events go out in one batch per plugin at the
+ * start of each frame, and consecutive edits to adjacent rows are merged
+ * into one as they are queued.
+ *
+ * Tasks that plugins post run on worker, started on first use; tasks for
+ * the editor's thread wait in done, and the worker wakes the main loop
+ * through E.wakefd so they run without waiting for a key. */
+
+#define PLUGIN_MAX_EVENTS 4096
+
+struct pluginEntry {
+  void *handle;
+  const bw_plugin *plugin;
+};
+
+struct pluginTask {
+  bw_task fn;
+  void *arg;
+};
+
+struct pluginHost {
+  unsigned events;
+  std::vector<pluginEntry> loaded;
+  std::vector<bw_event> queue;
+  int overflow;
+  std::mutex lock;
+  std::condition_variable cond;
+  std::deque<pluginTask> work;
+  std::vector<pluginTask> done;
+  std::thread worker;
+  int stopping;
+};
+
+int editorPluginLoad(const char *path);
+int editorPluginRegister(const bw_plugin *plugin, void *handle);
+void editorPluginsLoadEnv();
+void editorPluginQueue(int type, int kind, int row, int count);
+void editorPluginsReset();
+void editorPluginsFlush();
+void editorPluginsUnload();
@@ -0,0 +1,85 @@
+#pragma once
+
+/*** plugin ABI ***/
+
+/* The interface between the editor and plugins, in plain C so that a
+ * plugin can be built with any compiler without the editor's headers.
+ * A plugin is a shared object exporting
+ *
+ *   const bw_plugin *bw_plugin_init(const bw_host *host);
+ *
+ * which the editor calls once after loading it; returning NULL declines.
+ * Fields are only ever appended, with BW_PLUGIN_ABI bumped when an
+ * existing one changes meaning. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BW_PLUGIN_ABI 1
+#define BW_PLUGIN_INIT "bw_plugin_init"
+
+/* Event types, also used as the subscription mask. */
+#define BW_EV_EDIT 0x1
+#define BW_EV_SAVE 0x2
+#define BW_EV_OPEN 0x4
+#define BW_EV_FRAME 0x8
+
+/* Kinds of BW_EV_EDIT. Row numbers are those at the time of the edit;
+ * when a batch holds more edits than the editor keeps, they are replaced
+ * by one BW_EDIT_ALL saying that any row may have changed. */
+#define BW_EDIT_TEXT 0   /* rows [row, row + count) were changed */
+#define BW_EDIT_INSERT 1 /* rows [row, row + count) were inserted */
+#define BW_EDIT_DELETE 2 /* count rows starting at row were deleted */
+#define BW_EDIT_ALL 3
+
+/* For BW_EV_FRAME, rows [row, row + count) are the ones on screen as the
+ * frame starts (before it scrolls to the cursor); for
+ * BW_EV_OPEN and BW_EV_SAVE, count is the number of rows. */
+typedef struct bw_event {
+  int type;
+  int kind;
+  int row;
+  int count;
+} bw_event;
+
+/* A row's text, len bytes that are not NUL-terminated, read in place
+ * from the editor's buffers: valid until the callback returns. */
+typedef struct bw_row {
+  const char *chars;
+  int len;
+} bw_row;
+
+typedef void (*bw_task)(void *arg);
+
+/* What the editor offers plugins. Everything but post and main may only
+ * be called on the editor's thread, that is from on_events or from a task
+ * passed to main. post runs fn(arg) on the plugin worker thread, one task
+ * at a time in order; main runs it on the editor's thread before the next
+ * frame, which is how results of work done by post get back. */
+typedef struct bw_host {
+  int abi;
+  int (*numrows)(void);
+  bw_row (*row)(int at);
+  const char *(*filename)(void);
+  void (*status)(const char *msg);
+  void (*post)(bw_task fn, void *arg);
+  void (*main)(bw_task fn, void *arg);
+} bw_host;
+
+/* on_events gets, once per frame, the events of the types in events
+ * since the last call, oldest first. unload, if set, is called before
+ * the editor exits. */
+typedef struct bw_plugin {
+  int abi;
+  const char *name;
+  unsigned events;
+  void (*on_events)(const bw_event *ev, int n, const bw_host *host);
+  void (*unload)(void);
+} bw_plugin;
+
+typedef const bw_plugin *(*bw_plugin_init_fn)(const bw_host *host);
+
+#ifdef __cplusplus
+}
+#endif
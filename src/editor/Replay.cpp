@@ -0,0 +1,70 @@
+#include "Replay.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Editor.h"
+#include "Terminal.h"
+
+/* Appends the keys of the trace at path; returns -1 if it cannot be read
+ * or has a malformed line, with errno or a message on stderr. */
+int replayLoad(const char *path, std::vector<std::string> *keys) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) return -1;
+
+  char *line = NULL;
+  size_t cap = 0;
+  int lineno = 0, ret = 0;
+  std::string key;
+  while (getline(&line, &cap, fp) != -1) {
+    lineno++;
+    if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') continue;
+    if (termUnescapeKey(line, &key) == -1) {
+      fprintf(stderr, "%s:%d: bad escape\n", path, lineno);
+      ret = -1;
+      break;
+    }
+    keys->push_back(key);
+  }
+  free(line);
+  fclose(fp);
+  return ret;
+}
+
+static double usSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::micro>(
+    std::chrono::steady_clock::now() - t0).count();
+}
+
+/* Replays keys against E, which must be set up on the memory backend,
+ * adding a step for each top-level key. Stops before a top-level Ctrl-Q,
+ * since quitting exits the process. */
+void replayRun(const std::vector<std::string> &keys,
+               std::vector<replayStep> *steps) {
+  for (const std::string &key : keys) termMemoryPush(key);
+  editorRefreshScreen();
+
+  while (termMemoryPending() > 0) {
+    if (termMemoryPeek() == std::string(1, CTRL_KEY('q'))) break;
+
+    replayStep step;
+    step.key = termMemoryPeek();
+    size_t pending = termMemoryPending();
+    long long written = termMemoryWritten();
+    int writes = termMemoryWrites();
+
+    auto t0 = std::chrono::steady_clock::now();
+    editorProcessKeypress();
+    step.process_us = usSince(t0);
+    t0 = std::chrono::steady_clock::now();
+    editorRefreshScreen();
+    step.frame_us = usSince(t0);
+
+    step.keys = pending - termMemoryPending();
+    step.frames = termMemoryWrites() - writes;
+    step.bytes = termMemoryWritten() - written;
+    steps->push_back(step);
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*** trace replay ***/
+
+/* A trace is a recording of the keys read in a session (see termRecord),
+ * one per line; blank lines and lines starting with '#' are skipped.
+ * Replaying one feeds it through the memory backend to the same
+ * editorProcessKeypress and editorRefreshScreen the main loop calls. */
+
+/* What one top-level key cost. keys counts the trace keys it consumed,
+ * more than one when it opened a prompt. process_us is the time spent in
+ * editorProcessKeypress (prompt redraws included) and frame_us the time
+ * of the refresh after it; frames and bytes count what both wrote. */
+struct replayStep {
+  std::string key;
+  int keys;
+  double process_us;
+  double frame_us;
+  int frames;
+  long long bytes;
+};
+
+int replayLoad(const char *path, std::vector<std::string> *keys);
+void replayRun(const std::vector<std::string> &keys,
+               std::vector<replayStep> *steps);
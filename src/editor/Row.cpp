@@ -1,2 +1,674 @@
+#include "Row.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
+#include "Arena.h"
+#include "DiffView.h"
+#include "Editor.h"
+#include "LineIndex.h"
+#include "Probe.h"
+#include "Syntax.h"
+#include "Undo.h"
+#include "Utf8.h"
+#include "Words.h"
+#include "Wrap.h"
+
+/*** gap buffers ***/
+
+/* Moves the gap of buf so that it starts at pos. */
+static void gapMove(char *buf, int *gap, int gaplen, int pos) {
+  if (gaplen && pos < *gap)
+    memmove(&buf[pos + gaplen], &buf[pos], *gap - pos);
+  else if (gaplen && pos > *gap)
+    memmove(&buf[*gap], &buf[*gap + gaplen], pos - *gap);
+  *gap = pos;
+}
+
+/* Copies the text of a gap buffer holding len bytes into a fresh buffer
+ * whose gap, at the same position, is gaplen bytes long. */
+static void gapCopy(char *dst, int gaplen, const char *src, int gap,
+                    int oldgaplen, int len) {
+  memcpy(dst, src, gap);
+  memcpy(&dst[gap + gaplen], &src[gap + oldgaplen], len - gap);
+}
+
+/* Row buffers come from E.arena, counted by kind in the memory counters
+ * (see Probe.h). */
+static void *rowAlloc(int kind, int size, int *cap) {
+  void *p = arenaAlloc(&E.arena, size, cap);
+  PROBE_MEM(kind, *cap);
+  return p;
+}
+
+static void rowFree(int kind, void *p, int cap) {
+  if (p) PROBE_MEM(kind, -cap);
+  arenaFree(&E.arena, p, cap);
+}
+
+/* Size to request when a gap of need bytes does not fit: leave some slack
+ * so that a run of keystrokes is amortised over one copy. */
+static int gapGrowth(int len, int need) {
+  return len + need + len / 8 + 16 + 1;
+}
+
+/* Makes room for need more bytes in the gap. A borrowed row is always
+ * copied into the arena, so rowCharsReserve(row, 0) makes it writable. */
+static void rowCharsReserve(erow *row, int need) {
+  if (row->gaplen >= need && !row->borrowed) return;
+  int oldcap = row->size + row->gaplen + 1;
+  int cap;
+  char *grown = (char *)rowAlloc(PROBE_MEM_ROWS, gapGrowth(row->size, need),
+                                 &cap);
+  int gaplen = cap - row->size - 1;
+  gapCopy(grown, gaplen, editorRowBuf(row), row->gap, row->gaplen, row->size);
+  if (oldcap > ROW_INLINE && !row->borrowed)
+    rowFree(PROBE_MEM_ROWS, row->chars, oldcap);
+  row->chars = grown;
+  row->gaplen = gaplen;
+  row->borrowed = 0;
+}
+
+/* render and hl share one gap, so they always move and grow together.
+ * Either may be absent: render while it is a view of chars, hl while the
+ * row has no highlighting. */
+static void renderGapMove(erow *row, int pos) {
+  if (row->hl) {
+    int hlgap = row->rgap;
+    gapMove((char *)row->hl, &hlgap, row->rgaplen, pos);
+  }
+  if (row->render) gapMove(row->render, &row->rgap, row->rgaplen, pos);
+  else row->rgap = pos;
+}
+
+static void renderGapReserve(erow *row, int need) {
+  if (row->rgaplen >= need) return;
+  int oldcap = row->rsize + row->rgaplen + 1;
+  int want = gapGrowth(row->rsize, need);
+  int cap = 0;
+
+  if (row->render) {
+    char *render = (char *)rowAlloc(PROBE_MEM_RENDER, want, &cap);
+    gapCopy(render, cap - row->rsize - 1, row->render, row->rgap,
+            row->rgaplen, row->rsize);
+    rowFree(PROBE_MEM_RENDER, row->render, oldcap);
+    row->render = render;
+  }
+
+  if (row->hl) {
+    char *hl = (char *)rowAlloc(PROBE_MEM_HL, want, &cap);
+    gapCopy(hl, cap - row->rsize - 1, (char *)row->hl, row->rgap,
+            row->rgaplen, row->rsize);
+    rowFree(PROBE_MEM_HL, row->hl, oldcap);
+    row->hl = (unsigned char *)hl;
+  }
+
+  row->rgaplen = cap ? cap - row->rsize - 1 : need;
+}
+
+char *editorRowChars(erow *row) {
+  if (row->borrowed) return editorRowBuf(row);
+  char *buf = editorRowBuf(row);
+  gapMove(buf, &row->gap, row->gaplen, row->size);
+  buf[row->size] = '\0';
+  return buf;
+}
+
+char *editorRowRender(erow *row) {
+  renderGapMove(row, row->rsize);
+  if (row->render == NULL) return editorRowChars(row);
+  row->render[row->rsize] = '\0';
+  return row->render;
+}
+
+unsigned char *editorRowHl(erow *row) {
+  editorRowRender(row);
+  if (row->hl == NULL) {
+    int cap;
+    row->hl = (unsigned char *)rowAlloc(
+        PROBE_MEM_HL, row->rsize + row->rgaplen + 1, &cap);
+    memset(row->hl, 0, cap);
+    row->rgaplen = cap - row->rsize - 1;
+  }
+  return row->hl;
+}
+
+void editorRowFreeHl(erow *row) {
+  rowFree(PROBE_MEM_HL, row->hl, row->rsize + row->rgaplen + 1);
+  row->hl = NULL;
+}
+
+/*** row operations ***/
+
+/* Decodes the code point starting at chars[at], reading through the gap. */
+static int rowCharDecode(const erow *row, int at, int *cp) {
+  char seq[4];
+  int n = 0;
+  while (n < 4 && at + n < row->size) {
+    seq[n] = editorRowCharAt(row, at + n);
+    n++;
+  }
+  return utf8Decode(seq, n, cp);
+}
+
+/* Copies the code point starting at render[at] into seq and decodes it. */
+int editorRowRenderDecode(const erow *row, int at, char *seq, int *cp) {
+  int n = 0;
+  while (n < 4 && at + n < row->rsize) {
+    seq[n] = editorRowRenderAt(row, at + n);
+    n++;
+  }
+  return utf8Decode(seq, n, cp);
+}
+
+/* Columns taken by the character at chars[cx] when it starts at column
+ * rx; its length in bytes is stored in *len. */
+static int rowCharWidth(const erow *row, int cx, int rx, int *len) {
+  char c = editorRowCharAt(row, cx);
+  *len = 1;
+  if (c == '\t')
+    return BYTE_WRITER_TAB_STOP - (rx % BYTE_WRITER_TAB_STOP);
+  if (!((unsigned char)c & 0x80)) return 1;
+
+  int cp;
+  *len = rowCharDecode(row, cx, &cp);
+  return utf8CharWidth(cp);
+}
+
+int editorRowCxToRx(erow *row, int cx) {
+  if (row->tabs == 0 && row->ascii) return cx;
+  int rx = 0;
+  int j = 0;
+  while (j < cx) {
+    int len;
+    rx += rowCharWidth(row, j, rx, &len);
+    j += len;
+  }
+  return rx;
+}
+
+int editorRowRxToCx(erow *row, int rx) {
+  if (row->tabs == 0 && row->ascii) return rx < row->size ? rx : row->size;
+  int cur_rx = 0;
+  int cx = 0;
+  while (cx < row->size) {
+    int len;
+    cur_rx += rowCharWidth(row, cx, cur_rx, &len);
+
+    if (cur_rx > rx) return cx;
+    cx += len;
+  }
+  return cx;
+}
+
+/* Maps a byte offset into render (e.g. a search match) back to cx. */
+int editorRowRenderToCx(erow *row, int roff) {
+  if (row->render == NULL) return roff < row->size ? roff : row->size;
+  int rx = 0;
+  int rpos = 0;
+  int cx = 0;
+  while (cx < row->size) {
+    int len;
+    int width = rowCharWidth(row, cx, rx, &len);
+    rx += width;
+    rpos += editorRowCharAt(row, cx) == '\t' ? width : len;
+
+    if (rpos > roff) return cx;
+    cx += len;
+  }
+  return cx;
+}
+
+/* Returns the offset in render of the first character that starts at or
+ * after column rx, and stores the column it starts at in *col. */
+int editorRowRxToRender(erow *row, int rx, int *col) {
+  if (row->render == NULL && row->ascii) {
+    *col = rx;
+    return rx < row->rsize ? rx : row->rsize;
+  }
+  int cur_rx = 0;
+  int j = 0;
+  while (j < row->rsize && cur_rx < rx) {
+    char seq[4];
+    int cp;
+    j += editorRowRenderDecode(row, j, seq, &cp);
+    cur_rx += utf8CharWidth(cp);
+  }
+  *col = cur_rx;
+  return j;
+}
+
+int editorRowPrevCx(erow *row, int cx) {
+  if (cx <= 0) return 0;
+  do {
+    cx--;
+  } while (cx > 0 && utf8IsCont(editorRowCharAt(row, cx)));
+  return cx;
+}
+
+int editorRowNextCx(erow *row, int cx) {
+  if (cx >= row->size) return row->size;
+  int cp;
+  return cx + rowCharDecode(row, cx, &cp);
+}
+
+/* Rebuilds render from chars, leaving hl to be filled in. */
+static void rowRender(erow *row) {
+  char *chars = editorRowChars(row);
+
+  int tabs = 0;
+  int j;
+  for (j = 0; j < row->size; j++)
+    if (chars[j] == '\t') tabs++;
+  row->tabs = tabs;
+  row->ascii = utf8IsAscii(chars, row->size);
+
+  /* Rows without tabs render exactly as they are stored, so render is
+   * left NULL and read through chars; only rows that expand get a copy. */
+  int rsize = row->size;
+  int maxrsize = row->size + tabs*(BYTE_WRITER_TAB_STOP - 1);
+  int rcap = row->rsize + row->rgaplen + 1;
+  if (rcap < maxrsize + 1) {
+    rowFree(PROBE_MEM_RENDER, row->render, rcap);
+    row->render = NULL;
+    editorRowFreeHl(row);
+  }
+  if (tabs == 0) {
+    rowFree(PROBE_MEM_RENDER, row->render, rcap);
+    row->render = NULL;
+  }
+  if (row->render == NULL && row->hl == NULL) rcap = maxrsize + 1;
+
+  if (tabs) {
+    if (row->render == NULL)
+      row->render = (char *)rowAlloc(PROBE_MEM_RENDER, rcap, &rcap);
+
+    int idx = 0;
+    int col = 0;
+    for (j = 0; j < row->size;) {
+      if (chars[j] == '\t') {
+        do {
+          row->render[idx++] = ' ';
+          col++;
+        } while (col % BYTE_WRITER_TAB_STOP != 0);
+        j++;
+      } else if (row->ascii) {
+        row->render[idx++] = chars[j++];
+        col++;
+      } else {
+        int cp;
+        int len = utf8Decode(&chars[j], row->size - j, &cp);
+        memcpy(&row->render[idx], &chars[j], len);
+        idx += len;
+        j += len;
+        col += utf8CharWidth(cp);
+      }
+    }
+    row->render[idx] = '\0';
+    rsize = idx;
+  }
+  row->rsize = rsize;
+  row->rgap = rsize;
+  row->rgaplen = rcap - rsize - 1;
+}
+
+void editorUpdateRow(erow *row) {
+  rowRender(row);
+  editorUpdateSyntax(row);
+}
+
+/* Rows at or past E.hlrows were loaded without render or hl (see
+ * editorAppendBorrowedRows). They are prepared strictly in order so that
+ * each one starts with the comment state of the row above. */
+void editorPrepareRows(int upto) {
+  if (upto > E.numrows) upto = E.numrows;
+  while (E.hlrows < upto) {
+    E.hlrows++;
+    editorUpdateRow(&E.row[E.hlrows - 1]);
+  }
+}
+
+/* Brings hl up to date after chars[at, at + inserted) was inserted or
+ * deleted chars were removed at at. Only valid while the row has no tabs:
+ * render is then a view of chars and only hl has to follow the edit. */
+static void editorUpdateRowWindow(erow *row, int at, int inserted,
+                                  int deleted) {
+  if (row->hl == NULL) {
+    row->rsize = row->size;
+    row->rgap = row->rsize;
+    row->rgaplen = 0;
+    return;
+  }
+
+  if (deleted) {
+    renderGapMove(row, at);
+    row->rgaplen += deleted;
+    row->rsize -= deleted;
+  }
+
+  if (inserted) {
+    renderGapReserve(row, inserted);
+    renderGapMove(row, at);
+    memset(&row->hl[at], HL_NORMAL, inserted);
+    row->rgap += inserted;
+    row->rgaplen -= inserted;
+    row->rsize += inserted;
+  }
+
+  editorUpdateSyntaxWindow(row, at, at + inserted);
+}
+
+/* Fills in a row holding a copy of s, not yet rendered or highlighted. */
+static void rowInit(erow *row, const char *s, size_t len) {
+  memset(row, 0, sizeof(*row));
+  row->size = len;
+  row->gap = len;
+  if (len + 1 <= ROW_INLINE) {
+    row->gaplen = ROW_INLINE - len - 1;
+  } else {
+    int cap;
+    row->chars = (char *)rowAlloc(PROBE_MEM_ROWS, len + 1, &cap);
+    row->gaplen = cap - len - 1;
+  }
+  memcpy(editorRowBuf(row), s, len);
+}
+
+static void rowsReserve(int n) {
+  if (E.numrows + n <= E.rowcap) return;
+  PROBE_MEM(PROBE_MEM_ROWS, -(int64_t)sizeof(erow) * E.rowcap);
+  while (E.rowcap < E.numrows + n) E.rowcap = E.rowcap ? E.rowcap * 2 : 64;
+  PROBE_MEM(PROBE_MEM_ROWS, (int64_t)sizeof(erow) * E.rowcap);
+  E.row = (erow *)realloc(E.row, sizeof(erow) * E.rowcap);
+}
+
+void editorInsertRow(int at, const char *s, size_t len) {
+  if (at < 0 || at > E.numrows) return;
+
+  /* Copy the text before touching E.row: s may point into a row's inline
+   * storage, which moves when the array does. */
+  erow row;
+  rowInit(&row, s, len);
+
+  rowsReserve(1);
+  memmove(&E.row[at + 1], &E.row[at], sizeof(erow) * (E.numrows - at));
+  E.row[at] = row;
+  if (at <= E.hlrows) {
+    E.hlrows++;
+    editorUpdateRow(&E.row[at]);
+  }
+
+  E.numrows++;
+  editorIndexInsertRow(at);
+  editorWrapInsertRow(at);
+  editorWordsInsertRow(at);
+  editorDiffInsertRow(at);
+  editorUndoAddRow(at);
+  editorPluginEvent(BW_EV_EDIT, BW_EDIT_INSERT, at, 1);
+  E.dirty++;
+}
+
+/* Appends rows whose text stays in the copy of the file at base, line i
+ * being lens[i] bytes at offsets[i]. Nothing is read from the file: the
+ * text is read when first used (editorMapLoad), and the rows are prepared
+ * (editorPrepareRows) when they are first shown or edited. */
+void editorAppendBorrowedRows(const char *base, const unsigned long long *offsets,
+                              const unsigned *lens, int n) {
+  editorUndoClear();
+  rowsReserve(n);
+  for (int i = 0; i < n; i++) {
+    erow *row = &E.row[E.numrows + i];
+    memset(row, 0, sizeof(*row));
+    row->chars = (char *)base + offsets[i];
+    row->size = lens[i];
+    row->gap = lens[i];
+    row->borrowed = 1;
+  }
+  E.numrows += n;
+
+  std::vector<int> lines(E.numrows);
+  for (int i = 0; i < E.numrows; i++) lines[i] = E.row[i].size + 1;
+  fwInit(&E.lines, lines.data(), E.numrows);
+  if (E.layout.width) editorWrapBuild(E.layout.width);
+  for (int i = E.numrows - n; i < E.numrows; i++) {
+    editorWordsInsertRow(i);
+    editorDiffInsertRow(i);
+  }
+  editorPluginEvent(BW_EV_EDIT, BW_EDIT_INSERT, E.numrows - n, n);
+  E.dirty++;
+}
+
+/* Appends copies of n lines, line i being lens[i] bytes at
+ * text + starts[i]. Like borrowed rows they are left for editorPrepareRows,
+ * so a batch of appended lines is only scanned once it is shown. */
+void editorAppendRows(const char *text, const size_t *starts,
+                      const size_t *lens, int n) {
+  editorUndoReplaceRows(E.numrows, 0, n);
+  rowsReserve(n);
+  for (int i = 0; i < n; i++) {
+    int at = E.numrows;
+    rowInit(&E.row[at], text + starts[i], lens[i]);
+    E.numrows++;
+    editorIndexInsertRow(at);
+    editorWrapInsertRow(at);
+    editorWordsInsertRow(at);
+    editorDiffInsertRow(at);
+  }
+  editorPluginEvent(BW_EV_EDIT, BW_EDIT_INSERT, E.numrows - n, n);
+  E.dirty++;
+}
+
+/* Replaces rows [at, at + count) with copies of n lines, laid out as for
+ * editorAppendRows, moving the rows below only once. The new rows are
+ * prepared if the first replaced one was. */
+void editorReplaceRows(int at, int count, const char *text,
+                       const size_t *starts, const size_t *lens, int n) {
+  if (at < 0 || count < 0 || at + count > E.numrows) return;
+  editorUndoReplaceRows(at, count, n);
+
+  int prepared = at < E.hlrows;
+  int below = E.hlrows - (at + count);
+  if (below < 0) below = 0;
+  for (int i = at + count - 1; i >= at; i--) {
+    editorWordsDelRow(i);
+    editorFreeRow(&E.row[i]);
+    editorIndexDelRow(i);
+    editorWrapDelRow(i);
+    editorDiffDelRow(i);
+  }
+
+  if (n > count) rowsReserve(n - count);
+  memmove(&E.row[at + n], &E.row[at + count],
+          sizeof(erow) * (E.numrows - at - count));
+  E.numrows += n - count;
+  for (int i = 0; i < n; i++) rowInit(&E.row[at + i], text + starts[i], lens[i]);
+
+  /* Raise the watermark one row at a time so that highlighting a new row
+   * never spills into the next, which is not rendered yet. */
+  if (prepared) E.hlrows = at;
+  for (int i = 0; i < n; i++) {
+    if (prepared) {
+      E.hlrows++;
+      editorUpdateRow(&E.row[at + i]);
+    }
+    editorIndexInsertRow(at + i);
+    editorWrapInsertRow(at + i);
+    editorWordsInsertRow(at + i);
+    editorDiffInsertRow(at + i);
+  }
+  if (prepared) {
+    E.hlrows += below;
+    if (below) editorUpdateSyntax(&E.row[at + n]);
+  }
+  if (count) editorPluginEvent(BW_EV_EDIT, BW_EDIT_DELETE, at, count);
+  if (n) editorPluginEvent(BW_EV_EDIT, BW_EDIT_INSERT, at, n);
+  E.dirty++;
+}
+
+void editorFreeRow(erow *row) {
+  int rcap = row->rsize + row->rgaplen + 1;
+  rowFree(PROBE_MEM_RENDER, row->render, rcap);
+  rowFree(PROBE_MEM_HL, row->hl, rcap);
+  if (!editorRowIsInline(row) && !row->borrowed)
+    rowFree(PROBE_MEM_ROWS, row->chars, row->size + row->gaplen + 1);
+}
+
+void editorDelRow(int at) {
+  if (at < 0 || at >= E.numrows) return;
+  editorUndoDelRow(at);
+  editorWordsDelRow(at);
+  editorFreeRow(&E.row[at]);
+  memmove(&E.row[at], &E.row[at + 1], sizeof(erow) * (E.numrows - at - 1));
+  E.numrows--;
+  if (at < E.hlrows) E.hlrows--;
+  editorIndexDelRow(at);
+  editorWrapDelRow(at);
+  editorDiffDelRow(at);
+  editorPluginEvent(BW_EV_EDIT, BW_EDIT_DELETE, at, 1);
+  E.dirty++;
+}
+
+void editorRowInsertChar(erow *row, int at, int c) {
+  editorPrepareRows(row - E.row + 1);
+  if (at < 0 || at > row->size) at = row->size;
+  editorWordsDelSpan(row - E.row, at, at);
+  editorUndoText(row - E.row, at, 1, "", 0);
+  rowCharsReserve(row, 1);
+  char *buf = editorRowBuf(row);
+  gapMove(buf, &row->gap, row->gaplen, at);
+  buf[row->gap++] = c;
+  row->gaplen--;
+  row->size++;
+  if (c & 0x80) row->ascii = 0;
+
+  if (c != '\t' && row->tabs == 0 && row->size >= ROW_GAP_MIN) {
+    editorUpdateRowWindow(row, at, 1, 0);
+  } else {
+    editorUpdateRow(row);
+  }
+  editorIndexUpdateRow(row - E.row);
+  editorWrapUpdateRow(row - E.row);
+  editorWordsInsertSpan(row - E.row, at, at + 1);
+  editorDiffUpdateRow(row - E.row);
+  editorPluginEvent(BW_EV_EDIT, BW_EDIT_TEXT, row - E.row, 1);
+  E.dirty++;
+}
+
+void editorRowAppendString(erow *row, const char *s, size_t len) {
+  editorPrepareRows(row - E.row + 1);
+  editorWordsDelRow(row - E.row);
+  editorUndoText(row - E.row, row->size, len, "", 0);
+  rowCharsReserve(row, len);
+  char *buf = editorRowBuf(row);
+  gapMove(buf, &row->gap, row->gaplen, row->size);
+  memcpy(&buf[row->size], s, len);
+  row->size += len;
+  row->gap += len;
+  row->gaplen -= len;
+  editorUpdateRow(row);
+  editorIndexUpdateRow(row - E.row);
+  editorWrapUpdateRow(row - E.row);
+  editorWordsInsertRow(row - E.row);
+  editorDiffUpdateRow(row - E.row);
+  editorPluginEvent(BW_EV_EDIT, BW_EDIT_TEXT, row - E.row, 1);
+  E.dirty++;
+}
+
+void editorRowDelChar(erow *row, int at) {
+  if (at < 0 || at >= row->size) return;
+  editorPrepareRows(row - E.row + 1);
+  editorWordsDelSpan(row - E.row, at, at + 1);
+  rowCharsReserve(row, 0);
+  char c = editorRowCharAt(row, at);
+  editorUndoText(row - E.row, at, 0, &c, 1);
+  gapMove(editorRowBuf(row), &row->gap, row->gaplen, at);
+  row->gaplen++;
+  row->size--;
+
+  if (c != '\t' && row->tabs == 0 && row->size >= ROW_GAP_MIN) {
+    editorUpdateRowWindow(row, at, 0, 1);
+  } else {
+    editorUpdateRow(row);
+  }
+  editorIndexUpdateRow(row - E.row);
+  editorWrapUpdateRow(row - E.row);
+  editorWordsInsertSpan(row - E.row, at, at);
+  editorDiffUpdateRow(row - E.row);
+  editorPluginEvent(BW_EV_EDIT, BW_EDIT_TEXT, row - E.row, 1);
+  E.dirty++;
+}
+
+void editorRowTruncate(erow *row, int at) {
+  if (at < 0 || at >= row->size) return;
+  editorPrepareRows(row - E.row + 1);
+  editorWordsDelRow(row - E.row);
+  editorUndoText(row - E.row, at, 0, editorRowChars(row) + at, row->size - at);
+  rowCharsReserve(row, 0);
+  gapMove(editorRowBuf(row), &row->gap, row->gaplen, at);
+  row->gaplen += row->size - at;
+  row->size = at;
+  editorUpdateRow(row);
+  editorIndexUpdateRow(row - E.row);
+  editorWrapUpdateRow(row - E.row);
+  editorWordsInsertRow(row - E.row);
+  editorDiffUpdateRow(row - E.row);
+  editorPluginEvent(BW_EV_EDIT, BW_EDIT_TEXT, row - E.row, 1);
+}
+
+/* Replaces the text of rows[0, n), which must be ascending, with lens[i]
+ * bytes at texts[i]. Every row is rewritten and re-rendered once, then
+ * all are re-highlighted in one sweep down the buffer that carries a
+ * changed comment state over the rows below only once, however many of
+ * the rows it crosses were rewritten. */
+void editorRowsSetText(const int *rows, const char *const *texts,
+                       const size_t *lens, int n) {
+  if (n == 0) return;
+  editorPrepareRows(rows[n - 1] + 1);
+
+  for (int i = 0; i < n; i++) {
+    int at = rows[i];
+    erow *row = &E.row[at];
+    int len = lens[i];
+    editorWordsDelRow(at);
+
+    const char *old = editorRowChars(row);
+    int lo = 0;
+    while (lo < len && lo < row->size && old[lo] == texts[i][lo]) lo++;
+    int hi = 0;
+    while (hi < len - lo && hi < row->size - lo &&
+           old[row->size - 1 - hi] == texts[i][len - 1 - hi])
+      hi++;
+    editorUndoText(at, lo, len - lo - hi, old + lo, row->size - lo - hi);
+
+    if (row->size + row->gaplen < len || row->borrowed) {
+      int cap;
+      char *grown = (char *)rowAlloc(PROBE_MEM_ROWS, gapGrowth(len, 0), &cap);
+      if (!editorRowIsInline(row) && !row->borrowed)
+        rowFree(PROBE_MEM_ROWS, row->chars, row->size + row->gaplen + 1);
+      row->chars = grown;
+      row->gaplen = cap - len - 1;
+      row->borrowed = 0;
+    } else {
+      row->gaplen += row->size - len;
+    }
+    row->size = len;
+    row->gap = len;
+    memcpy(editorRowBuf(row), texts[i], len);
+
+    rowRender(row);
+    editorIndexUpdateRow(at);
+    editorWrapUpdateRow(at);
+    editorWordsInsertRow(at);
+    editorDiffUpdateRow(at);
+    editorPluginEvent(BW_EV_EDIT, BW_EDIT_TEXT, at, 1);
+  }
+
+  int done = 0;
+  for (int i = 0; i < n; i++) {
+    int at = rows[i];
+    if (at < done) continue;
+    while (at < E.hlrows && editorHighlightRow(&E.row[at])) at++;
+    done = at + 1;
+  }
+  E.dirty++;
+}
@@ -1,2 +1,127 @@
+#pragma once
 
+#include <cstddef>
 
+#define BYTE_WRITER_TAB_STOP 8
+
+/* Rows at least this long are edited in place: a keystroke moves the gap
+ * and re-renders/re-highlights only the window around the edit instead of
+ * rebuilding the whole line. */
+#define ROW_GAP_MIN 256
+
+/* Rows whose text (gap and terminator included) fits in this many bytes
+ * keep it inside the erow itself instead of in an arena block. */
+#define ROW_INLINE 16
+
+/* chars is a gap buffer: the text is chars[0, gap) followed by
+ * chars[gap + gaplen, size + gaplen). Its capacity is always
+ * size + gaplen + 1, and a row whose capacity is at most ROW_INLINE stores
+ * the buffer in inl. render and hl share a second gap (rgap, rgaplen) and
+ * the capacity rsize + rgaplen + 1. render is NULL unless the row contains
+ * tabs; otherwise it renders exactly as stored and the render accessors
+ * read chars. hl is NULL while the row has no highlighting. All buffers
+ * come from the document's arena (E.arena).
+ *
+ * Text is UTF-8. cx counts bytes of chars and rx counts terminal columns;
+ * ascii is set when the row was last found to be pure ASCII, in which case
+ * (without tabs) the two are the same. wrap_exact belongs to the soft-wrap
+ * layout (see Wrap.h).
+ *
+ * A borrowed row's chars point into E.map, the private copy of the file
+ * that editorOpen fills in as rows are first read (borrowed is 1 until
+ * then, 2 after), so later writes to the file do not reach text already
+ * read; the text is not NUL-terminated, and is copied into the arena
+ * before the row is first edited.
+ *
+ * Since short rows store their text inline, pointers returned by
+ * editorRowChars are only valid until rows are next inserted or deleted.
+ * Use the accessors below rather than indexing the buffers directly. */
+typedef struct erow {
+  union {
+    char *chars;
+    char inl[ROW_INLINE];
+  };
+  char *render;
+  unsigned char *hl;
+  int size;
+  int rsize;
+  int gap;
+  int gaplen;
+  int rgap;
+  int rgaplen;
+  int tabs;
+  unsigned char hl_open_comment;
+  unsigned char ascii;
+  unsigned char wrap_exact;
+  unsigned char borrowed;
+} erow;
+
+inline int editorRowIsInline(const erow *row) {
+  return !row->borrowed && row->size + row->gaplen + 1 <= ROW_INLINE;
+}
+
+void editorMapLoad(const erow *row);
+
+inline char *editorRowBuf(erow *row) {
+  if (row->borrowed == 1) editorMapLoad(row);
+  return editorRowIsInline(row) ? row->inl : row->chars;
+}
+
+inline const char *editorRowBuf(const erow *row) {
+  if (row->borrowed == 1) editorMapLoad(row);
+  return editorRowIsInline(row) ? row->inl : row->chars;
+}
+
+char *editorRowChars(erow *row);
+char *editorRowRender(erow *row);
+unsigned char *editorRowHl(erow *row);
+void editorRowFreeHl(erow *row);
+
+inline char editorRowCharAt(const erow *row, int at) {
+  if (at >= row->size) return '\0';
+  const char *buf = editorRowBuf(row);
+  return at < row->gap ? buf[at] : buf[at + row->gaplen];
+}
+
+inline char editorRowRenderAt(const erow *row, int at) {
+  if (row->render == NULL) return editorRowCharAt(row, at);
+  if (at >= row->rsize) return '\0';
+  return at < row->rgap ? row->render[at] : row->render[at + row->rgaplen];
+}
+
+inline unsigned char editorRowHlAt(const erow *row, int at) {
+  if (row->hl == NULL) return 0;
+  return at < row->rgap ? row->hl[at] : row->hl[at + row->rgaplen];
+}
+
+inline void editorRowSetHl(erow *row, int at, unsigned char hl) {
+  if (at < row->rgap) row->hl[at] = hl;
+  else row->hl[at + row->rgaplen] = hl;
+}
+
+/*** row operations ***/
+
+int editorRowCxToRx(erow *row, int cx);
+int editorRowRxToCx(erow *row, int rx);
+int editorRowRenderToCx(erow *row, int roff);
+int editorRowRxToRender(erow *row, int rx, int *col);
+int editorRowRenderDecode(const erow *row, int at, char *seq, int *cp);
+int editorRowPrevCx(erow *row, int cx);
+int editorRowNextCx(erow *row, int cx);
+void editorUpdateRow(erow *row);
+void editorPrepareRows(int upto);
+void editorInsertRow(int at, const char *s, size_t len);
+void editorAppendBorrowedRows(const char *base, const unsigned long long *offsets,
+                              const unsigned *lens, int n);
+void editorAppendRows(const char *text, const size_t *starts,
+                      const size_t *lens, int n);
+void editorReplaceRows(int at, int count, const char *text,
+                       const size_t *starts, const size_t *lens, int n);
+void editorFreeRow(erow *row);
+void editorDelRow(int at);
+void editorRowInsertChar(erow *row, int at, int c);
+void editorRowAppendString(erow *row, const char *s, size_t len);
+void editorRowDelChar(erow *row, int at);
+void editorRowTruncate(erow *row, int at);
+void editorRowsSetText(const int *rows, const char *const *texts,
+                       const size_t *lens, int n);
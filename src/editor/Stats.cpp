@@ -0,0 +1,132 @@
+#include "Stats.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "Editor.h"
+#include "Probe.h"
+
+#define STATS_WIDTH 48
+
+void editorStatsToggle() {
+#ifdef BYTE_WRITER_PROBES
+  E.stats = !E.stats;
+#else
+  editorSetStatusMessage("Built without probes (BYTE_WRITER_PROBES=OFF)");
+#endif
+}
+
+static double statsUs(uint64_t ns) {
+  return ns / 1000.0;
+}
+
+/* Formats a byte count in at most 7 characters. */
+static void statsBytes(char *buf, size_t size, int64_t bytes) {
+  if (bytes < 10 * 1024) snprintf(buf, size, "%lldB", (long long)bytes);
+  else if (bytes < 10 << 20) snprintf(buf, size, "%.1fK", bytes / 1024.0);
+  else snprintf(buf, size, "%.1fM", bytes / 1048576.0);
+}
+
+/* Paints the overlay onto a frame that has already been drawn. */
+void editorStatsDraw(struct abuf *ab) {
+  char lines[PROBE_COUNT + 3][80];
+  int n = 0;
+
+  snprintf(lines[n++], sizeof(lines[0]), " %-8s %7s %9s %9s %9s", "us",
+           "count", "p50", "p99", "max");
+  for (int id = 0; id < PROBE_COUNT; id++) {
+    unsigned long long count =
+        probeHists[id].count.load(std::memory_order_relaxed);
+    snprintf(lines[n++], sizeof(lines[0]), " %-8s %7llu %9.1f %9.1f %9.1f",
+             probeName(id), count, statsUs(probeQuantile(id, 0.5)),
+             statsUs(probeQuantile(id, 0.99)), statsUs(probeQuantile(id, 1)));
+  }
+  char mem[PROBE_MEM_COUNT][24];
+  for (int k = 0; k < PROBE_MEM_COUNT; k++)
+    statsBytes(mem[k], sizeof(mem[k]),
+               probeMem[k].load(std::memory_order_relaxed));
+  snprintf(lines[n++], sizeof(lines[0]), " %s %s  %s %s", probeMemName(0),
+           mem[0], probeMemName(1), mem[1]);
+  snprintf(lines[n++], sizeof(lines[0]), " %s %s  %s %s", probeMemName(2),
+           mem[2], probeMemName(3), mem[3]);
+
+  int width = STATS_WIDTH < E.screencols ? STATS_WIDTH : E.screencols;
+  int col = E.screencols - width + 1;
+  if (n > E.screenrows) n = E.screenrows;
+  for (int i = 0; i < n; i++) {
+    char pos[32];
+    snprintf(pos, sizeof(pos), "\x1b[%d;%dH\x1b[7m", i + 1, col);
+    abAppend(ab, pos, strlen(pos));
+    int len = strlen(lines[i]);
+    if (len > width) len = width;
+    abAppend(ab, lines[i], len);
+    for (; len < width; len++) abAppend(ab, " ", 1);
+    abAppend(ab, "\x1b[m", 3);
+  }
+}
+
+/* Writes every probe's summary and non-empty buckets, and the memory
+ * counters, to path. Returns -1 with errno set if it cannot. */
+int editorStatsDump(const char *path) {
+  FILE *fp = fopen(path, "w");
+  if (!fp) return -1;
+
+  fprintf(fp, "# byte-writer stats, pid %d, time %lld\n", (int)getpid(),
+          (long long)time(NULL));
+  fprintf(fp, "# probe count mean_us p50_us p90_us p99_us p999_us max_us\n");
+  for (int id = 0; id < PROBE_COUNT; id++) {
+    uint64_t count = probeHists[id].count.load(std::memory_order_relaxed);
+    uint64_t sum = probeHists[id].sum.load(std::memory_order_relaxed);
+    fprintf(fp, "%s %llu %.3f %.3f %.3f %.3f %.3f %.3f\n", probeName(id),
+            (unsigned long long)count, count ? statsUs(sum) / count : 0.0,
+            statsUs(probeQuantile(id, 0.5)), statsUs(probeQuantile(id, 0.9)),
+            statsUs(probeQuantile(id, 0.99)), statsUs(probeQuantile(id, 0.999)),
+            statsUs(probeQuantile(id, 1)));
+  }
+  fprintf(fp, "# memory bytes\n");
+  for (int k = 0; k < PROBE_MEM_COUNT; k++)
+    fprintf(fp, "mem %s %lld\n", probeMemName(k),
+            (long long)probeMem[k].load(std::memory_order_relaxed));
+  fprintf(fp, "# buckets: probe lowest_ns count\n");
+  for (int id = 0; id < PROBE_COUNT; id++) {
+    for (int b = 0; b < PROBE_BUCKETS; b++) {
+      uint64_t count = probeHists[id].buckets[b].load(std::memory_order_relaxed);
+      if (count)
+        fprintf(fp, "bucket %s %llu %llu\n", probeName(id),
+                (unsigned long long)probeBucketLow(b),
+                (unsigned long long)count);
+    }
+  }
+  return fclose(fp) == 0 ? 0 : -1;
+}
+
+static volatile sig_atomic_t dumpRequested = 0;
+
+/* Called from the SIGUSR1 handler: the dump itself happens on the main
+ * thread, which editorWake rouses. */
+void editorStatsRequestDump() {
+  dumpRequested = 1;
+  editorWake();
+}
+
+/* Writes the dump asked for by SIGUSR1, if any. */
+void editorStatsPoll() {
+  if (!dumpRequested) return;
+  dumpRequested = 0;
+
+  std::string path;
+  const char *env = getenv("BYTE_WRITER_STATS");
+  if (env && *env) path = env;
+  else path = "/tmp/byte-writer-" + std::to_string(getpid()) + ".stats";
+  if (editorStatsDump(path.c_str()) == 0)
+    editorSetStatusMessage("Stats written to %s", path.c_str());
+  else
+    editorSetStatusMessage("Can't write stats: %s", strerror(errno));
+}
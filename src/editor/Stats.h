@@ -0,0 +1,15 @@
+#pragma once
+
+struct abuf;
+
+/*** stats overlay ***/
+
+/* Ctrl-Y shows the probe histograms and memory counters (see Probe.h)
+ * over the top right of the screen, updated every frame. SIGUSR1 writes
+ * them in full to $BYTE_WRITER_STATS, or /tmp/byte-writer-PID.stats. */
+
+void editorStatsToggle();
+void editorStatsDraw(struct abuf *ab);
+int editorStatsDump(const char *path);
+void editorStatsRequestDump();
+void editorStatsPoll();
@@ -1,2 +1,312 @@
+#include "Syntax.h"
 
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 
+#include "Editor.h"
+#include "Probe.h"
+#include "Row.h"
+
+/*** filetypes ***/
+
+static const char *C_HL_extensions[] = { ".c", ".h", ".cpp", NULL };
+static const char *C_HL_keywords[] = {
+  "switch", "if", "while", "for", "break", "continue", "return", "else",
+  "struct", "union", "typedef", "static", "enum", "class", "case",
+
+  "int|", "long|", "double|", "float|", "char|", "unsigned|", "signed|",
+  "void|", NULL
+};
+
+static struct editorSyntax HLDB[] = {
+  {
+    "c",
+    C_HL_extensions,
+    C_HL_keywords,
+    "//", "/*", "*/",
+    HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS
+  },
+};
+
+#define HLDB_ENTRIES (sizeof(HLDB) / sizeof(HLDB[0]))
+
+/*** syntax highlighting ***/
+
+int is_separator(int c) {
+  return isspace(c) || c == '\0' || strchr(",.()+-/*=~%<>[];", c) != NULL;
+}
+
+/* Destination of a highlighting pass. A full pass writes straight into the
+ * row's (compacted) hl; a windowed pass writes into scratch space that grows
+ * as the scan advances, so the old highlighting stays readable until the
+ * pass is done. */
+struct hlOut {
+  unsigned char *hl;
+  int cap;
+  int owned;
+};
+
+static void hlReserve(hlOut *out, int n) {
+  if (!out->owned || n <= out->cap) return;
+  int cap = out->cap ? out->cap : 64;
+  while (cap < n) cap *= 2;
+  out->hl = (unsigned char *)realloc(out->hl, cap);
+  memset(&out->hl[out->cap], HL_NORMAL, cap - out->cap);
+  out->cap = cap;
+}
+
+static void hlFill(hlOut *out, int at, unsigned char hl, int len) {
+  hlReserve(out, at + len);
+  memset(&out->hl[at], hl, len);
+}
+
+static int renderMatch(const erow *row, int at, const char *s, int len) {
+  for (int k = 0; k < len; k++)
+    if (editorRowRenderAt(row, at + k) != s[k]) return 0;
+  return 1;
+}
+
+/* Highlights row from column start, entering with no open string and the
+ * given multi-line comment state; out->hl[0] corresponds to column start.
+ * When stop >= 0 the pass ends at the first column past stop where the new
+ * and the existing highlighting agree on the state, since everything from
+ * there to the end of the row is unchanged. Returns the column the pass
+ * ended at and stores the comment state the row ends in. */
+static int highlightScan(erow *row, int start, int in_comment, int stop,
+                         hlOut *out, int *open_comment) {
+  const char **keywords = E.syntax->keywords;
+
+  const char *scs = E.syntax->singleline_comment_start;
+  const char *mcs = E.syntax->multiline_comment_start;
+  const char *mce = E.syntax->multiline_comment_end;
+
+  int scs_len = scs ? strlen(scs) : 0;
+  int mcs_len = mcs ? strlen(mcs) : 0;
+  int mce_len = mce ? strlen(mce) : 0;
+
+  int prev_sep = 1;
+  int in_string = 0;
+
+  int i = start;
+  while (i < row->rsize) {
+    hlReserve(out, i - start + 1);
+
+    if (stop >= 0 && i > stop && !in_string && !in_comment &&
+        out->hl[i - 1 - start] == HL_NORMAL &&
+        editorRowHlAt(row, i - 1) == HL_NORMAL &&
+        is_separator(editorRowRenderAt(row, i - 1))) {
+      *open_comment = row->hl_open_comment;
+      return i;
+    }
+
+    char c = editorRowRenderAt(row, i);
+    unsigned char prev_hl =
+        (i > start) ? out->hl[i - 1 - start] : (unsigned char)HL_NORMAL;
+
+    if (scs_len && !in_string && !in_comment) {
+      if (renderMatch(row, i, scs, scs_len)) {
+        if (stop >= 0 && i > stop && editorRowHlAt(row, i) == HL_COMMENT) {
+          *open_comment = row->hl_open_comment;
+          return i;
+        }
+        hlFill(out, i - start, HL_COMMENT, row->rsize - i);
+        break;
+      }
+    }
+
+    if (mcs_len && mce_len && !in_string) {
+      if (in_comment) {
+        out->hl[i - start] = HL_MLCOMMENT;
+        if (renderMatch(row, i, mce, mce_len)) {
+          hlFill(out, i - start, HL_MLCOMMENT, mce_len);
+          i += mce_len;
+          in_comment = 0;
+          prev_sep = 1;
+          continue;
+        } else {
+          i++;
+          continue;
+        }
+      } else if (renderMatch(row, i, mcs, mcs_len)) {
+        hlFill(out, i - start, HL_MLCOMMENT, mcs_len);
+        i += mcs_len;
+        in_comment = 1;
+        continue;
+      }
+    }
+
+    if (E.syntax->flags & HL_HIGHLIGHT_STRINGS) {
+      if (in_string) {
+        out->hl[i - start] = HL_STRING;
+        if (c == '\\' && i + 1 < row->rsize) {
+          hlFill(out, i + 1 - start, HL_STRING, 1);
+          i += 2;
+          continue;
+        }
+        if (c == in_string) in_string = 0;
+        i++;
+        prev_sep = 1;
+        continue;
+      } else {
+        if (c == '"' || c == '\'') {
+          in_string = c;
+          out->hl[i - start] = HL_STRING;
+          i++;
+          continue;
+        }
+      }
+    }
+
+    if (E.syntax->flags & HL_HIGHLIGHT_NUMBERS) {
+      if ((isdigit(c) && (prev_sep || prev_hl == HL_NUMBER)) ||
+          (c == '.' && prev_hl == HL_NUMBER)) {
+        out->hl[i - start] = HL_NUMBER;
+        i++;
+        prev_sep = 0;
+        continue;
+      }
+    }
+
+    if (prev_sep) {
+      int j;
+      for (j = 0; keywords[j]; j++) {
+        int klen = strlen(keywords[j]);
+        int kw2 = keywords[j][klen - 1] == '|';
+        if (kw2) klen--;
+
+        if (renderMatch(row, i, keywords[j], klen) &&
+            is_separator(editorRowRenderAt(row, i + klen))) {
+          hlFill(out, i - start, kw2 ? HL_KEYWORD2 : HL_KEYWORD1, klen);
+          i += klen;
+          break;
+        }
+      }
+      if (keywords[j] != NULL) {
+        prev_sep = 0;
+        continue;
+      }
+    }
+
+    prev_sep = is_separator(c);
+    i++;
+  }
+
+  *open_comment = in_comment;
+  return row->rsize;
+}
+
+/* Highlights row from the comment state left open by the row above, and
+ * returns whether the state it leaves open for the row below changed. */
+int editorHighlightRow(erow *row) {
+  if (E.syntax == NULL) {
+    editorRowRender(row);
+    editorRowFreeHl(row);
+    return 0;
+  }
+
+  unsigned char *hl = editorRowHl(row);
+  memset(hl, HL_NORMAL, row->rsize);
+
+  int at = row - E.row;
+  int in_comment = (at > 0 && E.row[at - 1].hl_open_comment);
+  hlOut out = { hl, row->rsize, 0 };
+  int open_comment;
+  highlightScan(row, 0, in_comment, -1, &out, &open_comment);
+
+  int changed = (row->hl_open_comment != open_comment);
+  row->hl_open_comment = open_comment;
+  return changed;
+}
+
+void editorUpdateSyntax(erow *row) {
+  PROBE(PROBE_SYNTAX);
+  while (editorHighlightRow(row)) {
+    int at = row - E.row;
+    if (at + 1 >= E.numrows || at + 1 >= E.hlrows) return;
+    row = &E.row[at + 1];
+  }
+}
+
+/* Re-highlights a row after render[from, to) was inserted (or, with
+ * from == to, text at from was deleted). The pass restarts at the nearest
+ * plain separator before the edit, far enough back that no comment
+ * delimiter can straddle it, and stops as soon as it resynchronises with
+ * the old highlighting, so its cost depends on the token around the edit
+ * rather than on the length of the row. */
+void editorUpdateSyntaxWindow(erow *row, int from, int to) {
+  if (E.syntax == NULL) return;
+
+  int maxdelim = 1;
+  const char *delims[] = { E.syntax->singleline_comment_start,
+                           E.syntax->multiline_comment_start,
+                           E.syntax->multiline_comment_end };
+  for (const char *d : delims) {
+    int len = d ? strlen(d) : 0;
+    if (len > maxdelim) maxdelim = len;
+  }
+
+  int start = from - (maxdelim - 1);
+  if (start < 0) start = 0;
+  while (start > 0 && !(editorRowHlAt(row, start - 1) == HL_NORMAL &&
+                        is_separator(editorRowRenderAt(row, start - 1))))
+    start--;
+
+  int at = row - E.row;
+  int changed;
+  {
+    PROBE(PROBE_SYNTAX);
+    int in_comment = (start == 0 && at > 0 && E.row[at - 1].hl_open_comment);
+    hlOut out = { NULL, 0, 1 };
+    int open_comment;
+    int end = highlightScan(row, start, in_comment, to, &out, &open_comment);
+    for (int i = start; i < end; i++)
+      editorRowSetHl(row, i, out.hl[i - start]);
+    free(out.hl);
+
+    changed = (row->hl_open_comment != open_comment);
+    row->hl_open_comment = open_comment;
+  }
+  if (changed && at + 1 < E.hlrows)
+    editorUpdateSyntax(&E.row[at + 1]);
+}
+
+int editorSyntaxToColor(int hl) {
+  switch (hl) {
+    case HL_COMMENT:
+    case HL_MLCOMMENT: return 36;
+    case HL_KEYWORD1: return 33;
+    case HL_KEYWORD2: return 32;
+    case HL_STRING: return 35;
+    case HL_NUMBER: return 31;
+    case HL_MATCH: return 34;
+    default: return 37;
+  }
+}
+
+void editorSelectSyntaxHighlight() {
+  E.syntax = NULL;
+  if (E.filename == NULL) return;
+
+  const char *ext = strrchr(E.filename, '.');
+
+  for (unsigned int j = 0; j < HLDB_ENTRIES; j++) {
+    struct editorSyntax *s = &HLDB[j];
+    unsigned int i = 0;
+    while (s->filematch[i]) {
+      int is_ext = (s->filematch[i][0] == '.');
+      if ((is_ext && ext && !strcmp(ext, s->filematch[i])) ||
+          (!is_ext && strstr(E.filename, s->filematch[i]))) {
+        E.syntax = s;
+
+        int filerow;
+        for (filerow = 0; filerow < E.hlrows; filerow++) {
+          editorUpdateSyntax(&E.row[filerow]);
+        }
+
+        return;
+      }
+      i++;
+    }
+  }
+}
@@ -1,2 +1,36 @@
+#pragma once
 
+struct erow;
 
+enum editorHighlight {
+  HL_NORMAL = 0,
+  HL_COMMENT,
+  HL_MLCOMMENT,
+  HL_KEYWORD1,
+  HL_KEYWORD2,
+  HL_STRING,
+  HL_NUMBER,
+  HL_MATCH
+};
+
+#define HL_HIGHLIGHT_NUMBERS (1<<0)
+#define HL_HIGHLIGHT_STRINGS (1<<1)
+
+struct editorSyntax {
+  const char *filetype;
+  const char **filematch;
+  const char **keywords;
+  const char *singleline_comment_start;
+  const char *multiline_comment_start;
+  const char *multiline_comment_end;
+  int flags;
+};
+
+/*** syntax highlighting ***/
+
+int is_separator(int c);
+int editorHighlightRow(erow *row);
+void editorUpdateSyntax(erow *row);
+void editorUpdateSyntaxWindow(erow *row, int from, int to);
+int editorSyntaxToColor(int hl);
+void editorSelectSyntaxHighlight();
@@ -0,0 +1,182 @@
+#include "Undo.h"
+
+#include <algorithm>
+
+#include "Editor.h"
+#include "Probe.h"
+#include "Row.h"
+
+/*** undo ***/
+
+void editorUndoBegin() {
+  if (E.undo.depth++ > 0) return;
+  E.undo.cur.edits.clear();
+  E.undo.cur.cx = E.cx;
+  E.undo.cur.cy = E.cy;
+  E.undo.cur.cursors = E.cursors.extra;
+}
+
+void editorUndoEnd() {
+  if (--E.undo.depth > 0 || E.undo.cur.edits.empty()) return;
+
+  undoRecord &cur = E.undo.cur;
+  cur.bytes = sizeof(cur) + cur.cursors.size() * sizeof(cursorPos);
+  for (const undoEdit &e : cur.edits) cur.bytes += sizeof(e) + e.text.size();
+  E.undo.bytes += cur.bytes;
+  PROBE_MEM(PROBE_MEM_UNDO, cur.bytes);
+  E.undo.records.push_back(std::move(cur));
+  cur = undoRecord();
+
+  while (E.undo.bytes > UNDO_BYTES && E.undo.records.size() > 1) {
+    E.undo.bytes -= E.undo.records.front().bytes;
+    PROBE_MEM(PROBE_MEM_UNDO, -(int64_t)E.undo.records.front().bytes);
+    E.undo.records.pop_front();
+  }
+}
+
+void editorUndoClear() {
+  E.undo.records.clear();
+  E.undo.cur.edits.clear();
+  PROBE_MEM(PROBE_MEM_UNDO, -(int64_t)E.undo.bytes);
+  E.undo.bytes = 0;
+}
+
+static int undoShiftRow(int row, int at, int count, int n) {
+  if (row >= at + count) return row + n - count;
+  return row >= at ? at : row;
+}
+
+/* Carries the log over rows [at, at + count) being replaced by n rows
+ * outside any command. The replaced range is followed back through each
+ * record, newest first, and the rows past it are renumbered. The first
+ * record that touched a replaced row could only be undone by writing
+ * over the new lines, so it is dropped, and every record before it. */
+void editorUndoReplaceRows(int at, int count, int n) {
+  if (E.undo.replaying) return;
+  std::deque<undoRecord> &records = E.undo.records;
+  size_t k = records.size();
+  for (; k > 0; k--) {
+    undoRecord &rec = records[k - 1];
+    int clash = 0;
+    for (size_t i = rec.edits.size(); i-- > 0 && !clash;) {
+      undoEdit &e = rec.edits[i];
+      if (e.row >= at + count) {
+        e.row += n - count;
+      } else if (e.row < at || (e.kind == UNDO_DEL_ROW && e.row == at)) {
+        /* Before this edit the range sat a row lower or higher. */
+        if (e.kind == UNDO_ADD_ROW) at--;
+        if (e.kind == UNDO_DEL_ROW) at++;
+      } else {
+        clash = 1;
+      }
+    }
+    if (clash) break;
+    rec.cy = undoShiftRow(rec.cy, at, count, n);
+    for (cursorPos &c : rec.cursors) c.cy = undoShiftRow(c.cy, at, count, n);
+  }
+
+  for (size_t i = 0; i < k; i++) {
+    E.undo.bytes -= records[i].bytes;
+    PROBE_MEM(PROBE_MEM_UNDO, -(int64_t)records[i].bytes);
+  }
+  records.erase(records.begin(), records.begin() + k);
+}
+
+/* Appends an edit to the command being recorded, or empties the log if
+ * none is; returns NULL unless the edit is to be filled in. */
+static undoEdit *undoPush(int kind, int row) {
+  if (E.undo.replaying) return NULL;
+  if (E.undo.depth == 0) {
+    editorUndoClear();
+    return NULL;
+  }
+  E.undo.cur.edits.push_back(undoEdit());
+  undoEdit *e = &E.undo.cur.edits.back();
+  e->kind = kind;
+  e->row = row;
+  e->at = 0;
+  e->inserted = 0;
+  return e;
+}
+
+void editorUndoText(int row, int at, int inserted, const char *text, size_t len) {
+  undoEdit *e = undoPush(UNDO_TEXT, row);
+  if (e == NULL) return;
+  e->at = at;
+  e->inserted = inserted;
+  e->text.assign(text, len);
+}
+
+void editorUndoAddRow(int row) {
+  undoPush(UNDO_ADD_ROW, row);
+}
+
+/* Called before row is deleted, while its text can still be read. */
+void editorUndoDelRow(int row) {
+  undoEdit *e = undoPush(UNDO_DEL_ROW, row);
+  if (e == NULL) return;
+  erow *r = &E.row[row];
+  e->text.assign(editorRowChars(r), r->size);
+}
+
+/* Puts back the text edits from edits[k - 1] down while they go up the
+ * buffer, each to a different row, as one editorRowsSetText batch; a
+ * multi-cursor command is undone in one pass this way. Returns the index
+ * of the first edit not handled. */
+static size_t undoTextRun(const std::vector<undoEdit> &edits, size_t k) {
+  std::vector<int> rows;
+  std::vector<std::string> texts;
+  while (k > 0 && edits[k - 1].kind == UNDO_TEXT &&
+         (rows.empty() || edits[k - 1].row < rows.back())) {
+    const undoEdit &e = edits[--k];
+    erow *row = &E.row[e.row];
+    const char *chars = editorRowChars(row);
+    std::string text(chars, e.at);
+    text += e.text;
+    text.append(chars + e.at + e.inserted, row->size - e.at - e.inserted);
+    rows.push_back(e.row);
+    texts.push_back(std::move(text));
+  }
+
+  int n = rows.size();
+  std::reverse(rows.begin(), rows.end());
+  std::reverse(texts.begin(), texts.end());
+  std::vector<const char *> ptrs(n);
+  std::vector<size_t> lens(n);
+  for (int i = 0; i < n; i++) {
+    ptrs[i] = texts[i].data();
+    lens[i] = texts[i].size();
+  }
+  editorRowsSetText(rows.data(), ptrs.data(), lens.data(), n);
+  return k;
+}
+
+void editorUndo() {
+  if (E.undo.records.empty()) {
+    editorSetStatusMessage("Nothing to undo");
+    return;
+  }
+  undoRecord rec = std::move(E.undo.records.back());
+  E.undo.records.pop_back();
+  E.undo.bytes -= rec.bytes;
+  PROBE_MEM(PROBE_MEM_UNDO, -(int64_t)rec.bytes);
+
+  E.undo.replaying = 1;
+  size_t k = rec.edits.size();
+  while (k > 0) {
+    const undoEdit &e = rec.edits[k - 1];
+    if (e.kind == UNDO_TEXT) {
+      k = undoTextRun(rec.edits, k);
+      continue;
+    }
+    if (e.kind == UNDO_ADD_ROW) editorDelRow(e.row);
+    else editorInsertRow(e.row, e.text.data(), e.text.size());
+    k--;
+  }
+  E.undo.replaying = 0;
+
+  E.cx = rec.cx;
+  E.cy = rec.cy;
+  E.cursors.extra = std::move(rec.cursors);
+  editorSetStatusMessage("Undone (%d more)", (int)E.undo.records.size());
+}
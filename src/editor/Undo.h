@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Cursors.h"
+
+/*** undo ***/
+
+/* Records are dropped, oldest first, once the log holds more than this
+ * many bytes of saved text and bookkeeping. */
+#define UNDO_BYTES (128 << 20)
+
+enum undoKind {
+  UNDO_TEXT,
+  UNDO_ADD_ROW,
+  UNDO_DEL_ROW
+};
+
+/* One change to the rows. UNDO_TEXT: chars[at, at + inserted) of row
+ * replaced text. UNDO_ADD_ROW: row was inserted. UNDO_DEL_ROW: row, which
+ * held text, was deleted. */
+struct undoEdit {
+  int kind;
+  int row;
+  int at;
+  int inserted;
+  std::string text;
+};
+
+/* The edits made by one command, and where the cursors were before it. */
+struct undoRecord {
+  std::vector<undoEdit> edits;
+  int cx, cy;
+  std::vector<cursorPos> cursors;
+  size_t bytes;
+};
+
+/* Ctrl-Z undoes the last command that edited the text.
+ *
+ * Commands bracket their edits with editorUndoBegin and editorUndoEnd,
+ * and the row operations report every change through the hooks below, so
+ * a command is recorded however it is made up. Rows replaced or
+ * appended by a reload or a followed file growing are not undoable, but
+ * the log is carried over them (editorUndoReplaceRows), losing only the
+ * commands that edited the replaced rows and those before. Any other
+ * change reported outside a command empties the log. */
+struct undoLog {
+  std::deque<undoRecord> records;
+  undoRecord cur;
+  size_t bytes;
+  int depth;
+  int replaying;
+};
+
+void editorUndoBegin();
+void editorUndoEnd();
+void editorUndoClear();
+void editorUndoReplaceRows(int at, int count, int n);
+void editorUndoText(int row, int at, int inserted, const char *text, size_t len);
+void editorUndoAddRow(int row);
+void editorUndoDelRow(int row);
+void editorUndo();
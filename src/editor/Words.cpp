@@ -0,0 +1,182 @@
+#include "Words.h"
+
+#include <cctype>
+#include <cstring>
+
+#include "Editor.h"
+#include "Syntax.h"
+
+static unsigned char wordChar[256];
+
+static void wordsInitChars() {
+  for (int c = 0; c < 256; c++) {
+    wordChar[c] = !is_separator(c) && (isalnum(c) || c == '_' || c >= 0x80);
+  }
+}
+
+/* Calls fn(word, len) for each word of row, reading its text on both
+ * sides of the gap. */
+template <typename F>
+static void wordsScan(const erow *row, F fn) {
+  const char *buf = editorRowBuf(row);
+  char word[WORDS_MAX];
+  int len = 0;
+  int skip = 0;
+  auto feed = [&](unsigned char c) {
+    if (wordChar[c]) {
+      if (len == 0 && isdigit(c)) skip = 1;
+      if (len < WORDS_MAX) word[len] = c;
+      else skip = 1;
+      len++;
+      return;
+    }
+    if (len >= WORDS_MIN && !skip) fn(word, len);
+    len = 0;
+    skip = 0;
+  };
+  for (int i = 0; i < row->gap; i++) feed(buf[i]);
+  for (int i = row->gap + row->gaplen; i < row->size + row->gaplen; i++)
+    feed(buf[i]);
+  feed(' ');
+}
+
+void editorWordsInsertRow(int at) {
+  if (!E.words.built) return;
+  wordsScan(&E.row[at], [](const char *w, int len) {
+    trieAdd(&E.words.index, w, len, 1);
+  });
+}
+
+void editorWordsDelRow(int at) {
+  if (!E.words.built) return;
+  wordsScan(&E.row[at], [](const char *w, int len) {
+    trieAdd(&E.words.index, w, len, -1);
+  });
+}
+
+/* Adds delta for each word of row at that touches chars [from, to]: the
+ * run of word characters around them, which is all a one-character edit
+ * at from can change, however long the row. */
+static void wordsSpan(int at, int from, int to, int delta) {
+  if (!E.words.built) return;
+  const erow *row = &E.row[at];
+  int lo = from;
+  while (lo > 0 && wordChar[(unsigned char)editorRowCharAt(row, lo - 1)]) lo--;
+  int hi = to;
+  while (hi < row->size && wordChar[(unsigned char)editorRowCharAt(row, hi)]) hi++;
+
+  char word[WORDS_MAX];
+  int len = 0;
+  int skip = 0;
+  for (int i = lo; i <= hi; i++) {
+    unsigned char c = i < hi ? editorRowCharAt(row, i) : ' ';
+    if (wordChar[c]) {
+      if (len == 0 && isdigit(c)) skip = 1;
+      if (len < WORDS_MAX) word[len] = c;
+      else skip = 1;
+      len++;
+      continue;
+    }
+    if (len >= WORDS_MIN && !skip) trieAdd(&E.words.index, word, len, delta);
+    len = 0;
+    skip = 0;
+  }
+}
+
+void editorWordsDelSpan(int at, int from, int to) {
+  wordsSpan(at, from, to, -1);
+}
+
+void editorWordsInsertSpan(int at, int from, int to) {
+  wordsSpan(at, from, to, 1);
+}
+
+/* Indexes the whole buffer; after this the row hooks keep it current. */
+void editorWordsBuild() {
+  wordsInitChars();
+  trieInit(&E.words.index);
+  E.words.built = 1;
+  for (int i = 0; i < E.numrows; i++) editorWordsInsertRow(i);
+}
+
+void editorWordsFree() {
+  E.words.built = 0;
+  E.words.active = 0;
+  E.words.index = trie();
+}
+
+/* The text of choice i, or of the word as typed for -1. */
+static std::string wordsChoice(int i) {
+  if (i >= 0) return E.words.choices[i];
+  erow *row = &E.row[E.words.row];
+  std::string s;
+  for (int j = 0; j < E.words.typed; j++)
+    s += editorRowCharAt(row, E.words.start + j);
+  return s;
+}
+
+static void wordsShowChoices() {
+  std::string msg;
+  for (int i = 0; i < (int)E.words.choices.size(); i++) {
+    if (i) msg += ' ';
+    if (i == E.words.choice) msg += '[';
+    msg += E.words.choices[i];
+    if (i == E.words.choice) msg += ']';
+  }
+  editorSetStatusMessage("%s", msg.c_str());
+}
+
+void editorComplete() {
+  if (!E.words.built) editorWordsBuild();
+  if (E.cy >= E.numrows) return;
+  erow *row = &E.row[E.cy];
+
+  std::string current;
+  int end = E.words.start;
+  if (E.words.active && E.words.row == E.cy) {
+    current = wordsChoice(E.words.choice);
+    end += current.size();
+  }
+  if (!E.words.active || E.words.row != E.cy || E.cx != end) {
+    int start = E.cx;
+    while (start > 0 && wordChar[(unsigned char)editorRowCharAt(row, start - 1)])
+      start--;
+    if (start == E.cx) {
+      editorSetStatusMessage("No word to complete");
+      return;
+    }
+    std::string prefix;
+    for (int j = start; j < E.cx; j++) prefix += editorRowCharAt(row, j);
+
+    std::vector<std::string> found;
+    trieTop(&E.words.index, prefix.data(), prefix.size(), WORDS_CHOICES + 1,
+            &found);
+    E.words.choices.clear();
+    for (std::string &w : found) {
+      if (w != prefix && E.words.choices.size() < WORDS_CHOICES)
+        E.words.choices.push_back(std::move(w));
+    }
+    if (E.words.choices.empty()) {
+      editorSetStatusMessage("No completions for %s", prefix.c_str());
+      return;
+    }
+    E.words.active = 1;
+    E.words.row = E.cy;
+    E.words.start = start;
+    E.words.typed = E.cx - start;
+    E.words.choice = -1;
+    current = prefix;
+  }
+
+  /* Swap the tail of the current text for that of the next choice. */
+  E.words.choice++;
+  if (E.words.choice == (int)E.words.choices.size()) E.words.choice = -1;
+  std::string next = wordsChoice(E.words.choice);
+  int keep = E.words.start + E.words.typed;
+  editorUndoBegin();
+  while (E.cx > keep) editorRowDelChar(row, --E.cx);
+  for (size_t j = E.words.typed; j < next.size(); j++)
+    editorRowInsertChar(row, E.cx++, next[j]);
+  editorUndoEnd();
+  wordsShowChoices();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Trie.h"
+
+/*** word completion ***/
+
+#define WORDS_MIN 3
+#define WORDS_MAX 64
+#define WORDS_CHOICES 8
+
+/* Ctrl-N completes the word before the cursor from the words of the
+ * buffer. A word is a run of letters, digits, '_' and non-ASCII bytes,
+ * none of which is_separator (the highlighter's word boundary) splits
+ * on, of WORDS_MIN to WORDS_MAX bytes and not starting with a digit.
+ *
+ * index counts the occurrences of every word. It is built on the first
+ * Ctrl-N and from then on kept current by the row operations, which take
+ * a row's words out before changing it and put them back after (only
+ * those around the edit, for a single character); while built is clear
+ * the hooks are no-ops.
+ *
+ * Ctrl-N inserts the most common completion and lists the others in the
+ * message bar; pressing it again replaces it with the next one, and after
+ * the last brings back the word as typed. While active, the word starts
+ * at start on row, its first typed bytes were typed, and choice indexes
+ * choices (-1 for the word as typed). */
+struct wordIndex {
+  int built;
+  struct trie index;
+  int active;
+  int row;
+  int start;
+  int typed;
+  int choice;
+  std::vector<std::string> choices;
+};
+
+void editorWordsBuild();
+void editorWordsFree();
+void editorWordsInsertRow(int at);
+void editorWordsDelRow(int at);
+void editorWordsInsertSpan(int at, int from, int to);
+void editorWordsDelSpan(int at, int from, int to);
+void editorComplete();
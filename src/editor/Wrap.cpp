@@ -0,0 +1,204 @@
+#include "Wrap.h"
+
+#include <vector>
+
+#include "Editor.h"
+#include "Utf8.h"
+
+/*** row layout ***/
+
+/* Width in columns of the character at render[at]; its length in bytes
+ * is stored in *len. */
+static int renderCharWidth(const erow *row, int at, int *len) {
+  char seq[4];
+  int cp;
+  *len = editorRowRenderDecode(row, at, seq, &cp);
+  return utf8CharWidth(cp);
+}
+
+int editorWrapRowLines(erow *row, int width) {
+  if (row->ascii) return row->rsize / width + 1;
+  int lines = 1;
+  int col = 0;
+  for (int j = 0; j < row->rsize;) {
+    int len;
+    int w = renderCharWidth(row, j, &len);
+    if (col > 0 && col + w > width) {
+      lines++;
+      col = 0;
+    }
+    col += w;
+    j += len;
+  }
+  if (col + 1 > width) lines++;
+  return lines;
+}
+
+/* Offset in render where visual line sub of the row starts. */
+int editorWrapSegment(erow *row, int sub, int width) {
+  if (row->ascii) {
+    long long at = (long long)sub * width;
+    return at < row->rsize ? at : row->rsize;
+  }
+  int s = 0;
+  int col = 0;
+  for (int j = 0; j < row->rsize;) {
+    int len;
+    int w = renderCharWidth(row, j, &len);
+    if (col > 0 && col + w > width) {
+      s++;
+      col = 0;
+    }
+    if (s == sub) return j;
+    col += w;
+    j += len;
+  }
+  return row->rsize;
+}
+
+/* Finds the visual line and the column on it where display column rx of
+ * the row is shown. */
+void editorWrapLocate(erow *row, int rx, int width, int *sub, int *col) {
+  if (row->ascii) {
+    *sub = rx / width;
+    *col = rx % width;
+    return;
+  }
+  int s = 0;
+  int c = 0;
+  int x = 0;
+  int j = 0;
+  while (j < row->rsize && x < rx) {
+    int len;
+    int w = renderCharWidth(row, j, &len);
+    if (c > 0 && c + w > width) {
+      s++;
+      c = 0;
+    }
+    c += w;
+    x += w;
+    j += len;
+  }
+  int w = 1;
+  if (j < row->rsize) {
+    int len;
+    w = renderCharWidth(row, j, &len);
+  }
+  if (c > 0 && c + w > width) {
+    s++;
+    c = 0;
+  }
+  *sub = s;
+  *col = c;
+}
+
+/* The inverse of editorWrapLocate: the display column of the character
+ * shown at column col of visual line sub, or of the last character on
+ * that line when col is past its end. */
+int editorWrapToRx(erow *row, int sub, int col, int width) {
+  if (row->ascii) {
+    long long rx = (long long)sub * width + col;
+    return rx < row->rsize ? rx : row->rsize;
+  }
+  int s = 0;
+  int c = 0;
+  int x = 0;
+  int last = 0;
+  for (int j = 0; j < row->rsize;) {
+    int len;
+    int w = renderCharWidth(row, j, &len);
+    if (c > 0 && c + w > width) {
+      s++;
+      c = 0;
+    }
+    if (s > sub) return last;
+    if (s == sub && c + w > col) return x;
+    last = x;
+    c += w;
+    x += w;
+    j += len;
+  }
+  if (c + 1 > width) s++;
+  return s > sub ? last : x;
+}
+
+/*** document layout ***/
+
+/* Estimate for a row that has not been scanned. Prepared ASCII rows are
+ * exact; rows past E.hlrows have no render yet, so go by their size. */
+static int wrapEstimate(int at, int width) {
+  erow *row = &E.row[at];
+  if (at >= E.hlrows) {
+    row->wrap_exact = 0;
+    return row->size / width + 1;
+  }
+  row->wrap_exact = row->ascii;
+  return row->rsize / width + 1;
+}
+
+/* Estimates every row without scanning its text, so a resize costs one
+ * pass over the row array and rows are only measured when drawn. A
+ * screen no wider than the diff gutter still wraps at one column. */
+void editorWrapBuild(int width) {
+  if (width < 1) width = 1;
+  std::vector<int> lines(E.numrows);
+  for (int i = 0; i < E.numrows; i++) lines[i] = wrapEstimate(i, width);
+  fwInit(&E.layout.lines, lines.data(), E.numrows);
+  E.layout.width = width;
+}
+
+void editorWrapFree() {
+  E.layout.lines = fenwick();
+  E.layout.width = 0;
+}
+
+void editorWrapInsertRow(int at) {
+  if (E.layout.width == 0) return;
+  if (at >= E.hlrows) {
+    fwInsert(&E.layout.lines, at, wrapEstimate(at, E.layout.width));
+    return;
+  }
+  erow *row = &E.row[at];
+  row->wrap_exact = 1;
+  fwInsert(&E.layout.lines, at, editorWrapRowLines(row, E.layout.width));
+}
+
+void editorWrapDelRow(int at) {
+  if (E.layout.width == 0) return;
+  fwErase(&E.layout.lines, at);
+}
+
+void editorWrapUpdateRow(int at) {
+  if (E.layout.width == 0) return;
+  erow *row = &E.row[at];
+  row->wrap_exact = 1;
+  fwSet(&E.layout.lines, at, editorWrapRowLines(row, E.layout.width));
+}
+
+/* Makes the count of row at exact and returns it. */
+int editorWrapRefine(int at) {
+  editorPrepareRows(at + 1);
+  erow *row = &E.row[at];
+  if (!row->wrap_exact) editorWrapUpdateRow(at);
+  return fwGet(&E.layout.lines, at);
+}
+
+long long editorWrapLineOf(int at) {
+  return fwPrefix(&E.layout.lines, at);
+}
+
+/* Returns the row showing visual line line and stores the line's index
+ * within the row in *sub. Lines past the end map to E.numrows. */
+int editorWrapRowOf(long long line, int *sub) {
+  int at = fwFind(&E.layout.lines, line);
+  if (at >= E.numrows) {
+    *sub = 0;
+    return E.numrows;
+  }
+  *sub = line - fwPrefix(&E.layout.lines, at);
+  return at;
+}
+
+long long editorWrapTotal() {
+  return E.layout.lines.total;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Fenwick.h"
+#include "Row.h"
+
+/*** soft wrap ***/
+
+/* While soft wrap is on, every row is split into visual lines of at most
+ * width columns; a character that does not fit starts the next line, and
+ * a row whose last line is full gets an extra one for the cursor. lines
+ * holds the number of visual lines of each row, so finding the first
+ * visual line of a row, or the row showing a visual line, is a prefix-sum
+ * query. Counts of ASCII rows are exact; the others are estimated from
+ * rsize until they come into view and are refined (erow::wrap_exact).
+ * width is 0 while no layout is built, and the hooks are then no-ops. */
+struct wrapLayout {
+  struct fenwick lines;
+  int width;
+};
+
+int editorWrapRowLines(erow *row, int width);
+int editorWrapSegment(erow *row, int sub, int width);
+void editorWrapLocate(erow *row, int rx, int width, int *sub, int *col);
+int editorWrapToRx(erow *row, int sub, int col, int width);
+
+void editorWrapBuild(int width);
+void editorWrapFree();
+void editorWrapInsertRow(int at);
+void editorWrapDelRow(int at);
+void editorWrapUpdateRow(int at);
+int editorWrapRefine(int at);
+long long editorWrapLineOf(int at);
+int editorWrapRowOf(long long line, int *sub);
+long long editorWrapTotal();
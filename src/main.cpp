@@ -1,2 +1,36 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
+#include "Editor.h"
+#include "FileIO.h"
+#include "Terminal.h"
 
+int main(int argc, char *argv[]) {
+  enableRawMode();
+  initEditor();
+  /* Record the session's keys for byte-writer-replay. */
+  const char *trace = getenv("BYTE_WRITER_TRACE");
+  FILE *tracefp = trace ? fopen(trace, "w") : NULL;
+  if (tracefp) termRecord(tracefp);
+  else if (trace) editorSetStatusMessage("Can't record trace: %s", strerror(errno));
+  editorPluginsLoadEnv();
+  if (argc >= 3 && strcmp(argv[1], "--hex") == 0) {
+    if (editorHexOpen(argv[2]) == 0) E.hex.standalone = 1;
+  } else if (argc >= 2) {
+    editorOpen(argv[1]);
+  }
+
+  if (E.statusmsg[0] == '\0')
+    editorSetStatusMessage(
+      "HELP: Ctrl-S save | Ctrl-Q quit | Ctrl-F find | Ctrl-G goto | "
+      "Ctrl-W wrap");
+
+  while (1) {
+    editorRefreshScreen();
+    editorProcessKeypress();
+  }
+
+  return 0;
+}
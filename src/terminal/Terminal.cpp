@@ -1,2 +1,374 @@
+#include "Terminal.h"
 
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
 
+#include "Editor.h"
+#include "Helpers.h"
+#include "Probe.h"
+
+/*** tty backend ***/
+
+static void ttyDisableRaw() {
+  if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &E.orig_termios) == -1)
+    die("tcsetattr");
+}
+
+static void ttyEnableRaw() {
+  if (tcgetattr(STDIN_FILENO, &E.orig_termios) == -1) die("tcgetattr");
+  atexit(disableRawMode);
+
+  struct termios raw = E.orig_termios;
+  raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+  raw.c_oflag &= ~(OPOST);
+  raw.c_cflag |= (CS8);
+  raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+  raw.c_cc[VMIN] = 0;
+  raw.c_cc[VTIME] = 1;
+
+  if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == -1) die("tcsetattr");
+}
+
+static int ttyWait(int watchfd, int wakefd, int timeout) {
+  if (watchfd == -1 && wakefd == -1 && timeout == -1) return TERM_INPUT;
+  struct pollfd fds[3] = { { STDIN_FILENO, POLLIN, 0 },
+                           { watchfd, POLLIN, 0 },
+                           { wakefd, POLLIN, 0 } };
+  int ready = poll(fds, 3, timeout);
+  if (ready == -1 && errno != EINTR) die("poll");
+  if (ready == 0) return TERM_IDLE;
+  if (!(fds[0].revents & POLLIN)) {
+    if (fds[1].revents & POLLIN) return TERM_WATCH;
+    if (fds[2].revents & POLLIN) return TERM_WAKE;
+  }
+  return TERM_INPUT;
+}
+
+/* Raw mode has VMIN 0 and VTIME 1, so this gives up after 100ms. */
+static int ttyRead(char *c) {
+  int nread = read(STDIN_FILENO, c, 1);
+  if (nread == -1) return errno == EAGAIN ? 0 : -1;
+  return nread;
+}
+
+static int ttyWrite(const char *s, int len) {
+  return write(STDOUT_FILENO, s, len);
+}
+
+static int ttySize(int *rows, int *cols) {
+  struct winsize ws;
+
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1 || ws.ws_col == 0) {
+    if (ttyWrite("\x1b[999C\x1b[999B", 12) != 12) return -1;
+    return getCursorPosition(rows, cols);
+  } else {
+    *cols = ws.ws_col;
+    *rows = ws.ws_row;
+    return 0;
+  }
+}
+
+static const struct termBackend ttyBackend = {
+  ttyEnableRaw, ttyDisableRaw, ttyWait, ttyRead, ttyWrite, ttySize
+};
+
+/*** memory backend ***/
+
+/* Keys are handed out a byte at a time with a timeout (a read of 0)
+ * after each one, as if typed with a pause between them. Once the queue
+ * runs dry every read is a lone Esc, which backs out of any prompt still
+ * waiting for input. */
+static struct {
+  std::deque<std::string> keys;
+  size_t off;
+  int gap;
+  int rows, cols;
+  std::string out;
+  long long written;
+  int writes;
+} mem;
+
+static void memEnableRaw() {}
+
+static void memDisableRaw() {}
+
+static int memWait(int, int, int) {
+  return TERM_INPUT;
+}
+
+static int memRead(char *c) {
+  if (mem.gap) {
+    mem.gap = 0;
+    return 0;
+  }
+  mem.gap = 1;
+  if (mem.keys.empty()) {
+    *c = '\x1b';
+    return 1;
+  }
+  const std::string &key = mem.keys.front();
+  *c = key[mem.off++];
+  if (mem.off < key.size()) {
+    mem.gap = 0;
+  } else {
+    mem.keys.pop_front();
+    mem.off = 0;
+  }
+  return 1;
+}
+
+static int memWrite(const char *s, int len) {
+  mem.out.append(s, len);
+  mem.written += len;
+  mem.writes++;
+  return len;
+}
+
+static int memSize(int *rows, int *cols) {
+  *rows = mem.rows;
+  *cols = mem.cols;
+  return 0;
+}
+
+static const struct termBackend memBackend = {
+  memEnableRaw, memDisableRaw, memWait, memRead, memWrite, memSize
+};
+
+static const struct termBackend *term = &ttyBackend;
+
+/* Switches to the memory backend with an empty key queue and a screen of
+ * rows by cols. */
+void termUseMemory(int rows, int cols) {
+  term = &memBackend;
+  mem.keys.clear();
+  mem.off = 0;
+  mem.gap = 0;
+  mem.rows = rows;
+  mem.cols = cols;
+  mem.out.clear();
+  mem.written = 0;
+  mem.writes = 0;
+}
+
+/* Queues the bytes of one key (an escape sequence counts as one). */
+void termMemoryPush(const std::string &key) {
+  if (!key.empty()) mem.keys.push_back(key);
+}
+
+size_t termMemoryPending() {
+  return mem.keys.size();
+}
+
+/* The next key to be read, whole; only while termMemoryPending(). */
+const std::string &termMemoryPeek() {
+  return mem.keys.front();
+}
+
+long long termMemoryWritten() {
+  return mem.written;
+}
+
+int termMemoryWrites() {
+  return mem.writes;
+}
+
+/* Returns everything written since the last call. */
+std::string termMemoryTakeOutput() {
+  std::string out;
+  out.swap(mem.out);
+  return out;
+}
+
+int termWrite(const char *s, int len) {
+  return term->write(s, len);
+}
+
+/*** traces ***/
+
+static FILE *record = NULL;
+static std::string keybytes;
+
+/* Logs the bytes of every key read from now on to fp, one key per line
+ * (see termEscapeKey); NULL stops. */
+void termRecord(FILE *fp) {
+  record = fp;
+}
+
+/* Spells out a key on one line: printable bytes as themselves, the rest
+ * (and space, '#' and backslash) as \xNN. */
+std::string termEscapeKey(const std::string &key) {
+  static const char hex[] = "0123456789abcdef";
+  std::string line;
+  for (unsigned char c : key) {
+    if (c > ' ' && c < 127 && c != '#' && c != '\\') {
+      line += c;
+    } else {
+      line += "\\x";
+      line += hex[c >> 4];
+      line += hex[c & 15];
+    }
+  }
+  return line;
+}
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/* Reverses termEscapeKey, also taking \e, \r, \n, \t and \\ for traces
+ * written by hand. Stops at the end of the line; returns -1 if it is
+ * malformed. */
+int termUnescapeKey(const char *line, std::string *key) {
+  key->clear();
+  for (const char *p = line; *p && *p != '\n'; p++) {
+    if (*p != '\\') {
+      *key += *p;
+      continue;
+    }
+    switch (*++p) {
+      case 'e': *key += '\x1b'; break;
+      case 'r': *key += '\r'; break;
+      case 'n': *key += '\n'; break;
+      case 't': *key += '\t'; break;
+      case '\\': *key += '\\'; break;
+      case 'x': {
+        int hi = hexDigit(p[1]), lo = hi == -1 ? -1 : hexDigit(p[2]);
+        if (lo == -1) return -1;
+        *key += (char)(hi << 4 | lo);
+        p += 2;
+        break;
+      }
+      default: return -1;
+    }
+  }
+  return 0;
+}
+
+/*** terminal ***/
+
+void disableRawMode() {
+  term->disableRaw();
+}
+
+void enableRawMode() {
+  term->enableRaw();
+}
+
+static int readByte(char *c) {
+  int nread = term->read(c);
+  if (nread == 1 && record) keybytes += *c;
+  return nread;
+}
+
+static int readKey() {
+  int nread;
+  char c;
+  while (1) {
+    switch (term->wait(E.watch.fd, E.wakefd, editorIdleTimeout())) {
+      case TERM_WATCH:
+        return WATCH_EVENT;
+      case TERM_IDLE:
+        return IDLE_EVENT;
+      case TERM_WAKE: {
+        uint64_t count;
+        if (read(E.wakefd, &count, sizeof(count)) == -1 && errno != EAGAIN)
+          die("read");
+        return WAKE_EVENT;
+      }
+    }
+    nread = readByte(&c);
+    if (nread == 1) break;
+    if (nread == -1) die("read");
+  }
+  /* From the first byte: decoding, not waiting for the user. */
+  PROBE(PROBE_INPUT);
+
+  if (c == '\x1b') {
+    char seq[3];
+
+    if (readByte(&seq[0]) != 1) return '\x1b';
+    if (readByte(&seq[1]) != 1) return '\x1b';
+
+    if (seq[0] == '[') {
+      if (seq[1] >= '0' && seq[1] <= '9') {
+        if (readByte(&seq[2]) != 1) return '\x1b';
+        if (seq[2] == '~') {
+          switch (seq[1]) {
+            case '1': return HOME_KEY;
+            case '3': return DEL_KEY;
+            case '4': return END_KEY;
+            case '5': return PAGE_UP;
+            case '6': return PAGE_DOWN;
+            case '7': return HOME_KEY;
+            case '8': return END_KEY;
+          }
+        }
+      } else {
+        switch (seq[1]) {
+          case 'A': return ARROW_UP;
+          case 'B': return ARROW_DOWN;
+          case 'C': return ARROW_RIGHT;
+          case 'D': return ARROW_LEFT;
+          case 'H': return HOME_KEY;
+          case 'F': return END_KEY;
+        }
+      }
+    } else if (seq[0] == 'O') {
+      switch (seq[1]) {
+        case 'H': return HOME_KEY;
+        case 'F': return END_KEY;
+      }
+    }
+
+    return '\x1b';
+  } else {
+    return (unsigned char)c;
+  }
+}
+
+/* Returns the next key, or WATCH_EVENT when E.watch.fd becomes readable
+ * while no key is waiting, or WAKE_EVENT when a background thread has
+ * signalled E.wakefd, or IDLE_EVENT when no key has come for
+ * editorIdleTimeout() ms. */
+int editorReadKey() {
+  int key = readKey();
+  if (record && !keybytes.empty()) {
+    fprintf(record, "%s\n", termEscapeKey(keybytes).c_str());
+    fflush(record);
+  }
+  keybytes.clear();
+  return key;
+}
+
+int getCursorPosition(int *rows, int *cols) {
+  char buf[32];
+  unsigned int i = 0;
+
+  if (term->write("\x1b[6n", 4) != 4) return -1;
+
+  while (i < sizeof(buf) - 1) {
+    if (term->read(&buf[i]) != 1) break;
+    if (buf[i] == 'R') break;
+    i++;
+  }
+  buf[i] = '\0';
+
+  if (buf[0] != '\x1b' || buf[1] != '[') return -1;
+  if (sscanf(&buf[2], "%d;%d", rows, cols) != 2) return -1;
+
+  return 0;
+}
+
+int getWindowSize(int *rows, int *cols) {
+  return term->size(rows, cols);
+}
@@ -1,2 +1,69 @@
+#pragma once
 
+#include <cstddef>
+#include <cstdio>
+#include <string>
 
+#define CTRL_KEY(k) ((k) & 0x1f)
+
+enum editorKey {
+  BACKSPACE = 127,
+  ARROW_LEFT = 1000,
+  ARROW_RIGHT,
+  ARROW_UP,
+  ARROW_DOWN,
+  DEL_KEY,
+  HOME_KEY,
+  END_KEY,
+  PAGE_UP,
+  PAGE_DOWN,
+  WATCH_EVENT,
+  WAKE_EVENT,
+  IDLE_EVENT
+};
+
+/*** terminal backends ***/
+
+enum termReady {
+  TERM_INPUT,
+  TERM_WATCH,
+  TERM_WAKE,
+  TERM_IDLE
+};
+
+/* Everything the editor does with its terminal goes through the current
+ * backend: the tty by default, or an in-memory one (termUseMemory) that
+ * runs the editor headless, reading keys from a queue and capturing what
+ * would have been drawn.
+ *
+ * wait blocks until a key byte can be read or watchfd or wakefd (either
+ * may be -1) is readable, and says which, or for at most timeout ms
+ * (unless -1), after which it reports TERM_IDLE. read returns 1 with one byte of
+ * a key, or 0 if none arrived in time, which is how a lone Esc is told
+ * apart from an escape sequence. */
+struct termBackend {
+  void (*enableRaw)();
+  void (*disableRaw)();
+  int (*wait)(int watchfd, int wakefd, int timeout);
+  int (*read)(char *c);
+  int (*write)(const char *s, int len);
+  int (*size)(int *rows, int *cols);
+};
+
+void termUseMemory(int rows, int cols);
+void termMemoryPush(const std::string &key);
+size_t termMemoryPending();
+const std::string &termMemoryPeek();
+long long termMemoryWritten();
+int termMemoryWrites();
+std::string termMemoryTakeOutput();
+int termWrite(const char *s, int len);
+void termRecord(FILE *fp);
+std::string termEscapeKey(const std::string &key);
+int termUnescapeKey(const char *line, std::string *key);
+
+void disableRawMode();
+void enableRawMode();
+int editorReadKey();
+int getCursorPosition(int *rows, int *cols);
+int getWindowSize(int *rows, int *cols);
@@ -0,0 +1,61 @@
+#include "Arena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static const int arenaClassSize[ARENA_CLASSES] = {
+  16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536,
+  2048, 3072, 4096, 6144, 8192, 12288, 16384, 24576, 32768, 49152
+};
+
+static int arenaClass(int size) {
+  int c = 0;
+  while (c < ARENA_CLASSES && arenaClassSize[c] < size) c++;
+  return c;
+}
+
+void *arenaAlloc(struct arena *a, int size, int *cap) {
+  int c = arenaClass(size);
+  if (c == ARENA_CLASSES) {
+    *cap = size;
+    a->inuse += size;
+    return malloc(size);
+  }
+  *cap = arenaClassSize[c];
+  a->inuse += *cap;
+
+  if (a->freelist[c]) {
+    void *p = a->freelist[c];
+    memcpy(&a->freelist[c], p, sizeof(void *));
+    return p;
+  }
+
+  if (a->left < (size_t)*cap) {
+    a->chunks = (char **)realloc(a->chunks, sizeof(char *) * (a->nchunks + 1));
+    a->cur = (char *)malloc(ARENA_CHUNK);
+    a->chunks[a->nchunks++] = a->cur;
+    a->left = ARENA_CHUNK;
+  }
+  void *p = a->cur;
+  a->cur += *cap;
+  a->left -= *cap;
+  return p;
+}
+
+void arenaFree(struct arena *a, void *p, int cap) {
+  if (p == NULL) return;
+  a->inuse -= cap;
+  int c = arenaClass(cap);
+  if (c == ARENA_CLASSES) {
+    free(p);
+    return;
+  }
+  memcpy(p, &a->freelist[c], sizeof(void *));
+  a->freelist[c] = p;
+}
+
+void arenaFreeAll(struct arena *a) {
+  for (int i = 0; i < a->nchunks; i++) free(a->chunks[i]);
+  free(a->chunks);
+  memset(a, 0, sizeof(*a));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+/*** slab arena ***/
+
+/* Blocks are rounded up to one of a fixed set of size classes and carved
+ * out of large chunks; freed blocks go on a per-class free list for reuse.
+ * There is no per-block header, so the caller passes the block's capacity
+ * back to arenaFree. Requests beyond the largest class fall back to
+ * malloc and must be freed individually; everything else is released at
+ * once by arenaFreeAll. */
+
+#define ARENA_CHUNK (1 << 20)
+#define ARENA_CLASSES 24
+
+struct arena {
+  char **chunks;
+  int nchunks;
+  char *cur;
+  size_t left;
+  void *freelist[ARENA_CLASSES];
+  size_t inuse;
+};
+
+void *arenaAlloc(struct arena *a, int size, int *cap);
+void arenaFree(struct arena *a, void *p, int cap);
+void arenaFreeAll(struct arena *a);
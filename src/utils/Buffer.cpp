@@ -1,2 +1,17 @@
+#include "Buffer.h"
 
+#include <cstdlib>
+#include <cstring>
 
+void abAppend(struct abuf *ab, const char *s, int len) {
+  char *grown = (char *)realloc(ab->b, ab->len + len);
+
+  if (grown == NULL) return;
+  memcpy(&grown[ab->len], s, len);
+  ab->b = grown;
+  ab->len += len;
+}
+
+void abFree(struct abuf *ab) {
+  free(ab->b);
+}
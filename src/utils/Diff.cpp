@@ -0,0 +1,123 @@
+#include "Diff.h"
+
+struct diffContext {
+  const uint64_t *a;
+  const uint64_t *b;
+  /* Furthest reaching x per diagonal k, stored at k + off, for the
+   * forward and the backward search. */
+  std::vector<int> fwd;
+  std::vector<int> bwd;
+  int off;
+  std::vector<diffHunk> *hunks;
+};
+
+static void diffEmit(diffContext *c, int a, int alen, int b, int blen) {
+  if (alen == 0 && blen == 0) return;
+  std::vector<diffHunk> &h = *c->hunks;
+  if (!h.empty() && h.back().a + h.back().alen == a &&
+      h.back().b + h.back().blen == b) {
+    h.back().alen += alen;
+    h.back().blen += blen;
+    return;
+  }
+  h.push_back({a, alen, b, blen});
+}
+
+/* Finds the middle snake of a[a0, a1) against b[b0, b1), both non-empty
+ * and differing in their first and last lines: the searches from either
+ * end meet on a diagonal, and the snake they meet on splits the edit
+ * script into halves of at most ceil(D / 2) edits each. Stores where the
+ * snake starts in (*x, *y) and where it ends in (*u, *v). */
+static void diffMiddleSnake(diffContext *c, int a0, int a1, int b0, int b1,
+                            int *x, int *y, int *u, int *v) {
+  const uint64_t *a = c->a;
+  const uint64_t *b = c->b;
+  int *fwd = c->fwd.data() + c->off;
+  int *bwd = c->bwd.data() + c->off;
+  int n = a1 - a0;
+  int m = b1 - b0;
+  int delta = n - m;
+  int odd = delta & 1;
+  int maxd = (n + m + 1) / 2;
+
+  fwd[1] = 0;
+  bwd[1] = 0;
+  for (int d = 0; d <= maxd; d++) {
+    for (int k = -d; k <= d; k += 2) {
+      int px = (k == -d || (k != d && fwd[k - 1] < fwd[k + 1])) ?
+        fwd[k + 1] : fwd[k - 1] + 1;
+      int py = px - k;
+      int sx = px, sy = py;
+      while (px < n && py < m && a[a0 + px] == b[b0 + py]) {
+        px++;
+        py++;
+      }
+      fwd[k] = px;
+      int kb = delta - k;
+      if (odd && kb >= -(d - 1) && kb <= d - 1 && px + bwd[kb] >= n) {
+        *x = a0 + sx;
+        *y = b0 + sy;
+        *u = a0 + px;
+        *v = b0 + py;
+        return;
+      }
+    }
+    for (int k = -d; k <= d; k += 2) {
+      int px = (k == -d || (k != d && bwd[k - 1] < bwd[k + 1])) ?
+        bwd[k + 1] : bwd[k - 1] + 1;
+      int py = px - k;
+      int sx = px, sy = py;
+      while (px < n && py < m && a[a1 - 1 - px] == b[b1 - 1 - py]) {
+        px++;
+        py++;
+      }
+      bwd[k] = px;
+      int kf = delta - k;
+      if (!odd && kf >= -d && kf <= d && px + fwd[kf] >= n) {
+        *x = a1 - px;
+        *y = b1 - py;
+        *u = a1 - sx;
+        *v = b1 - sy;
+        return;
+      }
+    }
+  }
+  /* Not reached: the searches always meet by d = maxd. */
+  *x = *u = a0;
+  *y = *v = b0;
+}
+
+static void diffCompare(diffContext *c, int a0, int a1, int b0, int b1) {
+  while (a0 < a1 && b0 < b1 && c->a[a0] == c->b[b0]) {
+    a0++;
+    b0++;
+  }
+  while (a0 < a1 && b0 < b1 && c->a[a1 - 1] == c->b[b1 - 1]) {
+    a1--;
+    b1--;
+  }
+  if (a0 == a1 || b0 == b1) {
+    diffEmit(c, a0, a1 - a0, b0, b1 - b0);
+    return;
+  }
+
+  /* With the common ends stripped D is at least 2, so both halves are
+   * strictly smaller problems. */
+  int x, y, u, v;
+  diffMiddleSnake(c, a0, a1, b0, b1, &x, &y, &u, &v);
+  diffCompare(c, a0, x, b0, y);
+  diffCompare(c, u, a1, v, b1);
+}
+
+void diffLines(const uint64_t *a, int n, const uint64_t *b, int m,
+               std::vector<diffHunk> *hunks) {
+  hunks->clear();
+  diffContext c;
+  c.a = a;
+  c.b = b;
+  c.off = (n + m + 1) / 2 + 2;
+  c.fwd.resize(2 * c.off + 1);
+  c.bwd.resize(2 * c.off + 1);
+  c.hunks = hunks;
+  diffCompare(&c, 0, n, 0, m);
+}
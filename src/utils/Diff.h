@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*** diff ***/
+
+/* Line diff with Myers' O((N+M)D) algorithm in its linear-space form:
+ * each step finds the middle snake of the shortest edit script and
+ * recurses on either side of it, after stripping the lines both halves
+ * start and end with. Lines are compared by hash (see Hash.h), so a
+ * caller hashes each line once and the diff never touches text.
+ *
+ * The result is a minimal list of hunks in order: lines [a, a + alen) of
+ * the first sequence are replaced by lines [b, b + blen) of the second.
+ * Either length may be zero, but not both. */
+
+struct diffHunk {
+  int a;
+  int alen;
+  int b;
+  int blen;
+};
+
+void diffLines(const uint64_t *a, int n, const uint64_t *b, int m,
+               std::vector<diffHunk> *hunks);
@@ -0,0 +1,171 @@
+#include "Fenwick.h"
+
+#include <cstddef>
+
+template <typename T>
+static void treeAdd(std::vector<T> &tree, int k, T delta) {
+  for (k++; k <= (int)tree.size(); k += k & -k) tree[k - 1] += delta;
+}
+
+template <typename T>
+static T treePrefix(const std::vector<T> &tree, int k) {
+  T sum = 0;
+  for (; k > 0; k -= k & -k) sum += tree[k - 1];
+  return sum;
+}
+
+/* Largest number of leading blocks whose tree total is <= target; their
+ * total is stored in *below. */
+template <typename T>
+static int treeDescend(const std::vector<T> &tree, T target, T *below) {
+  int n = tree.size();
+  int step = 1;
+  while (step * 2 <= n) step *= 2;
+  int k = 0;
+  T sum = 0;
+  for (; step; step /= 2) {
+    if (k + step <= n && sum + tree[k + step - 1] <= target) {
+      k += step;
+      sum += tree[k - 1];
+    }
+  }
+  *below = sum;
+  return k;
+}
+
+static void rebuildTrees(struct fenwick *fw) {
+  int nb = fw->blocks.size();
+  fw->sums.assign(nb, 0);
+  fw->counts.assign(nb, 0);
+  for (int b = 0; b < nb; b++) {
+    fw->sums[b] += fw->blocksums[b];
+    fw->counts[b] += fw->blocks[b].size();
+    int parent = b + ((b + 1) & -(b + 1));
+    if (parent < nb) {
+      fw->sums[parent] += fw->sums[b];
+      fw->counts[parent] += fw->counts[b];
+    }
+  }
+}
+
+/* Maps element i to its block and its position inside the block. An index
+ * equal to the size maps to the end of the last block. */
+static int locate(const struct fenwick *fw, int i, int *pos) {
+  int before;
+  int b = treeDescend(fw->counts, i, &before);
+  if (b == (int)fw->blocks.size()) {
+    b--;
+    before -= fw->blocks[b].size();
+  }
+  *pos = i - before;
+  return b;
+}
+
+void fwInit(struct fenwick *fw, const int *values, int n) {
+  fw->blocks.clear();
+  fw->blocksums.clear();
+  fw->total = 0;
+  for (int i = 0; i < n; i += FENWICK_BLOCK) {
+    int end = i + FENWICK_BLOCK < n ? i + FENWICK_BLOCK : n;
+    fw->blocks.emplace_back(values + i, values + end);
+    long long sum = 0;
+    for (int j = i; j < end; j++) sum += values[j];
+    fw->blocksums.push_back(sum);
+    fw->total += sum;
+  }
+  if (fw->blocks.empty()) {
+    fw->blocks.emplace_back();
+    fw->blocksums.push_back(0);
+  }
+  fw->size = n;
+  rebuildTrees(fw);
+}
+
+int fwGet(const struct fenwick *fw, int i) {
+  int pos;
+  int b = locate(fw, i, &pos);
+  return fw->blocks[b][pos];
+}
+
+void fwSet(struct fenwick *fw, int i, int value) {
+  int pos;
+  int b = locate(fw, i, &pos);
+  long long delta = (long long)value - fw->blocks[b][pos];
+  if (delta == 0) return;
+  fw->blocks[b][pos] = value;
+  fw->blocksums[b] += delta;
+  fw->total += delta;
+  treeAdd(fw->sums, b, delta);
+}
+
+void fwInsert(struct fenwick *fw, int i, int value) {
+  if (fw->blocks.empty()) fwInit(fw, NULL, 0);
+  int pos;
+  int b = locate(fw, i, &pos);
+  std::vector<int> &block = fw->blocks[b];
+  block.insert(block.begin() + pos, value);
+  fw->blocksums[b] += value;
+  fw->size++;
+  fw->total += value;
+
+  if ((int)block.size() > 2 * FENWICK_BLOCK) {
+    std::vector<int> tail(block.begin() + FENWICK_BLOCK, block.end());
+    block.resize(FENWICK_BLOCK);
+    long long tailsum = 0;
+    for (int v : tail) tailsum += v;
+    fw->blocksums[b] -= tailsum;
+    fw->blocks.insert(fw->blocks.begin() + b + 1, std::move(tail));
+    fw->blocksums.insert(fw->blocksums.begin() + b + 1, tailsum);
+    rebuildTrees(fw);
+  } else {
+    treeAdd(fw->sums, b, (long long)value);
+    treeAdd(fw->counts, b, 1);
+  }
+}
+
+void fwErase(struct fenwick *fw, int i) {
+  int pos;
+  int b = locate(fw, i, &pos);
+  std::vector<int> &block = fw->blocks[b];
+  int value = block[pos];
+  block.erase(block.begin() + pos);
+  fw->blocksums[b] -= value;
+  fw->size--;
+  fw->total -= value;
+
+  if (block.empty() && fw->blocks.size() > 1) {
+    fw->blocks.erase(fw->blocks.begin() + b);
+    fw->blocksums.erase(fw->blocksums.begin() + b);
+    rebuildTrees(fw);
+  } else {
+    treeAdd(fw->sums, b, -(long long)value);
+    treeAdd(fw->counts, b, -1);
+  }
+}
+
+/* Sum of the first i elements. */
+long long fwPrefix(const struct fenwick *fw, int i) {
+  if (i >= fw->size) return fw->total;
+  int pos;
+  int b = locate(fw, i, &pos);
+  long long sum = treePrefix(fw->sums, b);
+  for (int j = 0; j < pos; j++) sum += fw->blocks[b][j];
+  return sum;
+}
+
+/* Index of the element that covers position target, i.e. the largest i
+ * with fwPrefix(i) <= target; returns the size when target is past the
+ * total. */
+int fwFind(const struct fenwick *fw, long long target) {
+  if (target >= fw->total) return fw->size;
+  long long below;
+  int b = treeDescend(fw->sums, target, &below);
+  int index = treePrefix(fw->counts, b);
+  const std::vector<int> &block = fw->blocks[b];
+  for (int v : block) {
+    if (below + v > target) break;
+    below += v;
+    index++;
+  }
+  return index;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+/*** prefix sums ***/
+
+/* Prefix sums over a sequence of non-negative ints that, unlike a plain
+ * Fenwick tree, also supports inserting and erasing elements. Elements
+ * are kept in blocks of at most FENWICK_BLOCK; two Fenwick trees over the
+ * blocks hold their element counts and their sums, so lookups and updates
+ * cost O(log n + FENWICK_BLOCK). A block that overflows is split, which
+ * rebuilds the block trees from the cached block sums in
+ * O(n / FENWICK_BLOCK). */
+
+#define FENWICK_BLOCK 512
+
+struct fenwick {
+  std::vector<std::vector<int>> blocks;
+  std::vector<long long> blocksums;
+  std::vector<long long> sums;
+  std::vector<int> counts;
+  int size;
+  long long total;
+};
+
+void fwInit(struct fenwick *fw, const int *values, int n);
+int fwGet(const struct fenwick *fw, int i);
+void fwSet(struct fenwick *fw, int i, int value);
+void fwInsert(struct fenwick *fw, int i, int value);
+void fwErase(struct fenwick *fw, int i);
+long long fwPrefix(const struct fenwick *fw, int i);
+int fwFind(const struct fenwick *fw, long long target);
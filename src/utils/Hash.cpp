@@ -0,0 +1,47 @@
+#include "Hash.h"
+
+#include <cstring>
+
+#define HASH_K 0x9E3779B97F4A7C15ULL
+
+static inline uint64_t load64(const unsigned char *p) {
+  uint64_t w;
+  memcpy(&w, p, 8);
+  return w;
+}
+
+static inline uint64_t load32(const unsigned char *p) {
+  uint32_t w;
+  memcpy(&w, p, 4);
+  return w;
+}
+
+uint64_t hashBytes(const void *data, size_t len) {
+  const unsigned char *p = (const unsigned char *)data;
+  uint64_t h = len * HASH_K;
+  uint64_t w;
+  if (len > 8) {
+    const unsigned char *last = p + len - 8;
+    while (p < last) {
+      h = (h ^ load64(p)) * HASH_K;
+      h ^= h >> 29;
+      p += 8;
+    }
+    /* The last word overlaps the one before rather than being padded;
+     * the length in the seed keeps that unambiguous. */
+    w = load64(last);
+  } else if (len >= 4) {
+    w = load32(p) << 32 | load32(p + len - 4);
+  } else if (len > 0) {
+    w = (uint64_t)p[0] << 16 | (uint64_t)p[len / 2] << 8 | p[len - 1];
+  } else {
+    w = 0;
+  }
+  h = (h ^ w) * HASH_K;
+
+  /* Final avalanche, so that every bit of the input reaches the low bits. */
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  return h;
+}
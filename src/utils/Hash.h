@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*** hashing ***/
+
+/* A fast non-cryptographic hash for telling lines and blocks of text
+ * apart, eight bytes per step. Values are only meaningful within one
+ * process; don't persist them. */
+uint64_t hashBytes(const void *data, size_t len);
+
+/* Folds v into h; the result depends on the order of the values. */
+inline uint64_t hashCombine(uint64_t h, uint64_t v) {
+  h ^= v + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+  return h;
+}
@@ -1,2 +1,14 @@
+#include "Helpers.h"
 
+#include <cstdio>
+#include <cstdlib>
 
+#include "Terminal.h"
+
+void die(const char *s) {
+  termWrite("\x1b[2J", 4);
+  termWrite("\x1b[H", 3);
+
+  perror(s);
+  exit(1);
+}
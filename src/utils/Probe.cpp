@@ -0,0 +1,75 @@
+#include "Probe.h"
+
+struct probeHist probeHists[PROBE_COUNT];
+std::atomic<int64_t> probeMem[PROBE_MEM_COUNT];
+
+const char *probeName(int id) {
+  static const char *names[PROBE_COUNT] = {
+    "input", "keypress", "syntax", "frame", "write", "save", "search", "grep"
+  };
+  return names[id];
+}
+
+const char *probeMemName(int kind) {
+  static const char *names[PROBE_MEM_COUNT] = {"rows", "render", "hl", "undo"};
+  return names[kind];
+}
+
+int probeBucket(uint64_t ns) {
+  const int sub = 1 << PROBE_SUB_BITS;
+  if (ns < 2 * sub) return ns;
+  int e = 63 - __builtin_clzll(ns);
+  return (e - PROBE_SUB_BITS + 1) * sub +
+         ((ns >> (e - PROBE_SUB_BITS)) & (sub - 1));
+}
+
+/* The smallest value that lands in bucket. */
+uint64_t probeBucketLow(int bucket) {
+  const int sub = 1 << PROBE_SUB_BITS;
+  if (bucket < 2 * sub) return bucket;
+  int e = bucket / sub + PROBE_SUB_BITS - 1;
+  return (uint64_t)(sub + bucket % sub) << (e - PROBE_SUB_BITS);
+}
+
+void probeRecord(int id, uint64_t ns) {
+  struct probeHist *h = &probeHists[id];
+  h->buckets[probeBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+  h->count.fetch_add(1, std::memory_order_relaxed);
+  h->sum.fetch_add(ns, std::memory_order_relaxed);
+  uint64_t max = h->max.load(std::memory_order_relaxed);
+  while (ns > max &&
+         !h->max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+  }
+}
+
+/* The value below which a fraction q of the recorded values fall, to
+ * within a bucket: the middle of the bucket that holds it, clamped to
+ * the largest value seen. */
+uint64_t probeQuantile(int id, double q) {
+  struct probeHist *h = &probeHists[id];
+  uint64_t count = h->count.load(std::memory_order_relaxed);
+  if (count == 0) return 0;
+  uint64_t rank = q * count, seen = 0;
+  uint64_t max = h->max.load(std::memory_order_relaxed);
+  for (int b = 0; b < PROBE_BUCKETS; b++) {
+    seen += h->buckets[b].load(std::memory_order_relaxed);
+    if (seen > rank) {
+      uint64_t lo = probeBucketLow(b);
+      uint64_t hi = b + 1 < PROBE_BUCKETS ? probeBucketLow(b + 1) : lo;
+      uint64_t mid = lo + (hi - lo) / 2;
+      return mid < max ? mid : max;
+    }
+  }
+  return max;
+}
+
+/* Clears the histograms; the memory counters describe what is held now
+ * and are left alone. */
+void probeReset() {
+  for (struct probeHist &h : probeHists) {
+    for (auto &b : h.buckets) b.store(0, std::memory_order_relaxed);
+    h.count.store(0, std::memory_order_relaxed);
+    h.sum.store(0, std::memory_order_relaxed);
+    h.max.store(0, std::memory_order_relaxed);
+  }
+}
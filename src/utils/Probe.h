@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*** probes ***/
+
+/* Timing probes on the hot paths feed one histogram each. A histogram is
+ * log-linear like HdrHistogram: values (in nanoseconds) below 16 get a
+ * bucket each, and every power of two above is split into 8 buckets, so
+ * a bucket is never more than 12.5% wide. Every field is an atomic
+ * updated with relaxed operations, so probes on worker threads need no
+ * lock and readers see counts that are at worst a few updates stale.
+ *
+ * PROBE_KEY times one top-level key, but not a key that opened a prompt
+ * (find, goto, save as, grep, cursors): that time is mostly the user
+ * typing into the prompt, whose redraws PROBE_FRAME counts on its own.
+ * The process_us of a replay step (see Replay.h) does include prompts;
+ * such steps are the ones with keys > 1.
+ *
+ * Building with BYTE_WRITER_PROBES off turns PROBE and PROBE_MEM into
+ * nothing; the histograms then stay empty. */
+
+#define PROBE_SUB_BITS 3
+#define PROBE_BUCKETS ((64 - PROBE_SUB_BITS + 1) << PROBE_SUB_BITS)
+
+enum probeId {
+  PROBE_INPUT,
+  PROBE_KEY,
+  PROBE_SYNTAX,
+  PROBE_FRAME,
+  PROBE_WRITE,
+  PROBE_SAVE,
+  PROBE_SEARCH,
+  PROBE_GREP,
+  PROBE_COUNT
+};
+
+/* Bytes held per subsystem. */
+enum probeMemKind {
+  PROBE_MEM_ROWS,
+  PROBE_MEM_RENDER,
+  PROBE_MEM_HL,
+  PROBE_MEM_UNDO,
+  PROBE_MEM_COUNT
+};
+
+struct probeHist {
+  std::atomic<uint64_t> buckets[PROBE_BUCKETS];
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> max;
+};
+
+extern struct probeHist probeHists[PROBE_COUNT];
+extern std::atomic<int64_t> probeMem[PROBE_MEM_COUNT];
+
+const char *probeName(int id);
+const char *probeMemName(int kind);
+int probeBucket(uint64_t ns);
+uint64_t probeBucketLow(int bucket);
+void probeRecord(int id, uint64_t ns);
+uint64_t probeQuantile(int id, double q);
+void probeReset();
+
+inline void probeMemAdd(int kind, int64_t delta) {
+  probeMem[kind].fetch_add(delta, std::memory_order_relaxed);
+}
+
+/* Records the time from its construction to the end of its scope. */
+struct probeScope {
+  int id;
+  std::chrono::steady_clock::time_point t0;
+
+  explicit probeScope(int id) : id(id), t0(std::chrono::steady_clock::now()) {}
+  ~probeScope() {
+    if (id == -1) return;
+    probeRecord(id, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - t0).count());
+  }
+
+  /* Leaves the span out of the histogram after all. */
+  void drop() { id = -1; }
+};
+
+#define PROBE_JOIN2(a, b) a##b
+#define PROBE_JOIN(a, b) PROBE_JOIN2(a, b)
+
+#ifdef BYTE_WRITER_PROBES
+#define PROBE(id) probeScope PROBE_JOIN(probe_, __LINE__)(id)
+#define PROBE_NAMED(name, id) probeScope name(id)
+#define PROBE_DROP(name) name.drop()
+#define PROBE_MEM(kind, delta) probeMemAdd(kind, delta)
+#else
+#define PROBE(id) do {} while (0)
+#define PROBE_NAMED(name, id) do {} while (0)
+#define PROBE_DROP(name) do {} while (0)
+#define PROBE_MEM(kind, delta) ((void)(kind), (void)(delta))
+#endif
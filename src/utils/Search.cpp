@@ -0,0 +1,39 @@
+#include "Search.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const char *searchFind(const char *hay, size_t len, const char *needle,
+                       size_t nlen) {
+  if (nlen == 0) return hay;
+  if (nlen > len) return NULL;
+  if (nlen == 1) return (const char *)memchr(hay, needle[0], len);
+
+  size_t i = 0;
+  size_t last = nlen - 1;
+#if defined(__SSE2__)
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i final = _mm_set1_epi8(needle[last]);
+  for (; i + last + 16 <= len; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(hay + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(hay + i + last));
+    int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first),
+                                               _mm_cmpeq_epi8(b, final)));
+    while (mask) {
+      int bit = __builtin_ctz(mask);
+      if (memcmp(hay + i + bit + 1, needle + 1, nlen - 2) == 0)
+        return hay + i + bit;
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for (; i + nlen <= len; i++) {
+    if (hay[i] == needle[0] && hay[i + last] == needle[last] &&
+        memcmp(hay + i, needle, nlen) == 0)
+      return hay + i;
+  }
+  return NULL;
+}
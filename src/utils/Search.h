@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+/*** literal search ***/
+
+/* Returns the first occurrence of needle[0, nlen) in hay[0, len), or NULL.
+ * Candidates are found 16 positions at a time by comparing the needle's
+ * first and last bytes at once, and only those are checked in full. Find
+ * (Ctrl-F) and project search (Grep.h) share this kernel. */
+const char *searchFind(const char *hay, size_t len, const char *needle,
+                       size_t nlen);
@@ -0,0 +1,157 @@
+#include "Sidecar.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define SIDECAR_MAGIC "BWLIDX01"
+#define SIDECAR_SAMPLE 4096
+
+struct sidecarHeader {
+  char magic[8];
+  uint64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint64_t dev;
+  uint64_t ino;
+  uint64_t sample;
+  uint64_t nlines;
+  uint64_t invalid;
+};
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+  const unsigned char *p = (const unsigned char *)data;
+  for (size_t i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/* Hashes a block at the start, middle and end of the file: an edit that
+ * keeps size and mtime (e.g. touch -r) is still likely to be noticed,
+ * while checking costs three reads whatever the file's size. */
+static uint64_t sampleChecksum(int fd, off_t size) {
+  uint64_t h = 14695981039346656037ULL;
+  off_t at[3] = { 0, size / 2, size - SIDECAR_SAMPLE };
+  char buf[SIDECAR_SAMPLE];
+  for (off_t off : at) {
+    if (off < 0) off = 0;
+    ssize_t n = pread(fd, buf, sizeof(buf), off);
+    if (n > 0) h = fnv1a(h, buf, n);
+  }
+  return h;
+}
+
+static void fillHeader(struct sidecarHeader *h, int fd,
+                       const struct stat *st) {
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, SIDECAR_MAGIC, sizeof(h->magic));
+  h->size = st->st_size;
+  h->mtime_sec = st->st_mtim.tv_sec;
+  h->mtime_nsec = st->st_mtim.tv_nsec;
+  h->dev = st->st_dev;
+  h->ino = st->st_ino;
+  h->sample = sampleChecksum(fd, st->st_size);
+}
+
+/* Writes the sidecar's path for the file at path into out; creates the
+ * cache directory when mkdirs is set. */
+static int sidecarPath(const char *path, char *out, size_t outlen,
+                       int mkdirs) {
+  char real[PATH_MAX];
+  if (realpath(path, real) == NULL) return -1;
+
+  char dir[PATH_MAX];
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  if (xdg && xdg[0]) {
+    snprintf(dir, sizeof(dir), "%s", xdg);
+  } else if (home && home[0]) {
+    snprintf(dir, sizeof(dir), "%s/.cache", home);
+  } else {
+    return -1;
+  }
+  if (mkdirs) mkdir(dir, 0755);
+  size_t len = strlen(dir);
+  snprintf(dir + len, sizeof(dir) - len, "/byte-writer");
+  if (mkdirs) mkdir(dir, 0755);
+
+  uint64_t key = fnv1a(14695981039346656037ULL, real, strlen(real));
+  int n = snprintf(out, outlen, "%s/%016llx.idx", dir,
+                   (unsigned long long)key);
+  return n < (int)outlen ? 0 : -1;
+}
+
+int sidecarOpen(const char *path, int fd, const struct stat *st,
+                struct sidecarIndex *idx) {
+  char cache[PATH_MAX];
+  if (sidecarPath(path, cache, sizeof(cache), 0) == -1) return -1;
+
+  int cfd = open(cache, O_RDONLY);
+  if (cfd == -1) return -1;
+  struct stat cst;
+  if (fstat(cfd, &cst) == -1 || cst.st_size < (off_t)sizeof(sidecarHeader)) {
+    close(cfd);
+    return -1;
+  }
+  void *map = mmap(NULL, cst.st_size, PROT_READ, MAP_PRIVATE, cfd, 0);
+  close(cfd);
+  if (map == MAP_FAILED) return -1;
+
+  struct sidecarHeader want;
+  fillHeader(&want, fd, st);
+  const struct sidecarHeader *h = (const struct sidecarHeader *)map;
+  uint64_t n = h->nlines;
+  size_t expect = sizeof(*h) + n * (sizeof(uint64_t) + sizeof(uint32_t));
+  if (memcmp(h, &want, offsetof(sidecarHeader, nlines)) != 0 ||
+      n > INT_MAX || (size_t)cst.st_size != expect) {
+    munmap(map, cst.st_size);
+    return -1;
+  }
+
+  idx->map = map;
+  idx->maplen = cst.st_size;
+  idx->offsets = (const unsigned long long *)(h + 1);
+  idx->lens = (const unsigned *)(idx->offsets + n);
+  idx->nlines = n;
+  idx->invalid = h->invalid;
+  return 0;
+}
+
+void sidecarClose(struct sidecarIndex *idx) {
+  if (idx->map) munmap(idx->map, idx->maplen);
+  idx->map = NULL;
+}
+
+/* Writes to a temporary file and renames it into place, so a reader never
+ * sees a partial index. */
+int sidecarWrite(const char *path, int fd, const struct stat *st,
+                 const unsigned long long *offsets, const unsigned *lens,
+                 int nlines, int invalid) {
+  char cache[PATH_MAX];
+  if (sidecarPath(path, cache, sizeof(cache), 1) == -1) return -1;
+  char tmp[PATH_MAX + 16];
+  snprintf(tmp, sizeof(tmp), "%s.%d", cache, (int)getpid());
+
+  struct sidecarHeader h;
+  fillHeader(&h, fd, st);
+  h.nlines = nlines;
+  h.invalid = invalid;
+
+  FILE *fp = fopen(tmp, "w");
+  if (!fp) return -1;
+  int ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+           fwrite(offsets, sizeof(*offsets), nlines, fp) == (size_t)nlines &&
+           fwrite(lens, sizeof(*lens), nlines, fp) == (size_t)nlines;
+  if (fclose(fp) != 0) ok = 0;
+  if (!ok || rename(tmp, cache) == -1) {
+    unlink(tmp);
+    return -1;
+  }
+  return 0;
+}
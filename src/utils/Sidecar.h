@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/stat.h>
+
+/*** sidecar line index ***/
+
+/* A cache of a file's line boundaries, stored under
+ * $XDG_CACHE_HOME/byte-writer (or ~/.cache/byte-writer) and keyed by the
+ * file's real path. It holds the start offset and length (newline and any
+ * trailing CRs excluded) of every line, and is only trusted when the
+ * file's size, mtime, device, inode and a checksum of a few sampled
+ * blocks all match. Reading one maps it; nothing is copied. */
+
+struct sidecarIndex {
+  void *map;
+  size_t maplen;
+  const unsigned long long *offsets;
+  const unsigned *lens;
+  int nlines;
+  int invalid;
+};
+
+int sidecarOpen(const char *path, int fd, const struct stat *st,
+                struct sidecarIndex *idx);
+void sidecarClose(struct sidecarIndex *idx);
+int sidecarWrite(const char *path, int fd, const struct stat *st,
+                 const unsigned long long *offsets, const unsigned *lens,
+                 int nlines, int invalid);
@@ -0,0 +1,153 @@
+#include "Trie.h"
+
+#include <algorithm>
+#include <queue>
+
+void trieInit(struct trie *t) {
+  t->nodes.assign(1, trieNode{0, 0, 0, 0});
+  t->bytes.assign(1, 0);
+  t->freelist = 0;
+  t->words = 0;
+}
+
+/* Returns the child of node n for byte c, or 0. */
+static uint32_t trieFind(const struct trie *t, uint32_t n, unsigned char c) {
+  uint32_t cur = t->nodes[n].child;
+  while (cur && t->bytes[cur] < c) cur = t->nodes[cur].next;
+  return cur && t->bytes[cur] == c ? cur : 0;
+}
+
+/* Returns the child of node n for byte c, adding it if there is none. */
+static uint32_t trieChild(struct trie *t, uint32_t n, unsigned char c) {
+  uint32_t prev = 0;
+  uint32_t cur = t->nodes[n].child;
+  while (cur && t->bytes[cur] < c) {
+    prev = cur;
+    cur = t->nodes[cur].next;
+  }
+  if (cur && t->bytes[cur] == c) return cur;
+
+  uint32_t m = t->freelist;
+  if (m) {
+    t->freelist = t->nodes[m].next;
+  } else {
+    m = t->nodes.size();
+    t->nodes.emplace_back();
+    t->bytes.emplace_back();
+  }
+  t->nodes[m] = trieNode{0, cur, 0, 0};
+  t->bytes[m] = c;
+  if (prev) t->nodes[prev].next = m;
+  else t->nodes[n].child = m;
+  return m;
+}
+
+static void trieUnlink(struct trie *t, uint32_t parent, uint32_t n) {
+  uint32_t *link = &t->nodes[parent].child;
+  while (*link != n) link = &t->nodes[*link].next;
+  *link = t->nodes[n].next;
+  t->nodes[n].next = t->freelist;
+  t->freelist = n;
+}
+
+/* Adds delta to the count of s[0, len). Counts do not go below zero. */
+void trieAdd(struct trie *t, const char *s, int len, int delta) {
+  if (delta == 0) return;
+  uint32_t local[64];
+  std::vector<uint32_t> heap;
+  uint32_t *path = local;
+  if (len >= 64) {
+    heap.resize(len + 1);
+    path = heap.data();
+  }
+
+  path[0] = 0;
+  for (int i = 0; i < len; i++) {
+    unsigned char c = s[i];
+    path[i + 1] = delta > 0 ? trieChild(t, path[i], c) : trieFind(t, path[i], c);
+    if (path[i + 1] == 0) return;
+  }
+
+  trieNode &leaf = t->nodes[path[len]];
+  int old = leaf.count;
+  leaf.count = std::max(old + delta, 0);
+  if (old == 0 && leaf.count > 0) t->words++;
+  if (old > 0 && leaf.count == 0) t->words--;
+  if (delta > 0) {
+    int count = leaf.count;
+    for (int i = 0; i <= len; i++) {
+      trieNode &n = t->nodes[path[i]];
+      if (n.best < count) n.best = count;
+    }
+    return;
+  }
+
+  /* Redo best from the leaf up until it stops changing, dropping nodes
+   * that no longer lead to a word. */
+  for (int i = len; i >= 0; i--) {
+    trieNode &n = t->nodes[path[i]];
+    int best = n.count;
+    for (uint32_t c = n.child; c; c = t->nodes[c].next)
+      best = std::max(best, t->nodes[c].best);
+    if (i > 0 && best == 0) {
+      trieUnlink(t, path[i - 1], path[i]);
+      continue;
+    }
+    if (best == n.best) break;
+    n.best = best;
+  }
+}
+
+int trieCount(const struct trie *t, const char *s, int len) {
+  uint32_t n = 0;
+  for (int i = 0; i < len && (n = trieFind(t, n, s[i])) != 0; i++) {}
+  return len == 0 || n ? t->nodes[n].count : 0;
+}
+
+struct trieEntry {
+  int prio;
+  int word;
+  uint32_t node;
+  std::string text;
+};
+
+/* Orders the queue: higher counts first, then shorter, then bytewise,
+ * then a word ahead of the subtree at the same node. A subtree's text is
+ * a prefix of all its words, so it never comes after a word it should
+ * precede. */
+static bool trieAfter(const trieEntry &a, const trieEntry &b) {
+  if (a.prio != b.prio) return a.prio < b.prio;
+  if (a.text.size() != b.text.size()) return a.text.size() > b.text.size();
+  if (a.text != b.text) return a.text > b.text;
+  return a.word < b.word;
+}
+
+/* Appends to out the (at most) k strings starting with prefix that have
+ * the highest counts, in order. */
+void trieTop(const struct trie *t, const char *prefix, int len, int k,
+             std::vector<std::string> *out) {
+  uint32_t n = 0;
+  for (int i = 0; i < len; i++) {
+    n = trieFind(t, n, prefix[i]);
+    if (n == 0) return;
+  }
+
+  typedef bool (*order)(const trieEntry &, const trieEntry &);
+  std::priority_queue<trieEntry, std::vector<trieEntry>, order> queue(trieAfter);
+  queue.push({t->nodes[n].best, 0, n, std::string(prefix, len)});
+  int found = 0;
+  while (!queue.empty() && found < k) {
+    trieEntry e = queue.top();
+    queue.pop();
+    if (e.prio <= 0) break;
+    if (e.word) {
+      out->push_back(std::move(e.text));
+      found++;
+      continue;
+    }
+    const trieNode &node = t->nodes[e.node];
+    if (node.count > 0) queue.push({node.count, 1, e.node, e.text});
+    for (uint32_t c = node.child; c; c = t->nodes[c].next)
+      queue.push({t->nodes[c].best, 0, c, e.text + (char)t->bytes[c]});
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*** counted trie ***/
+
+/* A trie of byte strings, each with a reference count. Nodes live in one
+ * vector and link to their first child and next sibling (siblings sorted
+ * by byte, which is kept apart in bytes), so a node is 16 bytes and
+ * indexes stay valid as the vector grows; nodes left with no words below
+ * are unlinked and reused through freelist. words counts the strings
+ * whose count is positive. best is
+ * the highest count in a node's subtree, which lets trieTop find the most
+ * common completions of a prefix best-first, visiting little more than
+ * the nodes on their paths. Node 0 is the root; link 0 means none. */
+struct trieNode {
+  uint32_t child;
+  uint32_t next;
+  int count;
+  int best;
+};
+
+struct trie {
+  std::vector<trieNode> nodes;
+  std::vector<unsigned char> bytes;
+  uint32_t freelist;
+  long long words;
+};
+
+void trieInit(struct trie *t);
+void trieAdd(struct trie *t, const char *s, int len, int delta);
+int trieCount(const struct trie *t, const char *s, int len);
+void trieTop(const struct trie *t, const char *prefix, int len, int k,
+             std::vector<std::string> *out);
@@ -0,0 +1,173 @@
+#include "Utf8.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Returns the length of the run of ASCII bytes at the start of s, checking
+ * 16 (or 8) bytes at a time. */
+static size_t asciiPrefix(const char *s, size_t len) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    int mask = _mm_movemask_epi8(v);
+    if (mask) return i + __builtin_ctz(mask);
+  }
+#else
+  for (; i + 8 <= len; i += 8) {
+    uint64_t v;
+    memcpy(&v, s + i, 8);
+    if (v & 0x8080808080808080ULL) break;
+  }
+#endif
+  while (i < len && !((unsigned char)s[i] & 0x80)) i++;
+  return i;
+}
+
+int utf8IsAscii(const char *s, size_t len) {
+  return asciiPrefix(s, len) == len;
+}
+
+/* Length of the well-formed sequence at s (1-4), or 0 if it is not one. */
+static int sequenceLength(const unsigned char *s, size_t len) {
+  unsigned char c = s[0];
+  if (c < 0x80) return 1;
+  if (c < 0xC2) return 0;
+
+  int n;
+  unsigned char lo = 0x80, hi = 0xBF;
+  if (c < 0xE0) {
+    n = 2;
+  } else if (c < 0xF0) {
+    n = 3;
+    if (c == 0xE0) lo = 0xA0;
+    if (c == 0xED) hi = 0x9F;
+  } else if (c < 0xF5) {
+    n = 4;
+    if (c == 0xF0) lo = 0x90;
+    if (c == 0xF4) hi = 0x8F;
+  } else {
+    return 0;
+  }
+
+  if ((size_t)n > len) return 0;
+  if (s[1] < lo || s[1] > hi) return 0;
+  for (int k = 2; k < n; k++)
+    if (!utf8IsCont(s[k])) return 0;
+  return n;
+}
+
+/* Returns the offset of the first byte that is not part of a well-formed
+ * UTF-8 sequence, or len if s is entirely valid. */
+size_t utf8Validate(const char *s, size_t len) {
+  size_t i = 0;
+  while (i < len) {
+    i += asciiPrefix(s + i, len - i);
+    while (i < len && ((unsigned char)s[i] & 0x80)) {
+      int n = sequenceLength((const unsigned char *)s + i, len - i);
+      if (n == 0) return i;
+      i += n;
+    }
+  }
+  return len;
+}
+
+/* Decodes the code point at s into *cp and returns its length in bytes.
+ * A byte that does not start a well-formed sequence decodes as -1 with
+ * length 1, so callers always make progress. */
+int utf8Decode(const char *s, int len, int *cp) {
+  const unsigned char *u = (const unsigned char *)s;
+  int n = sequenceLength(u, len);
+  switch (n) {
+    case 1: *cp = u[0]; return 1;
+    case 2: *cp = ((u[0] & 0x1F) << 6) | (u[1] & 0x3F); return 2;
+    case 3:
+      *cp = ((u[0] & 0x0F) << 12) | ((u[1] & 0x3F) << 6) | (u[2] & 0x3F);
+      return 3;
+    case 4:
+      *cp = ((u[0] & 0x07) << 18) | ((u[1] & 0x3F) << 12) |
+            ((u[2] & 0x3F) << 6) | (u[3] & 0x3F);
+      return 4;
+  }
+  *cp = -1;
+  return 1;
+}
+
+/*** display width ***/
+
+struct widthRange {
+  int first;
+  int last;
+};
+
+/* Combining marks and format characters, which take no column. */
+static const widthRange zeroWidth[] = {
+  {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+  {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+  {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+  {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0711, 0x0711}, {0x0730, 0x074A},
+  {0x07A6, 0x07B0}, {0x0900, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C},
+  {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0962, 0x0963},
+  {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1AB0, 0x1AFF},
+  {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064},
+  {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+  {0xE0100, 0xE01EF},
+};
+
+/* East Asian Wide and Fullwidth characters, including emoji presentation,
+ * which take two columns. */
+static const widthRange doubleWidth[] = {
+  {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+  {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+  {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+  {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+  {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+  {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+  {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+  {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+  {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+  {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+  {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19},
+  {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+  {0x17000, 0x18AFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004},
+  {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A},
+  {0x1F200, 0x1F202}, {0x1F210, 0x1F23B}, {0x1F240, 0x1F248},
+  {0x1F250, 0x1F251}, {0x1F260, 0x1F265}, {0x1F300, 0x1F320},
+  {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393},
+  {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0},
+  {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F43E}, {0x1F440, 0x1F440},
+  {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D}, {0x1F54B, 0x1F54E},
+  {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596},
+  {0x1F5A4, 0x1F5A4}, {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5},
+  {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6D7},
+  {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7EB},
+  {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF},
+  {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+static int inRanges(const widthRange *ranges, int n, int cp) {
+  if (cp < ranges[0].first || cp > ranges[n - 1].last) return 0;
+  int lo = 0, hi = n - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (cp < ranges[mid].first) hi = mid - 1;
+    else if (cp > ranges[mid].last) lo = mid + 1;
+    else return 1;
+  }
+  return 0;
+}
+
+/* Number of terminal columns a code point occupies. Undecodable bytes
+ * (cp < 0) are shown as a one-column placeholder. */
+int utf8CharWidth(int cp) {
+  if (cp < 0x300) return 1;
+  if (inRanges(zeroWidth, sizeof(zeroWidth) / sizeof(zeroWidth[0]), cp))
+    return 0;
+  if (inRanges(doubleWidth, sizeof(doubleWidth) / sizeof(doubleWidth[0]), cp))
+    return 2;
+  return 1;
+}
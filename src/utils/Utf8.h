@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+/*** utf-8 ***/
+
+/* Byte-level helpers for UTF-8 text. The scanning functions take a
+ * vectorised fast path over runs of ASCII, so pure-ASCII input costs one
+ * pass of wide loads and nothing else. */
+
+inline int utf8IsCont(unsigned char c) { return (c & 0xC0) == 0x80; }
+
+int utf8IsAscii(const char *s, size_t len);
+size_t utf8Validate(const char *s, size_t len);
+int utf8Decode(const char *s, int len, int *cp);
+int utf8CharWidth(int cp);
@@ -0,0 +1,206 @@
+#include "Walker.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+struct ignoreRule {
+  std::string pattern;
+  bool negate;
+  bool dironly;
+  bool anchored;
+};
+
+/* The rules of one directory's ignore files. base is that directory
+ * relative to the root ("" or ending in '/'); parent holds the rules of
+ * the directories above. */
+struct ignoreLayer {
+  std::string base;
+  std::vector<ignoreRule> rules;
+  std::shared_ptr<const ignoreLayer> parent;
+};
+
+struct walkTask {
+  std::string dir;
+  std::string rel;
+  std::shared_ptr<const ignoreLayer> ignores;
+};
+
+struct walkQueue {
+  std::mutex lock;
+  std::deque<walkTask> tasks;
+};
+
+/* pending counts directories queued or being read; the walk is over when
+ * it drops to zero. */
+struct walkShared {
+  std::vector<walkQueue> queues;
+  std::atomic<long> pending;
+  walkVisitFn visit;
+  void *arg;
+  const std::atomic<int> *cancel;
+};
+
+static void loadIgnoreFile(const std::string &path,
+                           std::vector<ignoreRule> *rules) {
+  FILE *fp = fopen(path.c_str(), "r");
+  if (!fp) return;
+
+  char *line = NULL;
+  size_t linecap = 0;
+  ssize_t linelen;
+  while ((linelen = getline(&line, &linecap, fp)) != -1) {
+    std::string s(line, linelen);
+    while (!s.empty() && (s.back() == '\n' || s.back() == '\r' ||
+                          s.back() == ' '))
+      s.pop_back();
+    if (s.empty() || s[0] == '#') continue;
+
+    ignoreRule rule = {"", false, false, false};
+    if (s[0] == '!') {
+      rule.negate = true;
+      s.erase(0, 1);
+    }
+    if (!s.empty() && s.back() == '/') {
+      rule.dironly = true;
+      s.pop_back();
+    }
+    if (s.compare(0, 3, "**/") == 0) s.erase(0, 3);
+    else if (!s.empty() && s[0] == '/') {
+      rule.anchored = true;
+      s.erase(0, 1);
+    }
+    if (s.find('/') != std::string::npos) rule.anchored = true;
+    if (s.empty()) continue;
+    rule.pattern = s;
+    rules->push_back(rule);
+  }
+  free(line);
+  fclose(fp);
+}
+
+/* Whether rel, a path relative to the root whose last component is name,
+ * is ignored. Deeper ignore files override shallower ones and, within a
+ * file, the last matching rule wins. */
+static bool ignored(const ignoreLayer *layer, const std::string &rel,
+                    const char *name, bool isdir) {
+  for (; layer; layer = layer->parent.get()) {
+    const char *sub = rel.c_str() + layer->base.size();
+    for (auto it = layer->rules.rbegin(); it != layer->rules.rend(); ++it) {
+      if (it->dironly && !isdir) continue;
+      int match = it->anchored ?
+        fnmatch(it->pattern.c_str(), sub, FNM_PATHNAME) :
+        fnmatch(it->pattern.c_str(), name, 0);
+      if (match == 0) return !it->negate;
+    }
+  }
+  return false;
+}
+
+static bool walkPop(walkShared *w, int self, walkTask *task) {
+  int n = w->queues.size();
+  for (int k = 0; k < n; k++) {
+    walkQueue &q = w->queues[(self + k) % n];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tasks.empty()) continue;
+    if (k == 0) {
+      *task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+    } else {
+      *task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+static void walkDir(walkShared *w, int self, const walkTask &task) {
+  DIR *dir = opendir(task.dir.c_str());
+  if (!dir) return;
+
+  std::shared_ptr<const ignoreLayer> ignores = task.ignores;
+  std::vector<ignoreRule> rules;
+  loadIgnoreFile(task.dir + "/.gitignore", &rules);
+  loadIgnoreFile(task.dir + "/.ignore", &rules);
+  if (!rules.empty()) {
+    auto layer = std::make_shared<ignoreLayer>();
+    layer->base = task.rel;
+    layer->rules = std::move(rules);
+    layer->parent = task.ignores;
+    ignores = layer;
+  }
+
+  struct dirent *ent;
+  while ((ent = readdir(dir)) != NULL) {
+    const char *name = ent->d_name;
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+    std::string path = task.dir == "." ? name : task.dir + "/" + name;
+
+    int type = ent->d_type;
+    if (type == DT_UNKNOWN) {
+      struct stat st;
+      if (lstat(path.c_str(), &st) == -1) continue;
+      type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_LNK;
+    }
+
+    std::string rel = task.rel + name;
+    if (type == DT_DIR) {
+      if (strcmp(name, ".git") == 0 || ignored(ignores.get(), rel, name, true))
+        continue;
+      w->pending++;
+      walkQueue &q = w->queues[self];
+      std::lock_guard<std::mutex> guard(q.lock);
+      q.tasks.push_back({path, rel + "/", ignores});
+    } else if (type == DT_REG) {
+      if (ignored(ignores.get(), rel, name, false)) continue;
+      w->visit(path.c_str(), w->arg);
+    }
+    if (w->cancel && *w->cancel) break;
+  }
+  closedir(dir);
+}
+
+static void walkWorker(walkShared *w, int self) {
+  walkTask task;
+  while (w->pending > 0) {
+    if (w->cancel && *w->cancel) return;
+    if (walkPop(w, self, &task)) {
+      walkDir(w, self, task);
+      w->pending--;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void walkTree(const char *root, int nthreads, walkVisitFn visit, void *arg,
+              const std::atomic<int> *cancel) {
+  if (nthreads < 1) nthreads = 1;
+  walkShared w;
+  w.queues = std::vector<walkQueue>(nthreads);
+  w.pending = 1;
+  w.visit = visit;
+  w.arg = arg;
+  w.cancel = cancel;
+  w.queues[0].tasks.push_back({root, "", nullptr});
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < nthreads; i++) threads.emplace_back(walkWorker, &w, i);
+  walkWorker(&w, 0);
+  for (std::thread &t : threads) t.join();
+}
+
+int walkThreads() {
+  int n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <atomic>
+
+/*** directory walker ***/
+
+/* Calls visit(path, arg) for every regular file under root, on nthreads
+ * threads at once. Each thread keeps a deque of directories still to be
+ * read: it takes the newest from its own and, once that runs dry, steals
+ * the oldest from another thread, so a single deep subtree is still
+ * spread over every thread. visit runs on whichever thread found the file
+ * and must be safe to call concurrently.
+ *
+ * Symlinks and .git directories are skipped, as is anything excluded by a
+ * .gitignore or .ignore file in its directory or above. Those support
+ * the common subset of gitignore: comments, "!" to re-include, a
+ * trailing "/" for directories only, and patterns anchored by a "/".
+ * Patterns are matched with fnmatch, so "**" is only understood at the
+ * start of one. Setting *cancel stops the walk early. */
+typedef void (*walkVisitFn)(const char *path, void *arg);
+
+void walkTree(const char *root, int nthreads, walkVisitFn visit, void *arg,
+              const std::atomic<int> *cancel);
+int walkThreads();
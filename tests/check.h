@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+#define CHECK(cond)                                                     \
+  do {                                                                  \
+    if (!(cond)) {                                                      \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+              #cond);                                                   \
+      exit(1);                                                          \
+    }                                                                   \
+  } while (0)
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Cursors.h"
+#include "Editor.h"
+#include "Row.h"
+#include "Syntax.h"
+#include "Undo.h"
+#include "check.h"
+
+static void resetEditor(const char *filename) {
+  while (E.numrows) editorDelRow(0);
+  E.cx = E.cy = 0;
+  editorCursorsClear();
+  editorUndoClear();
+  free(E.filename);
+  E.filename = strdup(filename);
+  editorSelectSyntaxHighlight();
+}
+
+static std::vector<std::string> snapshot() {
+  std::vector<std::string> lines;
+  for (int i = 0; i < E.numrows; i++)
+    lines.push_back(std::string(editorRowChars(&E.row[i]), E.row[i].size));
+  return lines;
+}
+
+static std::vector<std::string> snapshotHl() {
+  std::vector<std::string> hl;
+  for (int i = 0; i < E.numrows; i++) {
+    std::string s;
+    for (int j = 0; j < E.row[i].rsize; j++)
+      s += (char)('0' + editorRowHlAt(&E.row[i], j));
+    hl.push_back(s + (E.row[i].hl_open_comment ? "+" : "-"));
+  }
+  return hl;
+}
+
+static std::vector<cursorPos> cursors() {
+  std::vector<cursorPos> all = E.cursors.extra;
+  all.push_back({E.cy, E.cx});
+  std::sort(all.begin(), all.end());
+  return all;
+}
+
+/* Applies an edit at every cursor of a model, one at a time. */
+static void modelEdit(std::vector<std::string> &lines, std::vector<cursorPos> &pos,
+                      int op, char c) {
+  int delta = 0;
+  for (size_t i = 0; i < pos.size(); i++) {
+    if (i > 0 && pos[i].cy != pos[i - 1].cy) delta = 0;
+    std::string &line = lines[pos[i].cy];
+    int cx = pos[i].cx + delta;
+    if (op == 0) {
+      line.insert(cx, 1, c);
+      cx++;
+      delta++;
+    } else if (op == 1 && cx > 0 && pos[i].cx > 0) {
+      line.erase(cx - 1, 1);
+      cx--;
+      delta--;
+    } else if (op == 2 && cx < (int)line.size()) {
+      line.erase(cx, 1);
+      delta--;
+    }
+    pos[i].cx = cx;
+  }
+  std::sort(pos.begin(), pos.end());
+  pos.erase(std::unique(pos.begin(), pos.end()), pos.end());
+}
+
+/* Random batches against a model, checking the highlighting against a
+ * full pass after each, then undoing them all. */
+static void testBatch() {
+  resetEditor("a.c");
+  srand(9);
+  const char *tokens[] = {"int ", "x ", "/*", "*/", "\"s\" ", "12 ", "//", "ab"};
+  for (int i = 0; i < 60; i++) {
+    std::string line;
+    int n = rand() % 8;
+    for (int j = 0; j < n; j++) line += tokens[rand() % 8];
+    editorInsertRow(i, line.data(), line.size());
+  }
+  editorUndoClear();
+
+  std::vector<std::vector<std::string>> history = {snapshot()};
+  std::vector<std::vector<cursorPos>> positions;
+  const char alphabet[] = "ab/*\" 1";
+  for (int step = 0; step < 300; step++) {
+    if (step % 20 == 0) {
+      /* A new set of cursors, a few of them sharing rows. */
+      editorCursorsClear();
+      std::vector<cursorPos> all;
+      for (int k = 0; k < 12; k++) {
+        int cy = rand() % E.numrows;
+        all.push_back({cy, rand() % (E.row[cy].size + 1)});
+      }
+      E.cy = all[0].cy;
+      E.cx = all[0].cx;
+      std::sort(all.begin(), all.end());
+      all.erase(std::unique(all.begin(), all.end()), all.end());
+      for (const cursorPos &p : all)
+        if (!(p.cy == E.cy && p.cx == E.cx)) E.cursors.extra.push_back(p);
+    }
+
+    std::vector<std::string> model = snapshot();
+    std::vector<cursorPos> pos = cursors();
+    positions.push_back(pos);
+    int op = rand() % 3;
+    char c = alphabet[rand() % (sizeof(alphabet) - 1)];
+    modelEdit(model, pos, op, c);
+    if (op == 0) editorCursorsInsert(c);
+    else editorCursorsDelChar(op == 2);
+
+    CHECK(snapshot() == model);
+    CHECK(cursors() == pos);
+    std::vector<std::string> batched = snapshotHl();
+    for (int i = 0; i < E.numrows; i++) editorUpdateSyntax(&E.row[i]);
+    CHECK(batched == snapshotHl());
+    if (snapshot() != history.back()) history.push_back(snapshot());
+    else positions.pop_back();
+  }
+
+  /* Each batch is one record, and undoing it restores every cursor. */
+  CHECK(E.undo.records.size() == history.size() - 1);
+  while (history.size() > 1) {
+    history.pop_back();
+    editorUndo();
+    CHECK(snapshot() == history.back());
+    CHECK(cursors() == positions.back());
+    positions.pop_back();
+    std::vector<std::string> undone = snapshotHl();
+    for (int i = 0; i < E.numrows; i++) editorUpdateSyntax(&E.row[i]);
+    CHECK(undone == snapshotHl());
+  }
+  CHECK(E.undo.records.empty());
+}
+
+/* Single-cursor commands, including those that split and join rows. */
+static void testUndoSingle() {
+  resetEditor("b.txt");
+  editorInsertRow(0, "hello", 5);
+  editorInsertRow(1, "world", 5);
+  editorUndoClear();
+
+  std::vector<std::vector<std::string>> history = {snapshot()};
+  E.cy = 0;
+  E.cx = 2;
+  editorInsertChar('X');
+  history.push_back(snapshot());
+  editorInsertNewline();
+  history.push_back(snapshot());
+  CHECK(snapshot() == std::vector<std::string>({"heX", "llo", "world"}));
+  E.cy = 2;
+  E.cx = 0;
+  editorDelChar();
+  history.push_back(snapshot());
+  CHECK(snapshot() == std::vector<std::string>({"heX", "lloworld"}));
+  E.cy = 2;
+  E.cx = 0;
+  editorInsertChar('z');
+  history.push_back(snapshot());
+
+  while (history.size() > 1) {
+    history.pop_back();
+    editorUndo();
+    CHECK(snapshot() == history.back());
+  }
+  CHECK(E.cy == 0 && E.cx == 2);
+
+  /* Appended lines are carried over; any other change made outside a
+   * command ends the history. */
+  editorInsertChar('Y');
+  CHECK(E.undo.records.size() == 1);
+  size_t start = 0;
+  size_t len = 3;
+  editorAppendRows("new", &start, &len, 1);
+  CHECK(E.undo.records.size() == 1);
+  editorInsertRow(0, "top", 3);
+  CHECK(E.undo.records.empty());
+}
+
+static void testAdd() {
+  resetEditor("c.txt");
+  for (const char *line : {"foo bar foo", "\tbar", "none", "foo"})
+    editorInsertRow(E.numrows, line, strlen(line));
+  E.cy = 1;
+  E.cx = 0;
+  editorCursorsAddMatches("foo");
+  CHECK(E.cy == 3 && E.cx == 0);
+  CHECK(cursors() == std::vector<cursorPos>({{0, 0}, {0, 8}, {3, 0}}));
+  editorCursorsInsert('_');
+  CHECK(snapshot() == std::vector<std::string>({"_foo bar _foo", "\tbar", "none", "_foo"}));
+
+  /* A column follows the primary cursor's screen column across tabs. */
+  editorCursorsClear();
+  E.cy = 0;
+  E.cx = 9;
+  editorCursorsAddBelow();
+  editorCursorsAddBelow();
+  CHECK(cursors() == std::vector<cursorPos>({{0, 9}, {1, 2}, {2, 4}}));
+  CHECK(E.cy == 2);
+}
+
+static void testLarge() {
+  resetEditor("big.c");
+  std::string text;
+  std::vector<size_t> starts, lens;
+  for (int i = 0; i < 100000; i++) {
+    size_t at = text.size();
+    text += "  total += item_" + std::to_string(i) + "; /* sum */";
+    starts.push_back(at);
+    lens.push_back(text.size() - at);
+  }
+  editorAppendRows(text.data(), starts.data(), lens.data(), starts.size());
+  editorPrepareRows(E.numrows);
+  E.cy = E.cx = 0;
+  editorCursorsAddMatches("total");
+  editorCursorsClear();
+  E.cy = 0;
+  E.cx = 2;
+  for (int i = 10; i < E.numrows && (int)E.cursors.extra.size() < 9999; i += 10)
+    E.cursors.extra.push_back({i, 2});
+
+  double worst = 0;
+  for (int k = 0; k < 20; k++) {
+    auto start = std::chrono::steady_clock::now();
+    if (k % 4 == 3) editorCursorsDelChar(0);
+    else editorCursorsInsert("sub"[k % 3]);
+    double secs = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+    worst = std::max(worst, secs);
+  }
+  CHECK(E.cursors.extra.size() == 9999);
+  auto start = std::chrono::steady_clock::now();
+  editorUndo();
+  double undo = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  printf("10k cursors: slowest keystroke %.1fms, undo %.1fms\n",
+         worst * 1000, undo * 1000);
+}
+
+int main() {
+  testBatch();
+  testUndoSingle();
+  testAdd();
+  testLarge();
+  return 0;
+}
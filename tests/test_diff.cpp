@@ -0,0 +1,207 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "Diff.h"
+#include "DiffView.h"
+#include "Editor.h"
+#include "FileIO.h"
+#include "check.h"
+
+/* Checks that the hunks turn a into b, and returns how many lines they
+ * insert and delete. */
+static int applyHunks(const std::vector<uint64_t> &a,
+                      const std::vector<uint64_t> &b,
+                      const std::vector<diffHunk> &hunks) {
+  std::vector<uint64_t> out;
+  int at = 0;
+  int edits = 0;
+  for (const diffHunk &h : hunks) {
+    CHECK(h.alen > 0 || h.blen > 0);
+    CHECK(h.a >= at && h.b - h.a == (int)out.size() - at);
+    out.insert(out.end(), a.begin() + at, a.begin() + h.a);
+    out.insert(out.end(), b.begin() + h.b, b.begin() + h.b + h.blen);
+    at = h.a + h.alen;
+    edits += h.alen + h.blen;
+  }
+  out.insert(out.end(), a.begin() + at, a.end());
+  CHECK(out == b);
+  return edits;
+}
+
+static int lcs(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) {
+  std::vector<std::vector<int>> t(a.size() + 1, std::vector<int>(b.size() + 1));
+  for (size_t i = 1; i <= a.size(); i++)
+    for (size_t j = 1; j <= b.size(); j++)
+      t[i][j] = a[i - 1] == b[j - 1] ? t[i - 1][j - 1] + 1 :
+                std::max(t[i - 1][j], t[i][j - 1]);
+  return t[a.size()][b.size()];
+}
+
+static void testMinimal() {
+  srand(11);
+  std::vector<diffHunk> hunks;
+  for (int round = 0; round < 2000; round++) {
+    std::vector<uint64_t> a(rand() % 40), b;
+    for (uint64_t &x : a) x = rand() % 4;
+    b = a;
+    for (int e = rand() % 8; e > 0; e--) {
+      int at = rand() % (b.size() + 1);
+      if (rand() % 2 && at < (int)b.size()) b.erase(b.begin() + at);
+      else b.insert(b.begin() + at, rand() % 5);
+    }
+    if (round % 10 == 0) {
+      b.resize(rand() % 30);
+      for (uint64_t &x : b) x = rand() % 3;
+    }
+    diffLines(a.data(), a.size(), b.data(), b.size(), &hunks);
+    int edits = applyHunks(a, b, hunks);
+    CHECK(edits == (int)(a.size() + b.size()) - 2 * lcs(a, b));
+  }
+}
+
+static void testLarge() {
+  std::vector<uint64_t> a(1000000), b;
+  for (size_t i = 0; i < a.size(); i++) a[i] = i * 2654435761ULL;
+  b = a;
+  srand(3);
+  for (int e = 0; e < 300; e++) {
+    size_t at = rand() % b.size();
+    switch (e % 3) {
+      case 0: b[at] ^= 1; break;
+      case 1: b.erase(b.begin() + at); break;
+      case 2: b.insert(b.begin() + at, 7); break;
+    }
+  }
+
+  std::vector<diffHunk> hunks;
+  auto start = std::chrono::steady_clock::now();
+  diffLines(a.data(), a.size(), b.data(), b.size(), &hunks);
+  double secs = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  printf("1M lines, 300 edits: %zu hunks in %.3fs\n", hunks.size(), secs);
+  CHECK(applyHunks(a, b, hunks) <= 400);
+}
+
+static void writeFile(const std::string &path, const std::string &text) {
+  FILE *fp = fopen(path.c_str(), "wb");
+  CHECK(fp && fwrite(text.data(), 1, text.size(), fp) == text.size());
+  fclose(fp);
+}
+
+static void testMarks() {
+  char path[] = "/tmp/bw-diff-XXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd != -1);
+  close(fd);
+  writeFile(path, "one\ntwo\nthree\nfour\nfive\n");
+  editorOpen(path);
+  editorToggleDiff();
+  CHECK(E.diff.hunks == 0 && E.diff.marks.size() == 6);
+
+  /* Edits mark their own rows at once and leave the diff for later. */
+  editorRowInsertChar(&E.row[1], 0, 'x');
+  editorDelRow(3);
+  editorInsertRow(4, "six", 3);
+  CHECK(E.diff.stale && editorIdleTimeout() == DIFF_IDLE_MS);
+  CHECK(E.diff.hunks == 0);
+  CHECK(E.diff.marks[1] == DIFF_CHANGED && E.diff.marks[4] == DIFF_ADDED);
+  CHECK(E.diff.marks[3] == DIFF_REMOVED);
+  editorDiffIdle();
+  CHECK(!E.diff.stale && editorIdleTimeout() == -1);
+  CHECK(E.diff.hunks == 3);
+  CHECK(E.diff.marks[0] == 0 && E.diff.marks[1] == DIFF_CHANGED);
+  CHECK(E.diff.marks[3] == DIFF_REMOVED && E.diff.marks[4] == DIFF_ADDED);
+  CHECK(E.diff.added == 2 && E.diff.removed == 2);
+
+  /* Undoing an edit by hand is only noticed by the diff. */
+  editorRowDelChar(&E.row[1], 0);
+  CHECK(E.diff.marks[1] == DIFF_CHANGED);
+  editorDiffIdle();
+  CHECK(E.diff.marks[1] == 0 && E.diff.hunks == 2);
+
+  /* Once saved there is nothing left to show. */
+  editorSave();
+  editorDiffIdle();
+  CHECK(E.diff.hunks == 0);
+
+  /* A change made elsewhere is seen through the file watch. */
+  writeFile(path, "one\ntwo\nthree\nfive\nsix\nseven\n");
+  CHECK(E.watch.fd != -1);
+  editorFileEvent(0);
+  CHECK(E.diff.diskstale);
+  editorDiffIdle();
+  CHECK(E.diff.hunks == 1 && E.diff.removed == 1 && E.diff.marks[5] == DIFF_REMOVED);
+  editorToggleDiff();
+  CHECK(!E.diff.on);
+
+  editorCloseFile();
+  if (E.watch.fd != -1) close(E.watch.fd);
+  E.watch.fd = E.watch.dirwd = -1;
+  unlink(path);
+}
+
+/* The file is hashed a chunk at a time; lines that straddle chunks,
+ * including one longer than a chunk, hash as they would whole. */
+static void testDiskChunks() {
+  char path[] = "/tmp/bw-diff-XXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd != -1);
+  close(fd);
+  std::string text;
+  for (int i = 0; text.size() < (1 << 20) + 5000; i++)
+    text += std::string(i % 97, 'a' + i % 26) + (i % 7 ? "\n" : "\r\n");
+  text += std::string(3 << 20, 'z') + "\n";
+  for (int i = 0; i < 1000; i++) text += "tail " + std::to_string(i) + "\n";
+  text += "no newline";
+  writeFile(path, text);
+
+  std::vector<uint64_t> expect;
+  editorSplitLines(text.data(), text.size(), [&](size_t at, size_t len) {
+    expect.push_back(editorDiffHash(text.data() + at, len));
+  });
+  editorOpen(path);
+  editorToggleDiff();
+  CHECK(E.diff.disk == expect);
+  CHECK(E.diff.hunks == 0);
+  editorToggleDiff();
+
+  editorCloseFile();
+  unlink(path);
+}
+
+/* The row hashes are kept with the diff hidden, and a changed row is
+ * only rehashed when they are next wanted. */
+static void testRowHashes() {
+  const char *lines[] = {"alpha", "beta", "gamma"};
+  for (int i = 0; i < 3; i++) editorInsertRow(i, lines[i], strlen(lines[i]));
+  CHECK(!E.diff.on && E.diff.rows.size() == 3 && E.diff.rows[1] == 0);
+  editorDiffRowHashes();
+  for (int i = 0; i < 3; i++)
+    CHECK(E.diff.rows[i] == editorDiffHash(lines[i], strlen(lines[i])));
+
+  editorRowInsertChar(&E.row[1], 4, 's');
+  editorDelRow(0);
+  CHECK(E.diff.rows.size() == 2 && E.diff.rows[0] == 0);
+  CHECK(E.diff.rows[1] == editorDiffHash("gamma", 5));
+  CHECK(editorDiffRowHashes()[0] == editorDiffHash("betas", 5));
+  editorCloseFile();
+}
+
+int main() {
+  E.watch.fd = E.watch.dirwd = E.watch.filewd = -1;
+  E.wakefd = -1;
+  E.follow.fd = -1;
+  setenv("BYTE_WRITER_NO_CACHE", "1", 1);
+
+  testMinimal();
+  testLarge();
+  testMarks();
+  testDiskChunks();
+  testRowHashes();
+  return 0;
+}
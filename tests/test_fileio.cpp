@@ -0,0 +1,426 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "Row.h"
+#include "Undo.h"
+#include "check.h"
+
+static std::string readFile(const char *path) {
+  std::string out;
+  FILE *fp = fopen(path, "rb");
+  CHECK(fp);
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) out.append(buf, n);
+  fclose(fp);
+  return out;
+}
+
+static void closeFile() {
+  while (E.numrows) editorDelRow(E.numrows - 1);
+  editorMapClose();
+  E.cx = E.cy = 0;
+}
+
+static void writeFile(const std::string &path, const std::string &text) {
+  FILE *fp = fopen(path.c_str(), "wb");
+  CHECK(fp && fwrite(text.data(), 1, text.size(), fp) == text.size());
+  fclose(fp);
+}
+
+static void checkRows(const std::string &text) {
+  size_t start = 0;
+  int at = 0;
+  while (start < text.size()) {
+    size_t nl = text.find('\n', start);
+    std::string line = text.substr(start, nl - start);
+    while (!line.empty() && line.back() == '\r') line.pop_back();
+    CHECK(at < E.numrows);
+    CHECK(E.row[at].size == (int)line.size());
+    for (int j = 0; j < E.row[at].size; j++)
+      CHECK(editorRowCharAt(&E.row[at], j) == line[j]);
+    at++;
+    if (nl == std::string::npos) break;
+    start = nl + 1;
+  }
+  CHECK(at == E.numrows);
+  CHECK(editorDocumentSize() == (long long)text.size() ||
+        text.find('\r') != std::string::npos);
+}
+
+static void testSidecarReopen(const char *dir) {
+  std::string path = std::string(dir) + "/big.c";
+  std::string text;
+  for (int i = 0; text.size() < 2 * BYTE_WRITER_SIDECAR_MIN; i++) {
+    text += "int line" + std::to_string(i) + " = " + std::to_string(i * 7);
+    text += (i % 5 == 0) ? "; /* open\n" : (i % 5 == 1) ? "*/\r\n" : ";\n";
+  }
+  FILE *fp = fopen(path.c_str(), "wb");
+  CHECK(fp && fwrite(text.data(), 1, text.size(), fp) == text.size());
+  fclose(fp);
+
+  /* The first open scans the file and writes the index. */
+  editorOpen(path.c_str());
+  CHECK(E.map == NULL);
+  CHECK(E.hlrows == E.numrows);
+  checkRows(text);
+  unsigned char hl = editorRowHlAt(&E.row[1], 0);
+  closeFile();
+
+  /* The second borrows every row from a copy of the file, and neither
+   * prepares nor reads any until they are shown. */
+  editorOpen(path.c_str());
+  CHECK(E.map != NULL);
+  CHECK(E.hlrows == 0);
+  CHECK(E.row[0].borrowed && E.row[E.numrows - 1].borrowed);
+  for (unsigned char ready : E.mapready) CHECK(!ready);
+  editorPrepareRows(2);
+  CHECK(E.hlrows == 2);
+  CHECK(editorRowHlAt(&E.row[1], 0) == hl);
+  CHECK(E.row[1].borrowed);
+  CHECK(E.mapready[0] && !E.mapready.back());
+  checkRows(text);
+
+  /* Editing copies the row out of the file; saving replaces the file. */
+  int last = E.numrows - 1;
+  editorRowInsertChar(&E.row[last], 0, 'X');
+  CHECK(!E.row[last].borrowed);
+  CHECK(E.hlrows == E.numrows);
+  editorSave();
+  CHECK(E.dirty == 0);
+
+  std::string saved = readFile(path.c_str());
+  size_t lastStart = text.rfind('\n', text.size() - 2) + 1;
+  std::string expect = text.substr(0, lastStart) + "X" + text.substr(lastStart);
+  /* CRs are not kept, so compare line by line. */
+  closeFile();
+  editorOpen(path.c_str());
+  CHECK(E.map != NULL);
+  checkRows(expect);
+  CHECK(saved.size() <= expect.size());
+  closeFile();
+
+  /* Truncating the file in place (as logrotate's copytruncate does)
+   * leaves the rows already read unchanged, and the rest read as '?'
+   * rather than faulting. */
+  editorOpen(path.c_str());
+  editorPrepareRows(2);
+  CHECK(truncate(path.c_str(), 0) == 0);
+  for (int j = 0; j < E.row[0].size; j++)
+    CHECK(editorRowCharAt(&E.row[0], j) == expect[j]);
+  erow *lastRow = &E.row[E.numrows - 1];
+  CHECK(lastRow->size > 0);
+  for (int j = 0; j < lastRow->size; j++)
+    CHECK(editorRowCharAt(lastRow, j) == '?');
+  closeFile();
+
+  unlink(path.c_str());
+}
+
+static void appendFile(const std::string &path, const std::string &text) {
+  FILE *fp = fopen(path.c_str(), "ab");
+  CHECK(fp && fwrite(text.data(), 1, text.size(), fp) == text.size());
+  fclose(fp);
+}
+
+static void testFollow(const char *dir) {
+  std::string path = std::string(dir) + "/service.log";
+  std::string text = "first\nsecond\npartial";
+  FILE *fp = fopen(path.c_str(), "wb");
+  CHECK(fp && fwrite(text.data(), 1, text.size(), fp) == text.size());
+  fclose(fp);
+
+  editorOpen(path.c_str());
+  CHECK(E.numrows == 3);
+  E.cy = 2;
+  editorToggleFollow();
+  CHECK(E.follow.fd != -1 && E.follow.partial);
+
+  /* The unfinished line is completed, and a CRLF ending is stripped. */
+  appendFile(path, " line\r\nthird\n");
+  text += " line\r\nthird\n";
+  editorFollowRead();
+  checkRows(text);
+  CHECK(!E.follow.partial);
+  CHECK(E.cy == E.numrows - 1);
+  CHECK(E.dirty == 0);
+
+  /* Appended rows are left unprepared until they are shown. */
+  int hlrows = E.hlrows;
+  std::string burst;
+  for (int i = 0; burst.size() < 3 * (1 << 20); i++)
+    burst += "line " + std::to_string(i) + "\tvalue\n";
+  appendFile(path, burst + "tail");
+  text += burst + "tail";
+  editorFollowRead();
+  checkRows(text);
+  CHECK(E.follow.partial);
+  CHECK(E.hlrows == hlrows);
+  editorPrepareRows(E.numrows);
+  CHECK(E.row[E.numrows - 2].tabs == 1 && E.row[E.numrows - 2].render);
+
+  editorToggleFollow();
+  CHECK(E.follow.fd == -1 && E.watch.filewd == -1);
+  closeFile();
+  unlink(path.c_str());
+}
+
+/* A log rotated by copytruncate: the followed file, whose rows are
+ * borrowed, is cut short and starts over. */
+static void testFollowTruncate(const char *dir) {
+  std::string path = std::string(dir) + "/rotated.log";
+  std::string text;
+  for (int i = 0; text.size() < 2 * BYTE_WRITER_SIDECAR_MIN; i++)
+    text += "request " + std::to_string(i) + " ok\n";
+  writeFile(path, text);
+  editorOpen(path.c_str());
+  closeFile();
+  editorOpen(path.c_str());
+  CHECK(E.map != NULL && E.row[0].borrowed);
+  editorToggleFollow();
+  CHECK(E.follow.fd != -1);
+
+  CHECK(truncate(path.c_str(), 0) == 0);
+  appendFile(path, "request 0 ok\nrestarted\n");
+  editorFileEvent(1);
+  CHECK(E.follow.fd == -1);
+  checkRows("request 0 ok\nrestarted\n");
+  CHECK(E.dirty == 0);
+
+  closeFile();
+  unlink(path.c_str());
+}
+
+static std::string joinLines(const std::vector<std::string> &lines) {
+  std::string text;
+  for (const std::string &line : lines) text += line + "\n";
+  return text;
+}
+
+static void testReload(const char *dir) {
+  std::string path = std::string(dir) + "/reload.c";
+  std::vector<std::string> lines;
+  for (int i = 0; lines.size() < 60000; i++)
+    lines.push_back("int v" + std::to_string(i) + " = " + std::to_string(i % 97) +
+                    ((i % 11 == 0) ? "; /* note" : (i % 11 == 1) ? "*/" : ";"));
+  writeFile(path, joinLines(lines));
+  editorOpen(path.c_str());
+  closeFile();
+  editorOpen(path.c_str());
+  CHECK(E.map != NULL);
+  editorPrepareRows(100);
+  E.cy = 50000;
+  E.cx = 3;
+
+  /* Another program replaces the file with a few lines changed. */
+  lines[10] = "/* edited";
+  lines.erase(lines.begin() + 20000, lines.begin() + 20005);
+  lines.insert(lines.begin() + 40000, {"new 1", "", "new 3"});
+  lines.back() = "last";
+  std::string cursorLine = lines[49998];
+  writeFile(path + ".tmp", joinLines(lines));
+  CHECK(rename((path + ".tmp").c_str(), path.c_str()) == 0);
+  editorFileEvent(1);
+  checkRows(joinLines(lines));
+  CHECK(E.dirty == 0);
+  CHECK(E.cy == 49998 && E.cx == 3);
+  CHECK(std::string(editorRowChars(&E.row[E.cy]), E.row[E.cy].size) == cursorLine);
+  CHECK(!E.row[10].borrowed && E.row[11].borrowed && E.row[0].borrowed);
+  CHECK(E.row[E.numrows - 2].borrowed && !E.row[E.numrows - 1].borrowed);
+  CHECK(E.hlrows == 100);
+  CHECK(editorRowHlAt(&E.row[11], 0) == HL_MLCOMMENT);
+  /* The reloaded lines keep the hashes they were diffed by. */
+  for (uint64_t h : E.diff.rows) CHECK(h != 0);
+
+  /* Unchanged files, including our own saves, are not reloaded. */
+  CHECK(editorReload() == 0);
+  editorRowInsertChar(&E.row[0], 0, 'x');
+  editorSave();
+  lines[0] = "x" + lines[0];
+  editorFileEvent(1);
+  CHECK(editorReload() == 0);
+  checkRows(joinLines(lines));
+
+  /* Commands made before a reload can still be undone; rows below the
+   * reloaded lines are found where they moved to. */
+  editorUndoBegin();
+  editorRowInsertChar(&E.row[100], 0, 'a');
+  editorUndoEnd();
+  editorUndoBegin();
+  editorRowInsertChar(&E.row[30000], 0, 'b');
+  editorUndoEnd();
+  editorSave();
+  std::vector<std::string> saved = lines;
+  saved[100] = "a" + saved[100];
+  saved[30000] = "b" + saved[30000];
+  lines = saved;
+  lines.insert(lines.begin() + 20000, {"inserted 1", "inserted 2"});
+  lines[200] = "elsewhere";
+  writeFile(path + ".tmp", joinLines(lines));
+  CHECK(rename((path + ".tmp").c_str(), path.c_str()) == 0);
+  editorFileEvent(1);
+  checkRows(joinLines(lines));
+  CHECK(E.undo.records.size() == 2);
+  editorUndo();
+  editorUndo();
+  lines[100].erase(0, 1);
+  lines[30002].erase(0, 1);
+  checkRows(joinLines(lines));
+
+  /* A reload that replaces an edited line drops that command and every
+   * one before it. */
+  editorUndoBegin();
+  editorRowInsertChar(&E.row[10], 0, 'c');
+  editorUndoEnd();
+  editorUndoBegin();
+  editorRowInsertChar(&E.row[20], 0, 'd');
+  editorUndoEnd();
+  editorUndoBegin();
+  editorRowInsertChar(&E.row[30], 0, 'e');
+  editorUndoEnd();
+  editorSave();
+  lines[10] = "c" + lines[10];
+  lines[20] = "over d";
+  lines[30] = "e" + lines[30];
+  writeFile(path + ".tmp", joinLines(lines));
+  CHECK(rename((path + ".tmp").c_str(), path.c_str()) == 0);
+  editorFileEvent(1);
+  checkRows(joinLines(lines));
+  CHECK(E.undo.records.size() == 1);
+  editorUndo();
+  lines[30].erase(0, 1);
+  checkRows(joinLines(lines));
+  CHECK(E.undo.records.empty());
+  editorSave();
+
+  /* A rewrite in place leaves the rows already read alone, so only the
+   * changed lines are replaced. */
+  closeFile();
+  editorOpen(path.c_str());
+  CHECK(E.map != NULL);
+  checkRows(joinLines(lines));
+  lines[500] = "changed";
+  writeFile(path, joinLines(lines));
+  editorFileEvent(1);
+  CHECK(E.map != NULL);
+  CHECK(!E.row[500].borrowed && E.row[501].borrowed);
+  checkRows(joinLines(lines));
+
+  /* Text not yet read is overwritten with the file, so then every row is
+   * replaced. */
+  closeFile();
+  editorOpen(path.c_str());
+  closeFile();
+  editorOpen(path.c_str());
+  CHECK(E.map != NULL);
+  lines[501] = "changed again";
+  writeFile(path, joinLines(lines));
+  editorFileEvent(1);
+  CHECK(E.map == NULL);
+  checkRows(joinLines(lines));
+
+  /* Unsaved changes win over the file, and the rows still read as they
+   * did however the file was cut. */
+  editorRowInsertChar(&E.row[1], 0, 'y');
+  lines[1] = "y" + lines[1];
+  writeFile(path, "short\n");
+  CHECK(editorReload() == -1);
+  CHECK(E.dirty);
+  checkRows(joinLines(lines));
+  CHECK(editorReload() == 0);
+
+  E.dirty = 0;
+  closeFile();
+  unlink(path.c_str());
+}
+
+/* Saving writes the rows in chunks; a row longer than a chunk is written
+ * on its own between them. */
+static void testSaveChunks(const char *dir) {
+  std::string path = std::string(dir) + "/chunks.txt";
+  std::string text;
+  for (int i = 0; i < 50000; i++) text += "short " + std::to_string(i) + "\n";
+  std::string longRow(3 << 20, 'x');
+  free(E.filename);
+  E.filename = strdup(path.c_str());
+  editorSplitLines(text.data(), text.size(), [&](size_t at, size_t linelen) {
+    editorInsertRow(E.numrows, text.data() + at, linelen);
+  });
+  editorInsertRow(100, longRow.data(), longRow.size());
+  editorInsertRow(101, "", 0);
+  editorSave();
+  CHECK(E.dirty == 0);
+  std::string expect = text;
+  size_t at = 0;
+  for (int i = 0; i < 100; i++) at = expect.find('\n', at) + 1;
+  expect.insert(at, longRow + "\n\n");
+  CHECK(readFile(path.c_str()) == expect);
+
+  /* Closing the file hands the arena's chunks back. */
+  CHECK(E.arena.nchunks > 0);
+  editorCloseFile();
+  CHECK(E.arena.nchunks == 0 && E.arena.inuse == 0);
+  unlink(path.c_str());
+}
+
+static void testHex(const char *dir) {
+  std::string path = std::string(dir) + "/blob.bin";
+  std::string data;
+  for (int i = 0; data.size() < 3 * HEX_WINDOW; i++) data += (char)(i * 7);
+  data += "\r\n";
+  data += '\0';
+  writeFile(path, data);
+
+  CHECK(editorHexOpen(path.c_str()) == 0);
+  CHECK(E.hex.size == (off_t)data.size());
+  for (size_t i = 0; i < data.size(); i += 4099)
+    CHECK(editorHexByte(i) == (unsigned char)data[i]);
+  CHECK(editorHexByte(data.size() - 3) == '\r');
+  CHECK(editorHexByte(data.size()) == -1);
+
+  /* Edits stay in page copies until saved; only their pages are written. */
+  size_t far = 2 * HEX_WINDOW + 10;
+  editorHexSetByte(5, 0xAB);
+  editorHexSetByte(far, 0xCD);
+  CHECK(E.hex.pages.size() == 2 && E.hex.dirty);
+  CHECK(editorHexByte(5) == 0xAB && editorHexByte(far) == 0xCD);
+  CHECK(readFile(path.c_str()) == data);
+  CHECK(editorHexSave() == 0);
+  CHECK(E.hex.pages.empty() && !E.hex.dirty);
+  data[5] = (char)0xAB;
+  data[far] = (char)0xCD;
+  CHECK(readFile(path.c_str()) == data);
+  CHECK(editorHexByte(far) == 0xCD);
+
+  editorHexClose();
+  free(E.filename);
+  E.filename = NULL;
+  unlink(path.c_str());
+}
+
+int main() {
+  char dir[] = "/tmp/bw-fileio-XXXXXX";
+  CHECK(mkdtemp(dir));
+  setenv("XDG_CACHE_HOME", dir, 1);
+  unsetenv("BYTE_WRITER_NO_CACHE");
+  E.watch.fd = E.watch.dirwd = E.watch.filewd = -1;
+  E.wakefd = -1;
+  E.follow.fd = -1;
+
+  testSidecarReopen(dir);
+  testFollow(dir);
+  testFollowTruncate(dir);
+  testReload(dir);
+  testSaveChunks(dir);
+  testHex(dir);
+
+  std::string cmd = std::string("rm -rf ") + dir;
+  CHECK(system(cmd.c_str()) == 0);
+  return 0;
+}
@@ -0,0 +1,178 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "Plugin.h"
+#include "Row.h"
+#include "Terminal.h"
+#include "check.h"
+
+static std::vector<std::vector<bw_event>> batches;
+static std::vector<std::string> seen;
+static const bw_host *host;
+
+static void onEvents(const bw_event *ev, int n, const bw_host *h) {
+  host = h;
+  batches.push_back(std::vector<bw_event>(ev, ev + n));
+  seen.clear();
+  for (int i = 0; i < h->numrows(); i++) {
+    bw_row row = h->row(i);
+    seen.push_back(std::string(row.chars, row.len));
+  }
+}
+
+static const bw_plugin recorder = {
+  BW_PLUGIN_ABI, "recorder", BW_EV_EDIT | BW_EV_SAVE, onEvents, NULL
+};
+
+static void resetBuffer() {
+  editorCloseFile();
+  editorRefreshScreen();
+  batches.clear();
+}
+
+static int isEvent(const bw_event &ev, int type, int kind, int row, int count) {
+  return ev.type == type && ev.kind == kind && ev.row == row &&
+         ev.count == count;
+}
+
+static void testUnsubscribed() {
+  CHECK(E.plugins.events == 0);
+  editorInsertRow(0, "abc", 3);
+  editorRowInsertChar(&E.row[0], 3, 'x');
+  CHECK(E.plugins.queue.empty());
+}
+
+/* A frame's worth of edits arrives as one batch, merged where it can. */
+static void testBatch() {
+  resetBuffer();
+  editorInsertRow(0, "one", 3);
+  editorInsertRow(1, "two", 3);
+  editorInsertRow(2, "three", 5);
+  for (int i = 0; i < 3; i++) editorRowInsertChar(&E.row[1], 3 + i, '!');
+  editorRowInsertChar(&E.row[2], 0, '>');
+  editorRefreshScreen();
+
+  CHECK(batches.size() == 1);
+  const std::vector<bw_event> &b = batches[0];
+  CHECK(b.size() == 2);
+  CHECK(isEvent(b[0], BW_EV_EDIT, BW_EDIT_INSERT, 0, 3));
+  CHECK(isEvent(b[1], BW_EV_EDIT, BW_EDIT_TEXT, 1, 2));
+  CHECK((seen == std::vector<std::string>{"one", "two!!!", ">three"}));
+
+  /* Nothing new, nothing delivered: this plugin takes no frame events. */
+  editorRefreshScreen();
+  CHECK(batches.size() == 1);
+
+  editorDelRow(1);
+  editorDelRow(1);
+  editorDelRow(0);
+  editorRefreshScreen();
+  CHECK(batches.size() == 2);
+  CHECK(batches[1].size() == 1);
+  CHECK(isEvent(batches[1][0], BW_EV_EDIT, BW_EDIT_DELETE, 0, 3));
+  CHECK(seen.empty());
+}
+
+static void testOverflow() {
+  resetBuffer();
+  for (int i = 0; i < 3 * PLUGIN_MAX_EVENTS; i++) editorInsertRow(i, "x", 1);
+  editorRefreshScreen();
+  batches.clear();
+  for (int i = 0; i < 3 * PLUGIN_MAX_EVENTS; i += 2)
+    editorRowInsertChar(&E.row[i], 0, 'y');
+  CHECK(E.plugins.queue.size() == 1);
+  editorRefreshScreen();
+  CHECK(batches.size() == 1 && batches[0].size() == 1);
+  CHECK(isEvent(batches[0][0], BW_EV_EDIT, BW_EDIT_ALL, 0, E.numrows));
+}
+
+static void testSave() {
+  resetBuffer();
+  char path[] = "/tmp/bw-plugin-XXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd != -1);
+  close(fd);
+  E.filename = strdup(path);
+  editorInsertRow(0, "saved", 5);
+  editorSave();
+  editorRefreshScreen();
+  CHECK(batches.size() == 1 && batches[0].size() == 2);
+  CHECK(isEvent(batches[0][1], BW_EV_SAVE, 0, 0, 1));
+  unlink(path);
+}
+
+static int workerRan, mainRan;
+static std::thread::id workerThread;
+
+static void onMain(void *arg) {
+  CHECK(arg == &mainRan);
+  CHECK(std::this_thread::get_id() != workerThread);
+  mainRan = 1;
+}
+
+static void onWorker(void *arg) {
+  workerThread = std::this_thread::get_id();
+  workerRan = (int)(long)arg;
+  host->main(onMain, &mainRan);
+}
+
+/* Refreshes until cond holds or a few seconds pass. */
+template <typename F> static int waitFor(F cond) {
+  for (int i = 0; i < 500 && !cond(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    editorRefreshScreen();
+  }
+  return cond();
+}
+
+static void testWorker() {
+  CHECK(host != NULL);
+  host->post(onWorker, (void *)7L);
+  CHECK(waitFor([] { return mainRan == 1; }));
+  CHECK(workerRan == 7);
+}
+
+/* The example plugin finds trailing whitespace after a file is opened. */
+static void testExample() {
+  char path[] = "/tmp/bw-plugin-XXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd != -1);
+  const char *text = "clean\nspace \nok\ntab\t\n";
+  CHECK(write(fd, text, strlen(text)) == (ssize_t)strlen(text));
+  close(fd);
+
+  CHECK(editorPluginLoad(TRAILING_SPACE_PLUGIN) == 0);
+  CHECK(editorPluginLoad("/nonexistent/plugin.so") == -1);
+  resetBuffer();
+  editorOpen(path);
+  CHECK(waitFor([] { return strstr(E.statusmsg, "trailing-space") != NULL; }));
+  CHECK(strcmp(E.statusmsg,
+               "trailing-space: 2 lines end in whitespace, first is 2") == 0);
+  unlink(path);
+}
+
+int main() {
+  termUseMemory(24, 80);
+  enableRawMode();
+  initEditor();
+  testUnsubscribed();
+  CHECK(editorPluginRegister(&recorder, NULL) == 0);
+  CHECK(E.plugins.events == (BW_EV_EDIT | BW_EV_SAVE));
+  testBatch();
+  testOverflow();
+  testSave();
+  testWorker();
+  testExample();
+  editorPluginsUnload();
+  CHECK(E.plugins.events == 0 && E.plugins.loaded.empty());
+  printf("plugin: all tests passed\n");
+  return 0;
+}
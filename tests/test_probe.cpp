@@ -0,0 +1,115 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "Probe.h"
+#include "Row.h"
+#include "Terminal.h"
+#include "Undo.h"
+#include "check.h"
+
+static void testBuckets() {
+  int last = -1;
+  for (uint64_t v = 0; v < 100000; v++) {
+    int b = probeBucket(v);
+    CHECK(b == last || b == last + 1);
+    CHECK(probeBucketLow(b) <= v && v < probeBucketLow(b + 1));
+    last = b;
+  }
+  for (int e = 4; e < 64; e++) {
+    uint64_t v = 1ULL << e;
+    int b = probeBucket(v);
+    CHECK(probeBucketLow(b) == v);
+    CHECK(probeBucket(v - 1) == b - 1);
+    /* No bucket is wider than an eighth of its lowest value. */
+    CHECK(probeBucketLow(b + 1) - v <= v / 8);
+  }
+  CHECK(probeBucket(UINT64_MAX) == PROBE_BUCKETS - 1);
+}
+
+static void testQuantiles() {
+  probeReset();
+  CHECK(probeQuantile(PROBE_KEY, 0.5) == 0);
+  for (uint64_t v = 1; v <= 10000; v++) probeRecord(PROBE_KEY, v * 1000);
+  CHECK(probeHists[PROBE_KEY].count == 10000);
+  CHECK(probeHists[PROBE_KEY].max == 10000000);
+  uint64_t p50 = probeQuantile(PROBE_KEY, 0.5);
+  uint64_t p99 = probeQuantile(PROBE_KEY, 0.99);
+  CHECK(p50 > 5000000 * 7 / 8 && p50 < 5000000 * 9 / 8);
+  CHECK(p99 > 9900000 * 7 / 8 && p99 <= 10000000);
+  CHECK(probeQuantile(PROBE_KEY, 1) == 10000000);
+}
+
+/* Records from several threads at once lose nothing. */
+static void testThreads() {
+  probeReset();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+    threads.emplace_back([t] {
+      for (int i = 0; i < 100000; i++) probeRecord(PROBE_GREP, i + t);
+    });
+  for (std::thread &t : threads) t.join();
+  CHECK(probeHists[PROBE_GREP].count == 400000);
+  CHECK(probeHists[PROBE_GREP].max == 99999 + 3);
+  uint64_t total = 0;
+  for (auto &b : probeHists[PROBE_GREP].buckets) total += b;
+  CHECK(total == 400000);
+}
+
+/* The counters go back to where they were once the rows are gone. */
+static void testMemory() {
+#ifdef BYTE_WRITER_PROBES
+  int64_t before[PROBE_MEM_COUNT];
+  for (int k = 0; k < PROBE_MEM_COUNT; k++) before[k] = probeMem[k];
+
+  std::string line(300, 'x');
+  line[5] = '\t';
+  E.filename = strdup("probe.c");
+  editorSelectSyntaxHighlight();
+  for (int i = 0; i < 1000; i++) editorInsertRow(i, line.data(), line.size());
+  editorPrepareRows(E.numrows);
+  CHECK(probeMem[PROBE_MEM_ROWS] > before[PROBE_MEM_ROWS] + 1000 * 300);
+  CHECK(probeMem[PROBE_MEM_RENDER] > before[PROBE_MEM_RENDER] + 1000 * 300);
+  CHECK(probeMem[PROBE_MEM_HL] > before[PROBE_MEM_HL] + 1000 * 300);
+
+  editorUndoBegin();
+  editorDelRow(0);
+  editorUndoEnd();
+  CHECK(probeMem[PROBE_MEM_UNDO] > before[PROBE_MEM_UNDO] + 300);
+
+  editorCloseFile();
+  for (int k = 0; k < PROBE_MEM_COUNT; k++) {
+    /* The row array is kept for the next file. */
+    int64_t kept = k == PROBE_MEM_ROWS ? (int64_t)sizeof(erow) * E.rowcap : 0;
+    CHECK(probeMem[k] == before[k] + kept);
+  }
+#endif
+}
+
+/* A key that opens a prompt is not timed as a keypress. */
+static void testKeyProbe() {
+#ifdef BYTE_WRITER_PROBES
+  termUseMemory(10, 40);
+  probeReset();
+  for (const char *key : {"a", "b", "\x07", "1", "\r", "c"})
+    termMemoryPush(key);
+  while (termMemoryPending()) editorProcessKeypress();
+  CHECK(probeHists[PROBE_KEY].count == 3);
+  CHECK(E.prompts == 1);
+#endif
+}
+
+int main() {
+  initEditorState();
+  testBuckets();
+  testQuantiles();
+  testThreads();
+  testMemory();
+  testKeyProbe();
+  printf("probe: all tests passed\n");
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "Editor.h"
+#include "FileIO.h"
+#include "Replay.h"
+#include "Row.h"
+#include "Terminal.h"
+#include "check.h"
+
+static std::string rowText(int at) {
+  return std::string(editorRowChars(&E.row[at]), E.row[at].size);
+}
+
+static void testEscape() {
+  std::string all, back;
+  for (int c = 0; c < 256; c++) all += (char)c;
+  std::string line = termEscapeKey(all);
+  CHECK(line.find_first_of(" #\n") == std::string::npos);
+  CHECK(termUnescapeKey(line.c_str(), &back) == 0 && back == all);
+
+  CHECK(termUnescapeKey("\\e[A\n", &back) == 0 && back == "\x1b[A");
+  CHECK(termUnescapeKey("\\r\\t\\\\", &back) == 0 && back == "\r\t\\");
+  CHECK(termUnescapeKey("\\x4", &back) == -1);
+  CHECK(termUnescapeKey("\\q", &back) == -1);
+}
+
+static void testLoad() {
+  char path[] = "/tmp/bw-trace-XXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd != -1);
+  FILE *fp = fdopen(fd, "w");
+  fputs("# a comment\na\n\n\\e[A\n\\x23\n", fp);
+  fclose(fp);
+
+  std::vector<std::string> keys;
+  CHECK(replayLoad(path, &keys) == 0);
+  CHECK((keys == std::vector<std::string>{"a", "\x1b[A", "#"}));
+  unlink(path);
+  CHECK(replayLoad(path, &keys) == -1);
+}
+
+static void testReplay() {
+  std::vector<std::string> keys;
+  for (char c : std::string("hello")) keys.push_back(std::string(1, c));
+  keys.push_back("\r");
+  for (char c : std::string("world")) keys.push_back(std::string(1, c));
+  keys.push_back("\x1b[D");
+  keys.push_back("\x7f");
+  keys.push_back("\x1b");
+  keys.push_back("X");
+  keys.push_back(std::string(1, CTRL_KEY('f')));
+  keys.push_back("w");
+  keys.push_back("\r");
+  keys.push_back(std::string(1, CTRL_KEY('q')));
+  keys.push_back("z");
+
+  std::vector<replayStep> steps;
+  replayRun(keys, &steps);
+  CHECK(E.numrows == 2 && rowText(0) == "hello" && rowText(1) == "worXd");
+  CHECK(steps.size() == 16);
+  CHECK(steps[13].key == "\x1b" && steps[13].keys == 1);
+  CHECK(steps[15].keys == 3);
+  for (const replayStep &s : steps) {
+    CHECK(s.frames >= 1 && s.bytes > 0);
+    CHECK(s.process_us >= 0 && s.frame_us >= 0);
+  }
+  /* The Ctrl-Q and the key after it are left unread. */
+  CHECK(termMemoryPending() == 2);
+  CHECK(termMemoryTakeOutput().find("worXd") != std::string::npos);
+}
+
+/* A trace that ends inside a prompt is backed out of with Esc. */
+static void testTruncated() {
+  editorCloseFile();
+  termUseMemory(10, 40);
+  std::vector<replayStep> steps;
+  replayRun({"a", std::string(1, CTRL_KEY('f')), "a"}, &steps);
+  CHECK(steps.size() == 2 && steps[1].keys == 2);
+  CHECK(E.numrows == 1 && rowText(0) == "a");
+  CHECK(termMemoryPending() == 0);
+}
+
+int main() {
+  testEscape();
+  testLoad();
+  termUseMemory(10, 40);
+  enableRawMode();
+  initEditor();
+  CHECK(E.screenrows == 8 && E.screencols == 40);
+  testReplay();
+  testTruncated();
+  printf("replay: all tests passed\n");
+  return 0;
+}
@@ -1 +1,176 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
+#include "Editor.h"
+#include "FileIO.h"
+#include "Row.h"
+#include "check.h"
+
+static void resetEditor() {
+  while (E.numrows) editorDelRow(0);
+  E.cx = E.cy = 0;
+  E.dirty = 0;
+  E.syntax = NULL;
+}
+
+static std::string expandTabs(const std::string &s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '\t') {
+      out += ' ';
+      while (out.size() % BYTE_WRITER_TAB_STOP != 0) out += ' ';
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+static void checkRow(erow *row, const std::string &model) {
+  CHECK(row->size == (int)model.size());
+  for (int j = 0; j < row->size; j++)
+    CHECK(editorRowCharAt(row, j) == model[j]);
+
+  std::string render = expandTabs(model);
+  CHECK(row->rsize == (int)render.size());
+  for (int j = 0; j < row->rsize; j++)
+    CHECK(editorRowRenderAt(row, j) == render[j]);
+
+  CHECK(model == editorRowChars(row));
+  CHECK(render == editorRowRender(row));
+}
+
+static void testRandomEditsMatchModel(int initial, bool tabs) {
+  resetEditor();
+  std::string model(initial, 'x');
+  editorInsertRow(0, model.data(), model.size());
+
+  srand(initial + tabs);
+  for (int n = 0; n < 4000; n++) {
+    erow *row = &E.row[0];
+    int at = model.empty() ? 0 : rand() % (model.size() + 1);
+    if (rand() % 3 == 0 && at < (int)model.size()) {
+      editorRowDelChar(row, at);
+      model.erase(at, 1);
+    } else {
+      char c = (tabs && rand() % 50 == 0) ? '\t' : 'a' + rand() % 26;
+      editorRowInsertChar(row, at, c);
+      model.insert(model.begin() + at, c);
+    }
+    if (n % 97 == 0) checkRow(row, model);
+  }
+  checkRow(&E.row[0], model);
+}
+
+static void testGapSurvivesSplitAndJoin() {
+  resetEditor();
+  std::string line(2 * ROW_GAP_MIN, 'a');
+  editorInsertRow(0, line.data(), line.size());
+
+  E.cy = 0;
+  E.cx = ROW_GAP_MIN;
+  for (int j = 0; j < 10; j++) editorInsertChar('b');
+  editorInsertNewline();
+  CHECK(E.numrows == 2);
+  CHECK(E.row[0].size == ROW_GAP_MIN + 10);
+  CHECK(E.row[1].size == ROW_GAP_MIN);
+  CHECK(E.cy == 1 && E.cx == 0);
+
+  editorDelChar();
+  CHECK(E.numrows == 1);
+  CHECK(E.cx == ROW_GAP_MIN + 10);
+  std::string model = line;
+  model.insert(ROW_GAP_MIN, 10, 'b');
+  checkRow(&E.row[0], model);
+}
+
+static void testShortRowsStayInline() {
+  resetEditor();
+  size_t inuse = E.arena.inuse;
+  editorInsertRow(0, "", 0);
+  editorInsertRow(1, "short", 5);
+  CHECK(editorRowIsInline(&E.row[0]));
+  CHECK(editorRowIsInline(&E.row[1]));
+
+  std::string model = "short";
+  for (int j = 0; j < 40; j++) {
+    editorRowInsertChar(&E.row[1], 2, '0' + j % 10);
+    model.insert(model.begin() + 2, '0' + j % 10);
+  }
+  CHECK(!editorRowIsInline(&E.row[1]));
+  checkRow(&E.row[1], model);
+
+  resetEditor();
+  CHECK(E.arena.inuse == inuse);
+}
+
+static void testRenderAliasesChars() {
+  resetEditor();
+  editorInsertRow(0, "no tabs here", 12);
+  editorInsertRow(1, "\tindented", 9);
+  CHECK(E.row[0].render == NULL);
+  CHECK(editorRowRender(&E.row[0]) == editorRowChars(&E.row[0]));
+  CHECK(E.row[1].render != NULL);
+  checkRow(&E.row[1], "\tindented");
+
+  editorRowDelChar(&E.row[1], 0);
+  CHECK(E.row[1].render == NULL);
+  checkRow(&E.row[1], "indented");
+}
+
+static void testLineIndex() {
+  resetEditor();
+  std::vector<std::string> model;
+  srand(3);
+  for (int n = 0; n < 3000; n++) {
+    int at = model.empty() ? 0 : rand() % model.size();
+    switch (model.empty() ? 0 : rand() % 4) {
+      case 0: {
+        std::string line(rand() % 40, 'q');
+        editorInsertRow(at, line.data(), line.size());
+        model.insert(model.begin() + at, line);
+        break;
+      }
+      case 1:
+        editorDelRow(at);
+        model.erase(model.begin() + at);
+        break;
+      case 2:
+        editorRowInsertChar(&E.row[at], 0, 'r');
+        model[at].insert(0, 1, 'r');
+        break;
+      case 3:
+        editorRowTruncate(&E.row[at], model[at].size() / 2);
+        model[at].resize(model[at].size() / 2);
+        break;
+    }
+  }
+
+  long long offset = 0;
+  for (size_t i = 0; i < model.size(); i++) {
+    CHECK(editorRowOffset(i) == offset);
+    int cx;
+    CHECK(editorOffsetToRow(offset + model[i].size(), &cx) == (int)i);
+    CHECK(cx == (int)model[i].size());
+    offset += model[i].size() + 1;
+  }
+  CHECK(editorDocumentSize() == offset);
+
+  size_t len;
+  char *buf = editorRowsToString(&len);
+  CHECK(buf && (long long)len == offset);
+  free(buf);
+}
+
+int main() {
+  testRandomEditsMatchModel(10, false);
+  testRandomEditsMatchModel(ROW_GAP_MIN * 4, false);
+  testRandomEditsMatchModel(ROW_GAP_MIN * 4, true);
+  testGapSurvivesSplitAndJoin();
+  testShortRowsStayInline();
+  testRenderAliasesChars();
+  testLineIndex();
+  return 0;
+}
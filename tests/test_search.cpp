@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "Editor.h"
+#include "Finder.h"
+#include "Grep.h"
+#include "Search.h"
+#include "Walker.h"
+#include "check.h"
+
+static void writeFile(const std::string &path, const std::string &text) {
+  FILE *fp = fopen(path.c_str(), "wb");
+  CHECK(fp && fwrite(text.data(), 1, text.size(), fp) == text.size());
+  fclose(fp);
+}
+
+/* Compares searchFind with std::string::find on random text over a small
+ * alphabet, with the haystack in a block of its exact size so that reads
+ * past the end would be caught under a sanitizer. */
+static void testFind() {
+  srand(7);
+  for (int round = 0; round < 2000; round++) {
+    size_t len = rand() % 200;
+    std::string hay;
+    for (size_t i = 0; i < len; i++) hay += "abc"[rand() % 3];
+    size_t nlen = 1 + rand() % 12;
+    std::string needle;
+    if (len > 0 && rand() % 2) {
+      size_t at = rand() % len;
+      needle = hay.substr(at, nlen);
+    } else {
+      for (size_t i = 0; i < nlen; i++) needle += "abc"[rand() % 3];
+    }
+
+    char *buf = (char *)malloc(len ? len : 1);
+    memcpy(buf, hay.data(), len);
+    const char *hit = searchFind(buf, len, needle.data(), needle.size());
+    size_t want = hay.find(needle);
+    if (want == std::string::npos) CHECK(hit == NULL);
+    else CHECK(hit == buf + want);
+    free(buf);
+  }
+  CHECK(searchFind("abc", 3, "", 0) != NULL);
+  CHECK(searchFind("ab", 2, "abc", 3) == NULL);
+}
+
+static std::mutex seenLock;
+
+static void collect(const char *path, void *arg) {
+  std::lock_guard<std::mutex> guard(seenLock);
+  ((std::vector<std::string> *)arg)->push_back(path);
+}
+
+static void makeTree(const std::string &dir) {
+  for (const char *sub : {"/src", "/src/gen", "/build", "/docs", "/.git"})
+    CHECK(mkdir((dir + sub).c_str(), 0755) == 0);
+  writeFile(dir + "/.gitignore", "# build output\n/build/\n*.o\n!keep.o\n");
+  writeFile(dir + "/src/.ignore", "gen/\n");
+  writeFile(dir + "/main.c", "int main() { return needle(); }\n");
+  writeFile(dir + "/main.o", "object\n");
+  writeFile(dir + "/keep.o", "kept\n");
+  writeFile(dir + "/src/a.c", "one\ntwo needle\nthree\nneedle needle\n");
+  writeFile(dir + "/src/gen/b.c", "needle\n");
+  writeFile(dir + "/build/c.c", "needle\n");
+  writeFile(dir + "/docs/readme", "no match here\n");
+  writeFile(dir + "/docs/blob", std::string("needle\0\1\2", 9));
+  writeFile(dir + "/.git/config", "needle\n");
+}
+
+static void testWalk(const std::string &dir) {
+  std::vector<std::string> want = {
+    dir + "/.gitignore", dir + "/docs/blob", dir + "/docs/readme",
+    dir + "/keep.o", dir + "/main.c", dir + "/src/.ignore", dir + "/src/a.c",
+  };
+  for (int threads : {1, 4}) {
+    std::vector<std::string> seen;
+    walkTree(dir.c_str(), threads, collect, &seen, NULL);
+    std::sort(seen.begin(), seen.end());
+    CHECK(seen == want);
+  }
+}
+
+static void testGrep(const std::string &dir) {
+  editorGrepStart(dir.c_str(), "needle");
+  editorGrepWait();
+  CHECK(!E.grep.running);
+  CHECK(E.grep.files == 7);
+
+  std::vector<grepHit> hits = E.grep.hits;
+  std::sort(hits.begin(), hits.end(), [](const grepHit &a, const grepHit &b) {
+    return a.path != b.path ? a.path < b.path : a.line < b.line;
+  });
+  CHECK(hits.size() == 3);
+  CHECK(hits[0].path == dir + "/main.c" && hits[0].line == 1 &&
+        hits[0].col == 20 && hits[0].text == "int main() { return needle(); }");
+  CHECK(hits[1].path == dir + "/src/a.c" && hits[1].line == 2 &&
+        hits[1].col == 4 && hits[1].text == "two needle");
+  CHECK(hits[2].path == dir + "/src/a.c" && hits[2].line == 4 &&
+        hits[2].col == 0);
+
+  editorGrepStart(dir.c_str(), "absent");
+  editorGrepWait();
+  CHECK(E.grep.hits.empty());
+}
+
+static void finderReset() {
+  E.finder.paths.clear();
+  E.finder.text.clear();
+  E.finder.query.clear();
+  E.finder.cur = finderLevel();
+  E.finder.cur.scanned = 0;
+  E.finder.history.clear();
+}
+
+/* Checks candidates and top against scoring every path from scratch. */
+static void checkFinder() {
+  std::vector<std::pair<int, int>> want;
+  for (size_t i = 0; i < E.finder.paths.size(); i++) {
+    int score = editorFinderScore(i, E.finder.cur.query, NULL);
+    if (score != INT_MIN) want.push_back({-score, (int)i});
+  }
+  std::vector<int> cand = E.finder.cur.candidates;
+  std::sort(cand.begin(), cand.end());
+  CHECK(cand.size() == want.size());
+  for (size_t k = 0; k < want.size(); k++) CHECK(cand[k] == want[k].second);
+
+  std::sort(want.begin(), want.end());
+  size_t keep = std::min<size_t>(want.size(), FINDER_TOP);
+  CHECK(E.finder.cur.top.size() == keep);
+  for (size_t k = 0; k < keep; k++) CHECK(E.finder.cur.top[k] == want[k].second);
+}
+
+static std::string randomPath() {
+  static const char *parts[] = {"src", "editor", "Row", "utils", "test",
+                                "Finder", "fileio", "x", "Wrap_view", "a-b"};
+  std::string path;
+  int depth = 1 + rand() % 5;
+  for (int d = 0; d < depth; d++) {
+    if (d) path += '/';
+    path += parts[rand() % 10];
+    if (rand() % 3 == 0) path += std::to_string(rand() % 100);
+  }
+  return path + (rand() % 2 ? ".cpp" : ".h");
+}
+
+static void testFinder(const std::string &dir) {
+  finderReset();
+  for (const char *path : {"docs/find_notes.txt", "src/fixtures/input.cpp",
+                           "src/editor/Finder.cpp", "xfxixnxdxexrx"})
+    editorFinderAdd(path);
+  E.finder.query = "finder";
+  editorFinderUpdate();
+  CHECK(E.finder.cur.top.size() == 2);
+  CHECK(editorFinderPath(E.finder.cur.top[0]) == "src/editor/Finder.cpp");
+  CHECK(editorFinderPath(E.finder.cur.top[1]) == "xfxixnxdxexrx");
+  int pos[2];
+  CHECK(editorFinderScore(0, "fz", pos) == INT_MIN);
+  editorFinderAdd("f/x/Foo");
+  CHECK(editorFinderScore(4, "fo", pos) != INT_MIN && pos[0] == 4 && pos[1] == 5);
+
+  /* Typing, deleting and new paths arriving in between. */
+  finderReset();
+  srand(11);
+  for (int i = 0; i < 20000; i++) editorFinderAdd(randomPath().c_str());
+  const char *typed = "srcedfinrow";
+  for (int round = 0; round < 200; round++) {
+    if (E.finder.query.size() > 0 && rand() % 4 == 0) E.finder.query.pop_back();
+    else E.finder.query += typed[rand() % 11];
+    if (rand() % 5 == 0)
+      for (int i = 0; i < 50; i++) editorFinderAdd(randomPath().c_str());
+    editorFinderUpdate();
+    checkFinder();
+  }
+
+  /* Keystroke latency on a large tree. */
+  finderReset();
+  for (int i = 0; i < 500000; i++) editorFinderAdd(randomPath().c_str());
+  E.finder.query = "";
+  editorFinderUpdate();
+  double worst = 0;
+  for (const char *key : {"e", "d", "r", "o", "w", "\b", "\b", "r", "w"}) {
+    if (key[0] == '\b') E.finder.query.pop_back();
+    else E.finder.query += key;
+    auto start = std::chrono::steady_clock::now();
+    editorFinderUpdate();
+    double secs = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+    worst = std::max(worst, secs);
+  }
+  printf("500k paths: slowest keystroke %.1fms\n", worst * 1000);
+
+  /* Discovery through the walker. */
+  finderReset();
+  editorFinderLoad(dir.c_str());
+  editorFinderWait();
+  CHECK(!E.finder.running && E.finder.paths.size() == 7);
+  E.finder.query = "readme";
+  editorFinderUpdate();
+  CHECK(E.finder.cur.top.size() == 1);
+  CHECK(editorFinderPath(E.finder.cur.top[0]) == dir + "/docs/readme");
+}
+
+int main() {
+  char dir[] = "/tmp/bw-search-XXXXXX";
+  CHECK(mkdtemp(dir));
+  E.wakefd = -1;
+
+  testFind();
+  makeTree(dir);
+  testWalk(dir);
+  testGrep(dir);
+  testFinder(dir);
+
+  std::string cmd = std::string("rm -rf ") + dir;
+  CHECK(system(cmd.c_str()) == 0);
+  return 0;
+}
@@ -1 +1,77 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
+#include "Editor.h"
+#include "Row.h"
+#include "Syntax.h"
+#include "check.h"
+
+static void resetEditor(const char *filename) {
+  while (E.numrows) editorDelRow(0);
+  E.cx = E.cy = 0;
+  free(E.filename);
+  E.filename = strdup(filename);
+  editorSelectSyntaxHighlight();
+}
+
+static std::vector<std::string> snapshotHl() {
+  std::vector<std::string> hl;
+  for (int i = 0; i < E.numrows; i++) {
+    std::string s;
+    for (int j = 0; j < E.row[i].rsize; j++)
+      s += (char)('0' + editorRowHlAt(&E.row[i], j));
+    hl.push_back(s + (E.row[i].hl_open_comment ? "+" : "-"));
+  }
+  return hl;
+}
+
+static void testKeywordsAndComments() {
+  resetEditor("a.c");
+  const char *line = "int x = 42; // done";
+  editorInsertRow(0, line, strlen(line));
+  std::vector<std::string> hl = snapshotHl();
+  CHECK(hl[0] == "4440000066001111111-");
+
+  const char *open = "/* start";
+  editorInsertRow(1, open, strlen(open));
+  editorInsertRow(2, "x", 1);
+  CHECK(E.row[1].hl_open_comment);
+  CHECK(editorRowHlAt(&E.row[2], 0) == HL_MLCOMMENT);
+}
+
+/* Windowed re-highlighting of long rows must agree with highlighting the
+ * whole buffer from scratch after every keystroke. */
+static void testWindowedMatchesFull() {
+  resetEditor("long.c");
+  const char *tokens[] = { "int ", "x1 ", "= ", "12.5", "; ", "\"str\" ",
+                           "/* c */ ", "while", "(", ") ", "'\\'' " };
+  std::string line;
+  while ((int)line.size() < 4 * ROW_GAP_MIN)
+    line += tokens[rand() % (sizeof(tokens) / sizeof(tokens[0]))];
+  editorInsertRow(0, line.data(), line.size());
+  editorInsertRow(1, "return 0;", 9);
+  editorInsertRow(2, "*/ int y;", 9);
+
+  const char alphabet[] = "ab1.\"'\\/* ();";
+  srand(7);
+  for (int n = 0; n < 3000; n++) {
+    erow *row = &E.row[0];
+    int at = rand() % (row->size + 1);
+    if (rand() % 3 == 0 && at < row->size)
+      editorRowDelChar(row, at);
+    else
+      editorRowInsertChar(row, at, alphabet[rand() % (sizeof(alphabet) - 1)]);
+
+    std::vector<std::string> windowed = snapshotHl();
+    for (int i = 0; i < E.numrows; i++) editorUpdateSyntax(&E.row[i]);
+    CHECK(windowed == snapshotHl());
+  }
+}
+
+int main() {
+  testKeywordsAndComments();
+  testWindowedMatchesFull();
+  return 0;
+}
@@ -0,0 +1,128 @@
+#include <cstring>
+#include <string>
+
+#include "Editor.h"
+#include "Row.h"
+#include "Terminal.h"
+#include "Utf8.h"
+#include "check.h"
+
+static void testValidate() {
+  std::string ascii(1000, 'a');
+  CHECK(utf8IsAscii(ascii.data(), ascii.size()));
+  CHECK(utf8Validate(ascii.data(), ascii.size()) == ascii.size());
+
+  std::string mixed = ascii + "h\xc3\xa9llo \xe6\xbc\xa2\xe5\xad\x97 \xf0\x9f\x98\x80";
+  CHECK(!utf8IsAscii(mixed.data(), mixed.size()));
+  CHECK(utf8Validate(mixed.data(), mixed.size()) == mixed.size());
+
+  const char *overlong = "ab\xc0\xaf";
+  CHECK(utf8Validate(overlong, 4) == 2);
+  const char *surrogate = "\xed\xa0\x80";
+  CHECK(utf8Validate(surrogate, 3) == 0);
+  const char *truncated = "x\xe6\xbc";
+  CHECK(utf8Validate(truncated, 3) == 1);
+
+  int cp;
+  CHECK(utf8Decode("\xe6\xbc\xa2", 3, &cp) == 3 && cp == 0x6F22);
+  CHECK(utf8Decode("\xff", 1, &cp) == 1 && cp == -1);
+}
+
+static void testWidths() {
+  CHECK(utf8CharWidth('a') == 1);
+  CHECK(utf8CharWidth(0xE9) == 1);
+  CHECK(utf8CharWidth(0x0301) == 0);
+  CHECK(utf8CharWidth(0x6F22) == 2);
+  CHECK(utf8CharWidth(0xAC00) == 2);
+  CHECK(utf8CharWidth(0x1F600) == 2);
+  CHECK(utf8CharWidth(0x2603) == 1);
+}
+
+static void testRowColumns() {
+  while (E.numrows) editorDelRow(0);
+
+  /* "a" "é" "漢" "b": bytes 0, 1-2, 3-5, 6; columns 0, 1, 2-3, 4. */
+  const char *line = "a\xc3\xa9\xe6\xbc\xa2" "b";
+  editorInsertRow(0, line, strlen(line));
+  erow *row = &E.row[0];
+  CHECK(!row->ascii);
+  CHECK(editorRowCxToRx(row, 3) == 2);
+  CHECK(editorRowCxToRx(row, 6) == 4);
+  CHECK(editorRowRxToCx(row, 3) == 3);
+  CHECK(editorRowRxToCx(row, 4) == 6);
+  CHECK(editorRowNextCx(row, 1) == 3);
+  CHECK(editorRowPrevCx(row, 6) == 3);
+  CHECK(editorRowPrevCx(row, 3) == 1);
+
+  /* A tab after a wide character is expanded by columns, not bytes. */
+  const char *tabbed = "\xe6\xbc\xa2\tx";
+  editorInsertRow(1, tabbed, strlen(tabbed));
+  row = &E.row[1];
+  CHECK(editorRowCxToRx(row, 4) == BYTE_WRITER_TAB_STOP);
+  CHECK(row->rsize == 3 + BYTE_WRITER_TAB_STOP - 2 + 1);
+  CHECK(editorRowRenderToCx(row, row->rsize - 1) == 4);
+
+  int col;
+  CHECK(editorRowRxToRender(row, 1, &col) == 3 && col == 2);
+}
+
+static int onBoundary(const erow *row, int cx) {
+  return cx == row->size || (editorRowCharAt(row, cx) & 0xC0) != 0x80;
+}
+
+/* Moving between rows keeps the display column, so the cursor never
+ * lands inside a multi-byte character. */
+static void testVerticalMoves() {
+  while (E.numrows) editorDelRow(0);
+  const char *lines[] = {
+    "abcdefghij",
+    "\xe6\xbc\xa2\xe5\xad\x97\xe6\xbc\xa2\xe5\xad\x97x",
+    "\xc3\xa9t\xc3\xa9\xc3\xa9\xc3\xa9",
+    "\t\xe6\xbc\xa2y",
+    "ab\xe2\x82\xac\xe2\x82\xac",
+  };
+  for (const char *line : lines) editorInsertRow(E.numrows, line, strlen(line));
+
+  for (int start = 0; start <= 10; start++) {
+    E.cy = 0;
+    E.cx = start;
+    for (int key : {ARROW_DOWN, ARROW_DOWN, ARROW_DOWN, ARROW_DOWN, ARROW_UP,
+                    ARROW_UP, ARROW_UP, ARROW_DOWN, ARROW_UP, ARROW_UP}) {
+      editorMoveCursor(key);
+      CHECK(E.cx <= E.row[E.cy].size);
+      CHECK(onBoundary(&E.row[E.cy], E.cx));
+    }
+  }
+
+  /* Column 3 is the right half of a wide character: the cursor goes to
+   * its start, and comes back to column 2. */
+  E.cy = 0;
+  E.cx = 3;
+  editorMoveCursor(ARROW_DOWN);
+  CHECK(E.cx == 3);
+  editorMoveCursor(ARROW_UP);
+  CHECK(E.cx == 2);
+
+  /* Page keys move by rows the same way; a tab counts as the columns it
+   * fills. */
+  termUseMemory(6, 80);
+  E.screenrows = 2;
+  E.rowoff = 0;
+  E.cy = 0;
+  E.cx = 5;
+  termMemoryPush("\x1b[6~");
+  editorProcessKeypress();
+  CHECK(E.cy == 3 && E.cx == 0);
+  E.cx = 4;
+  termMemoryPush("\x1b[5~");
+  editorProcessKeypress();
+  CHECK(E.cy == 0 && E.cx == 10);
+}
+
+int main() {
+  testValidate();
+  testWidths();
+  testRowColumns();
+  testVerticalMoves();
+  return 0;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Editor.h"
+#include "Row.h"
+#include "Trie.h"
+#include "Words.h"
+#include "check.h"
+
+/* The k most common words of model starting with prefix, ordered as
+ * trieTop orders them. */
+static std::vector<std::string> modelTop(const std::map<std::string, int> &model,
+                                         const std::string &prefix, int k) {
+  std::vector<std::pair<int, std::string>> all;
+  for (const auto &w : model) {
+    if (w.second > 0 && w.first.compare(0, prefix.size(), prefix) == 0)
+      all.push_back({w.second, w.first});
+  }
+  std::sort(all.begin(), all.end(), [](const auto &a, const auto &b) {
+    if (a.first != b.first) return a.first > b.first;
+    if (a.second.size() != b.second.size())
+      return a.second.size() < b.second.size();
+    return a.second < b.second;
+  });
+  std::vector<std::string> out;
+  for (int i = 0; i < (int)all.size() && i < k; i++) out.push_back(all[i].second);
+  return out;
+}
+
+static void testTrie() {
+  static const char *vocab[] = {"a", "ab", "abc", "abd", "b", "ba", "bad",
+                                "badge", "x", "xy", "xyz", "abcdef"};
+  struct trie t;
+  trieInit(&t);
+  std::map<std::string, int> model;
+
+  srand(3);
+  for (int step = 0; step < 20000; step++) {
+    std::string w = vocab[rand() % 12];
+    int delta = rand() % 3 ? 1 : -1;
+    if (delta < 0 && model[w] == 0) continue;
+    model[w] += delta;
+    trieAdd(&t, w.data(), w.size(), delta);
+
+    if (step % 101 == 0) {
+      long long words = 0;
+      for (const auto &m : model) {
+        CHECK(trieCount(&t, m.first.data(), m.first.size()) == m.second);
+        words += m.second > 0;
+      }
+      CHECK(t.words == words);
+      for (const char *prefix : {"", "a", "ab", "abc", "b", "x", "q"}) {
+        std::vector<std::string> got;
+        trieTop(&t, prefix, strlen(prefix), 4, &got);
+        CHECK(got == modelTop(model, prefix, 4));
+      }
+    }
+  }
+
+  /* Emptied nodes are reused rather than leaked. */
+  for (const auto &m : model) trieAdd(&t, m.first.data(), m.first.size(), -m.second);
+  CHECK(t.words == 0 && t.nodes[0].child == 0);
+  size_t nodes = t.nodes.size();
+  for (int i = 0; i < 12; i++) trieAdd(&t, vocab[i], strlen(vocab[i]), 1);
+  CHECK(t.nodes.size() == nodes);
+}
+
+static void setRows(const std::vector<std::string> &lines) {
+  while (E.numrows) editorDelRow(E.numrows - 1);
+  for (const std::string &l : lines) editorInsertRow(E.numrows, l.data(), l.size());
+}
+
+/* Checks the incrementally kept index against one built from scratch. */
+static void checkIndex() {
+  std::vector<std::string> kept, fresh;
+  trieTop(&E.words.index, "", 0, 1 << 20, &kept);
+  long long words = E.words.index.words;
+  std::vector<int> counts;
+  for (const std::string &w : kept)
+    counts.push_back(trieCount(&E.words.index, w.data(), w.size()));
+
+  editorWordsBuild();
+  trieTop(&E.words.index, "", 0, 1 << 20, &fresh);
+  CHECK(kept == fresh);
+  CHECK(words == E.words.index.words);
+  for (size_t i = 0; i < kept.size(); i++)
+    CHECK(trieCount(&E.words.index, kept[i].data(), kept[i].size()) == counts[i]);
+}
+
+static void testIndex() {
+  static const char *tokens[] = {"alpha", "beta", "gamma", "alphabet", "x1",
+                                 "9lives", "_under", "(", ")", " ", ",", "\t"};
+  std::vector<std::string> lines;
+  srand(5);
+  for (int i = 0; i < 200; i++) {
+    std::string l;
+    int n = rand() % 12;
+    for (int j = 0; j < n; j++) l += tokens[rand() % 12];
+    lines.push_back(l);
+  }
+  setRows(lines);
+  editorWordsBuild();
+  CHECK(trieCount(&E.words.index, "9lives", 6) == 0);
+  CHECK(trieCount(&E.words.index, "x1", 2) == 0);
+
+  for (int step = 0; step < 3000; step++) {
+    int at = rand() % E.numrows;
+    erow *row = &E.row[at];
+    switch (rand() % 7) {
+      case 0:
+        editorRowInsertChar(row, rand() % (row->size + 1), "ab( _"[rand() % 5]);
+        break;
+      case 1:
+        if (row->size) editorRowDelChar(row, rand() % row->size);
+        break;
+      case 2: {
+        const char *token = tokens[rand() % 6];
+        editorInsertRow(at, token, strlen(token));
+        break;
+      }
+      case 3:
+        if (E.numrows > 1) editorDelRow(at);
+        break;
+      case 4:
+        if (row->size) editorRowTruncate(row, rand() % row->size);
+        break;
+      case 5:
+        editorRowAppendString(row, "gamma beta", 10);
+        break;
+      case 6: {
+        const char *text = "alpha gamma\nbeta";
+        size_t starts[] = {0, 12}, lens[] = {11, 4};
+        int count = std::min(E.numrows - at, rand() % 3);
+        editorReplaceRows(at, count, text, starts, lens, 2);
+        break;
+      }
+    }
+    if (step % 500 == 0) checkIndex();
+  }
+  checkIndex();
+}
+
+static void testComplete() {
+  setRows({"foobar foobaz foobar", "int fo"});
+  editorWordsFree();
+  E.cy = 1;
+  E.cx = 6;
+  editorComplete();
+  CHECK(E.words.active && E.words.choices.size() == 2);
+  CHECK(std::string(editorRowChars(&E.row[1])) == "int foobar" && E.cx == 10);
+  editorComplete();
+  CHECK(std::string(editorRowChars(&E.row[1])) == "int foobaz" && E.cx == 10);
+  editorComplete();
+  CHECK(std::string(editorRowChars(&E.row[1])) == "int fo" && E.cx == 6);
+  editorComplete();
+  CHECK(std::string(editorRowChars(&E.row[1])) == "int foobar");
+  /* The inserted word is counted like any other. */
+  CHECK(trieCount(&E.words.index, "foobar", 6) == 3);
+
+  E.words.active = 0;
+  E.cx = 4;
+  editorComplete();
+  CHECK(!E.words.active);
+}
+
+static void testLarge() {
+  std::string text;
+  std::vector<size_t> starts, lens;
+  for (int i = 0; i < 2000000; i++) {
+    size_t at = text.size();
+    text += "  value_" + std::to_string(i % 50000) + " = compute(item" +
+            std::to_string(i % 977) + ", total);";
+    starts.push_back(at);
+    lens.push_back(text.size() - at);
+  }
+  while (E.numrows) editorDelRow(E.numrows - 1);
+  editorWordsFree();
+  editorAppendRows(text.data(), starts.data(), lens.data(), starts.size());
+
+  auto start = std::chrono::steady_clock::now();
+  editorWordsBuild();
+  double build = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  std::vector<std::string> found;
+  const int lookups = 1000;
+  for (int i = 0; i < lookups; i++) {
+    found.clear();
+    trieTop(&E.words.index, "val", 3, WORDS_CHOICES, &found);
+  }
+  double lookup = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count() / lookups;
+  CHECK(found.size() == WORDS_CHOICES && found[0] == "value_0");
+  printf("2M lines: %lld words indexed in %.2fs, lookup %.1fus\n",
+         E.words.index.words, build, lookup * 1e6);
+}
+
+int main() {
+  testTrie();
+  testIndex();
+  testComplete();
+  testLarge();
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Editor.h"
+#include "Fenwick.h"
+#include "Row.h"
+#include "Wrap.h"
+#include "check.h"
+
+static void testFenwick() {
+  std::vector<long long> model;
+  struct fenwick fw;
+  fwInit(&fw, NULL, 0);
+
+  srand(7);
+  for (int step = 0; step < 20000; step++) {
+    int op = rand() % 10;
+    if (op < 6 || model.empty()) {
+      int at = rand() % (model.size() + 1);
+      long long v = rand() % 5;
+      model.insert(model.begin() + at, v);
+      fwInsert(&fw, at, v);
+    } else if (op < 8) {
+      int at = rand() % model.size();
+      model.erase(model.begin() + at);
+      fwErase(&fw, at);
+    } else {
+      int at = rand() % model.size();
+      model[at] = rand() % 5;
+      fwSet(&fw, at, model[at]);
+    }
+
+    if (step % 997 == 0) {
+      CHECK(fw.size == (int)model.size());
+      long long sum = 0;
+      for (size_t i = 0; i <= model.size(); i++) {
+        CHECK(fwPrefix(&fw, i) == sum);
+        if (i < model.size()) {
+          CHECK(fwGet(&fw, i) == model[i]);
+          if (model[i] > 0) {
+            int found = fwFind(&fw, sum + model[i] - 1);
+            CHECK(found >= (int)i && fwPrefix(&fw, found) <= sum + model[i] - 1);
+            CHECK(fwPrefix(&fw, found + 1) > sum + model[i] - 1);
+          }
+          sum += model[i];
+        }
+      }
+      CHECK(fw.total == sum);
+      CHECK(fwFind(&fw, sum) == (int)model.size());
+    }
+  }
+}
+
+/* Every character start maps to a (line, column) that maps back to it. */
+static void checkRoundTrip(erow *row, int width) {
+  int lines = editorWrapRowLines(row, width);
+  int prev_sub = 0;
+  for (int cx = 0;; cx = editorRowNextCx(row, cx)) {
+    int rx = editorRowCxToRx(row, cx);
+    int sub, col;
+    editorWrapLocate(row, rx, width, &sub, &col);
+    CHECK(sub >= prev_sub && sub < lines);
+    CHECK(col >= 0 && col < width);
+    CHECK(editorWrapToRx(row, sub, col, width) == rx);
+    prev_sub = sub;
+    if (cx == row->size) break;
+  }
+  CHECK(prev_sub == lines - 1);
+}
+
+static void testRowLines() {
+  while (E.numrows) editorDelRow(0);
+
+  std::string ascii(25, 'x');
+  editorInsertRow(0, ascii.data(), 25);
+  CHECK(editorWrapRowLines(&E.row[0], 10) == 3);
+  CHECK(editorWrapSegment(&E.row[0], 2, 10) == 20);
+  checkRoundTrip(&E.row[0], 10);
+
+  /* A full last line leaves the cursor an empty line after it. */
+  editorInsertRow(1, ascii.data(), 20);
+  CHECK(editorWrapRowLines(&E.row[1], 10) == 3);
+  checkRoundTrip(&E.row[1], 10);
+
+  /* Wide characters never straddle lines: two fit in five columns. */
+  std::string wide;
+  for (int i = 0; i < 6; i++) wide += "\xe6\xbc\xa2";
+  editorInsertRow(2, wide.data(), wide.size());
+  erow *row = &E.row[2];
+  CHECK(editorWrapRowLines(row, 5) == 3);
+  CHECK(editorWrapSegment(row, 1, 5) == 6);
+  checkRoundTrip(row, 5);
+  CHECK(editorWrapToRx(row, 0, 4, 5) == 2);
+
+  std::string mixed = "a\tb\xc3\xa9" + wide + "cd";
+  editorInsertRow(3, mixed.data(), mixed.size());
+  for (int width = 3; width < 20; width++) checkRoundTrip(&E.row[3], width);
+}
+
+static void testLayout() {
+  while (E.numrows) editorDelRow(0);
+  for (int i = 0; i < 3000; i++) {
+    std::string line(i % 37, 'a');
+    if (i % 5 == 0) line += "\xe6\xbc\xa2\xe6\xbc\xa2";
+    editorInsertRow(i, line.data(), line.size());
+  }
+
+  int width = 10;
+  editorWrapBuild(width);
+  srand(11);
+  for (int step = 0; step < 2000; step++) {
+    int at = rand() % E.numrows;
+    switch (rand() % 4) {
+      case 0: editorRowInsertChar(&E.row[at], 0, 'z'); break;
+      case 1: editorRowDelChar(&E.row[at], 0); break;
+      case 2: editorInsertRow(at, "0123456789abc", 13); break;
+      case 3: editorDelRow(at); break;
+    }
+  }
+
+  long long line = 0;
+  for (int i = 0; i < E.numrows; i++) {
+    CHECK(editorWrapLineOf(i) == line);
+    int lines = editorWrapRefine(i);
+    CHECK(lines == editorWrapRowLines(&E.row[i], width));
+    int sub;
+    CHECK(editorWrapRowOf(line + lines - 1, &sub) == i && sub == lines - 1);
+    line += lines;
+  }
+  CHECK(editorWrapTotal() == line);
+
+  /* A screen no wider than the gutter leaves no columns; wrap at one. */
+  editorWrapBuild(0);
+  CHECK(E.layout.width == 1);
+  CHECK(editorWrapLineOf(E.numrows) == editorWrapTotal());
+  editorInsertRow(0, "abc", 3);
+  CHECK(editorWrapRefine(0) == 4);
+
+  editorWrapFree();
+  while (E.numrows) editorDelRow(0);
+}
+
+int main() {
+  testFenwick();
+  testRowLines();
+  testLayout();
+  return 0;
+}